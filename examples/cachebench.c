@@ -17,6 +17,7 @@
 #include <cachercise/cachercise-admin.h>
 #include <cachercise/cachercise-client.h>
 #include <cachercise/cachercise-cache.h>
+#include <cachercise/cachercise-distributed.h>
 
 #define FATAL(...) \
     do { \
@@ -91,6 +92,12 @@ static int parse_json(const char* json_file, struct json_object** json_cfg)
 
     /* set defaults if not present */
     CONFIG_HAS_OR_CREATE(*json_cfg, int, "items_per_process", 100, val);
+    CONFIG_HAS_OR_CREATE(*json_cfg, int, "batch_size", 1, val);
+    CONFIG_HAS_OR_CREATE(*json_cfg, int, "depth", 1, val);
+    CONFIG_HAS_OR_CREATE(*json_cfg, int, "combine_bytes", 0, val);
+    CONFIG_HAS_OR_CREATE(*json_cfg, int, "flush_interval_ms", 10, val);
+    CONFIG_HAS_OR_CREATE(*json_cfg, int, "provider_id", 1, val);
+    CONFIG_HAS_OR_CREATE(*json_cfg, int, "dist_block_size", 1, val);
 
     return (0);
 }
@@ -168,9 +175,8 @@ int main(int argc, char** argv)
     struct json_object* margo_config = NULL;
     struct json_object* json_cfg;
     ssg_group_id_t gid;
-    ssg_member_id_t svr_id;
-    hg_addr_t svr_addr = HG_ADDR_NULL;
-    char * svr_addr_str = NULL;
+    int nservers = 0, s;
+    hg_addr_t *svr_addrs = NULL;
 
     MPI_Init(&argc, &argv);
     MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
@@ -218,26 +224,42 @@ int main(int argc, char** argv)
     if (rank == 0)
         printf("# SSG group refreshed; proceeding with benchmark.\n");
 
-    /* get addr for rank 0 in ssg group */
-    ret = ssg_get_group_member_id_from_rank(gid, 0, &svr_id);
-    if (ret != SSG_SUCCESS) {
-        fprintf(stderr, "Error: ssg_group_member_id_from_rank(): %s.\n",
-                ssg_strerror(ret));
+    /* look up every member of the group: the cache is spread over all of
+     * them */
+    ret = ssg_get_group_size(gid, &nservers);
+    if (ret != SSG_SUCCESS || nservers < 1) {
+        fprintf(stderr, "Error: ssg_get_group_size(): %s.\n", ssg_strerror(ret));
         goto err_ssg_cleanup;
     }
+    svr_addrs = calloc(nservers, sizeof(*svr_addrs));
+    for (s = 0; s < nservers; s++) {
+        ssg_member_id_t svr_id;
+        char * svr_addr_str = NULL;
+        svr_addrs[s] = HG_ADDR_NULL;
+
+        ret = ssg_get_group_member_id_from_rank(gid, s, &svr_id);
+        if (ret != SSG_SUCCESS) {
+            fprintf(stderr, "Error: ssg_group_member_id_from_rank(): %s.\n",
+                    ssg_strerror(ret));
+            goto err_ssg_cleanup;
+        }
 
-    ret = ssg_get_group_member_addr_str(gid, svr_id, &svr_addr_str);
-    if (ret != SSG_SUCCESS) {
-        fprintf(stderr, "Error: ssg_get_group_member_addr_str(): %s.\n",
-                ssg_strerror(ret));
-        goto err_ssg_cleanup;
-    }
+        ret = ssg_get_group_member_addr_str(gid, svr_id, &svr_addr_str);
+        if (ret != SSG_SUCCESS) {
+            fprintf(stderr, "Error: ssg_get_group_member_addr_str(): %s.\n",
+                    ssg_strerror(ret));
+            goto err_ssg_cleanup;
+        }
 
-    ret = margo_addr_lookup(mid, svr_addr_str, &svr_addr);
-    if (ret != HG_SUCCESS) {
-        fprintf(stderr, "Error: margo_addr_lookup()\n");
-        goto err_ssg_cleanup;
+        ret = margo_addr_lookup(mid, svr_addr_str, &svr_addrs[s]);
+        free(svr_addr_str);
+        if (ret != HG_SUCCESS) {
+            fprintf(stderr, "Error: margo_addr_lookup()\n");
+            goto err_ssg_cleanup;
+        }
     }
+    int provider_id = json_object_get_int(
+            json_object_object_get(json_cfg, "provider_id"));
 
     margo_info(mid,"Initializing admin");
     cachercise_admin_t admin;
@@ -246,22 +268,44 @@ int main(int argc, char** argv)
         FATAL(mid,"cachercise_admin_init failed (ret = %d)", ret);
     }
 
-    margo_info(mid,"Creating cache");
-    cachercise_cache_id_t cache_id;
+    margo_info(mid,"Creating caches");
+    cachercise_cache_id_t *cache_ids = malloc(nservers * sizeof(*cache_ids));
     if (rank == 0) {
+        /* backend tunables (e.g. "stripes") are passed through as-is */
+        struct json_object* cache_config = NULL;
+        struct json_object* backend = NULL;
+        const char* cache_config_str = "{}";
+        const char* backend_str = "dummy";
+        if (CONFIG_HAS(json_cfg, "cache", cache_config))
+            cache_config_str = json_object_to_json_string_ext(
+                    cache_config, JSON_C_TO_STRING_PLAIN);
+        if (CONFIG_HAS(json_cfg, "backend", backend))
+            backend_str = json_object_get_string(backend);
 
         /* TODO: can we get the provider id programatically? */
-        ret = cachercise_create_cache(admin, svr_addr, 1, NULL,
-                "dummy", "{}", &cache_id);
-        if(ret != CACHERCISE_SUCCESS) {
-            FATAL(mid,"cachercise_create_cache failed (ret = %d)", ret);
+        for (s = 0; s < nservers; s++) {
+            ret = cachercise_create_cache(admin, svr_addrs[s], provider_id, NULL,
+                    backend_str, cache_config_str, &cache_ids[s]);
+            if(ret != CACHERCISE_SUCCESS) {
+                FATAL(mid,"cachercise_create_cache failed (ret = %d)", ret);
+            }
+        }
+        /* record what the caches run with, backend defaults included */
+        char* reported = NULL;
+        ret = cachercise_get_cache_config(admin, svr_addrs[0], provider_id, NULL,
+                cache_ids[0], &reported);
+        if(ret == CACHERCISE_SUCCESS) {
+            struct json_object* parsed = json_tokener_parse(reported);
+            if (parsed) json_object_object_add(json_cfg, "cache", parsed);
+            free(reported);
         }
     }
-    MPI_Bcast(&cache_id, sizeof(cache_id), MPI_BYTE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(cache_ids, nservers * sizeof(*cache_ids), MPI_BYTE, 0, MPI_COMM_WORLD);
 
 
     cachercise_client_t cachercise_clt;
-    cachercise_cache_handle_t cachercise_rh;
+    cachercise_cache_handle_t *member_rhs = malloc(nservers * sizeof(*member_rhs));
+    cachercise_dist_handle_t cachercise_rh;
 
     margo_info(mid, "Creating CACHERCISE client");
     ret = cachercise_client_init(mid, &cachercise_clt);
@@ -269,25 +313,86 @@ int main(int argc, char** argv)
         FATAL(mid,"cachercise_client_init failed (ret = %d)", ret);
     }
 
-    margo_info(mid, "Creating cache handle");
-    // again, need provider id
-    ret = cachercise_cache_handle_create(
-            cachercise_clt, svr_addr, 1,
-            cache_id, &cachercise_rh);
+    /* "combine_bytes" > 0 buffers small writes in the handle */
+    ret = cachercise_client_set_write_combining(cachercise_clt,
+            json_object_get_int(json_object_object_get(json_cfg, "combine_bytes")),
+            json_object_get_int(json_object_object_get(json_cfg, "flush_interval_ms")));
+    if(ret != CACHERCISE_SUCCESS) {
+        FATAL(mid,"cachercise_client_set_write_combining failed (ret = %d)", ret);
+    }
+
+    margo_info(mid, "Creating cache handles");
+    for (s = 0; s < nservers; s++) {
+        ret = cachercise_cache_handle_create(
+                cachercise_clt, svr_addrs[s], provider_id,
+                cache_ids[s], &member_rhs[s]);
+        if(ret != CACHERCISE_SUCCESS) {
+            FATAL(mid,"cachercise_cache_handle_create failed (ret = %d)", ret);
+        }
+    }
+    /* offsets are dealt out over the servers in blocks of "dist_block_size" */
+    ret = cachercise_dist_handle_create(member_rhs, nservers,
+            json_object_get_int(json_object_object_get(json_cfg, "dist_block_size")),
+            &cachercise_rh);
     if(ret != CACHERCISE_SUCCESS) {
-        FATAL(mid,"cachercise_cache_handle_create failed (ret = %d)", ret);
+        FATAL(mid,"cachercise_dist_handle_create failed (ret = %d)", ret);
     }
 
     int nr_items = json_object_get_int(
             json_object_object_get(json_cfg, "items_per_process"));
 
+    /* "batch_size" > 1 sends that many updates per RPC */
+    int batch_size = json_object_get_int(
+            json_object_object_get(json_cfg, "batch_size"));
+    int64_t *batch_offsets = malloc(batch_size * sizeof(int64_t));
+    int64_t *batch_values = malloc(batch_size * sizeof(int64_t));
+
+    /* "depth" > 1 keeps that many asynchronous writes outstanding */
+    int depth = json_object_get_int(
+            json_object_object_get(json_cfg, "depth"));
+    cachercise_request_t *reqs = malloc(depth * sizeof(*reqs));
+    int64_t *depth_values = malloc(depth * sizeof(int64_t));
+
     double duration = MPI_Wtime();
     int i;
-    for (i=0; i< nr_items; i++ ) {
-        int64_t value=i*nprocs+rank+100;
-        ret = cachercise_write(cachercise_rh, &value, sizeof(value), i*nprocs+rank);
+    if (batch_size > 1) {
+        for (i=0; i< nr_items; ) {
+            int n;
+            for (n = 0; n < batch_size && i < nr_items; n++, i++) {
+                batch_offsets[n] = i*nprocs+rank;
+                batch_values[n] = i*nprocs+rank+100;
+            }
+            ret = cachercise_dist_io_batch(cachercise_rh, batch_offsets,
+                    batch_values, n, CACHERCISE_WRITE);
+        }
+    } else if (depth > 1) {
+        /* keep up to "depth" writes in flight, recycling the oldest slot */
+        for (i=0; i< nr_items; i++ ) {
+            int slot = i % depth;
+            if (i >= depth)
+                ret = cachercise_wait(reqs[slot]);
+            cachercise_cache_handle_t member;
+            int64_t local;
+            cachercise_dist_locate(cachercise_rh, i*nprocs+rank, &member, &local);
+            depth_values[slot] = i*nprocs+rank+100;
+            ret = cachercise_io_async(member, &depth_values[slot],
+                    sizeof(int64_t), local, CACHERCISE_WRITE, &reqs[slot]);
+        }
+        for (int n = 0; n < depth && n < nr_items; n++)
+            ret = cachercise_wait(reqs[n]);
+    } else {
+        for (i=0; i< nr_items; i++ ) {
+            int64_t value=i*nprocs+rank+100;
+            ret = cachercise_dist_io(cachercise_rh, &value, sizeof(value),
+                    i*nprocs+rank, CACHERCISE_WRITE);
+        }
     }
+    ret = cachercise_dist_flush(cachercise_rh);
     duration = MPI_Wtime() - duration;
+    free(batch_offsets);
+    free(batch_values);
+    free(reqs);
+    free(depth_values);
 
     double min_duration, max_duration, sum_duration;
     MPI_Reduce(&duration, &max_duration, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
@@ -307,7 +412,8 @@ int main(int argc, char** argv)
     if (rank == 0) {
         int64_t compare=-9999;
         for (j=0; j < i*nprocs; j++) {
-            ret = cachercise_read(cachercise_rh, &compare, sizeof(compare), j );
+            ret = cachercise_dist_io(cachercise_rh, &compare, sizeof(compare),
+                    j, CACHERCISE_READ);
             if (compare != j+100) {
                 nerrors++;
                 printf("expected %ld got %ld\n", j+100, compare);
@@ -317,13 +423,21 @@ int main(int argc, char** argv)
     }
 
     if (rank == 0)
-        dump_json(mid, cachercise_rh, json_cfg);
+        dump_json(mid, member_rhs[0], json_cfg);
 
-    margo_info(mid, "Releasing cache handle");
-    ret = cachercise_cache_handle_release(cachercise_rh);
+    margo_info(mid, "Releasing cache handles");
+    ret = cachercise_dist_handle_release(cachercise_rh);
     if(ret != CACHERCISE_SUCCESS) {
-        FATAL(mid,"cachercise_cache_handle_release failed (ret = %d)", ret);
+        FATAL(mid,"cachercise_dist_handle_release failed (ret = %d)", ret);
+    }
+    for (s = 0; s < nservers; s++) {
+        ret = cachercise_cache_handle_release(member_rhs[s]);
+        if(ret != CACHERCISE_SUCCESS) {
+            FATAL(mid,"cachercise_cache_handle_release failed (ret = %d)", ret);
+        }
     }
+    free(member_rhs);
+    free(cache_ids);
 
     margo_info(mid, "Finalizing client");
     ret = cachercise_client_finalize(cachercise_clt);
@@ -339,10 +453,11 @@ int main(int argc, char** argv)
 
 
 err_ssg_cleanup:
-    if (svr_addr_str) free(svr_addr_str);
     ssg_finalize();
 err_margo_cleanup:
-    if (svr_addr != HG_ADDR_NULL) margo_addr_free(mid, svr_addr);
+    for (s = 0; s < nservers && svr_addrs; s++)
+        if (svr_addrs[s] != HG_ADDR_NULL) margo_addr_free(mid, svr_addrs[s]);
+    free(svr_addrs);
     margo_finalize(mid);
 err_mpi_cleanup:
     if (json_cfg) json_object_put(json_cfg);
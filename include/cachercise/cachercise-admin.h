@@ -138,4 +138,25 @@ cachercise_return_t cachercise_list_caches(
         cachercise_cache_id_t* ids,
         size_t* count);
 
+/**
+ * @brief Retrieves the configuration a cache runs with, including the
+ * defaults the backend filled in (e.g. the dummy backend's "sync").
+ *
+ * @param[in] admin CACHERCISE admin object.
+ * @param[in] address address of the provider.
+ * @param[in] provider_id provider id.
+ * @param[in] token security token.
+ * @param[in] id cache id.
+ * @param[out] config JSON string, to be freed by the caller.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_get_cache_config(
+        cachercise_admin_t admin,
+        hg_addr_t address,
+        uint16_t provider_id,
+        const char* token,
+        cachercise_cache_id_t id,
+        char** config);
+
 #endif
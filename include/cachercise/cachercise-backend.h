@@ -13,6 +13,12 @@ typedef cachercise_return_t (*cachercise_backend_create_fn)(cachercise_provider_
 typedef cachercise_return_t (*cachercise_backend_open_fn)(cachercise_provider_t, const char*, void**);
 typedef cachercise_return_t (*cachercise_backend_close_fn)(void*);
 typedef cachercise_return_t (*cachercise_backend_destroy_fn)(void*);
+typedef char* (*cachercise_backend_get_config_fn)(void*);
+typedef size_t (*cachercise_backend_element_size_fn)(void*);
+
+/* returned by blob_get, blob_erase, kv_get and kv_erase for a key that
+ * holds no value */
+#define CACHERCISE_BACKEND_NOT_FOUND (-2)
 
 /**
  * @brief Implementation of an CACHERCISE backend.
@@ -25,11 +31,43 @@ typedef struct cachercise_backend_impl {
     cachercise_backend_open_fn     open_cache;
     cachercise_backend_close_fn    close_cache;
     cachercise_backend_destroy_fn  destroy_cache;
+    // the configuration the cache runs with, defaults filled in, as a
+    // JSON string for the caller to free
+    cachercise_backend_get_config_fn get_config;
+    // bytes per element, in which io counts offsets and returns what it
+    // moved; NULL means sizeof(int64_t)
+    cachercise_backend_element_size_fn element_size;
     // RPC functions
     void (*hello)(void*);
     int32_t (*sum)(void*, int32_t, int32_t);
     // ... add other functions here
     int64_t (*io)(void*, uint64_t, int64_t, int64_t*, int);
+    // batched io: count offsets, count values; returns number of values
+    // moved or a negative value on error
+    int64_t (*io_batch)(void*, size_t, const int64_t*, int64_t*, int);
+    // atomic ops: op, count, offsets, operands, compares (CAS only, else
+    // NULL), and where to put the old values; returns count or a negative
+    // value on error
+    int64_t (*atomic)(void*, int, size_t, const int64_t*, const int64_t*,
+            const int64_t*, int64_t*);
+    // the first run of populated (ever written) offsets in [offset, end):
+    // sets *start and returns the run's length, at most max, 0 if there
+    // is none or a negative value on error.  How finely "populated" is
+    // tracked is up to the backend (the dummy's is per page).  NULL if the
+    // backend cannot tell.
+    int64_t (*populated)(void*, int64_t, int64_t, uint64_t, int64_t*);
+    // variable-length values by key: blob_put stores size bytes and
+    // returns size; blob_get copies at most size bytes into the buffer and
+    // returns the value's whole length; blob_erase returns 0.  All return a
+    // negative value on error, CACHERCISE_BACKEND_NOT_FOUND for a key with
+    // no value.  Backends without them leave them NULL.
+    int64_t (*blob_put)(void*, uint64_t, const void*, size_t);
+    int64_t (*blob_get)(void*, uint64_t, void*, size_t);
+    int64_t (*blob_erase)(void*, uint64_t);
+    // the same by byte-string key: key, key size, then as above
+    int64_t (*kv_put)(void*, const void*, size_t, const void*, size_t);
+    int64_t (*kv_get)(void*, const void*, size_t, void*, size_t);
+    int64_t (*kv_erase)(void*, const void*, size_t);
 
 } cachercise_backend_impl;
 
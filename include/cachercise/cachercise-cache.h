@@ -17,6 +17,11 @@ extern "C" {
 typedef struct cachercise_cache_handle *cachercise_cache_handle_t;
 #define CACHERCISE_CACHE_HANDLE_NULL ((cachercise_cache_handle_t)NULL)
 
+typedef struct cachercise_request *cachercise_request_t;
+#define CACHERCISE_REQUEST_NULL ((cachercise_request_t)NULL)
+typedef struct cachercise_scan *cachercise_scan_t;
+#define CACHERCISE_SCAN_NULL ((cachercise_scan_t)NULL)
+
 /**
  * @brief Creates a CACHERCISE cache handle.
  *
@@ -84,6 +89,21 @@ cachercise_return_t cachercise_compute_sum(
         int32_t y,
         int32_t* result);
 
+/**
+ * @brief Reads or writes count bytes (a whole number of the cache's
+ * elements: int64 values unless its config picks another type) starting at
+ * element offset.  Up to the client's bulk threshold the data
+ * travels inline in the RPC; above it, the provider pulls or pushes it with
+ * RDMA.
+ *
+ * @param[in] handle cache handle.
+ * @param[inout] buf data to write, or buffer to read into.
+ * @param[in] count size of buf in bytes.
+ * @param[in] offset offset (in elements) of the first value.
+ * @param[in] kind CACHERCISE_WRITE or CACHERCISE_READ.
+ *
+ * @return number of bytes moved, or error code defined in cachercise-common.h
+ */
 #define cachercise_read(h, b, c, o) cachercise_io((h), (b), (c), (o), CACHERCISE_READ);
 #define cachercise_write(h, b, c, o) cachercise_io((h), (b), (c), (o), CACHERCISE_WRITE);
 cachercise_return_t cachercise_io(
@@ -92,6 +112,377 @@ cachercise_return_t cachercise_io(
         uint64_t count,
         int64_t offset,
         int kind);
+
+/**
+ * @brief Starts the same transfer as cachercise_io without waiting for it.
+ * buf must stay valid, and the handle alive, until the request completes.
+ * Every request must eventually be passed to cachercise_wait.
+ *
+ * @param[in] handle cache handle.
+ * @param[inout] buf data to write, or buffer to read into.
+ * @param[in] count size of buf in bytes.
+ * @param[in] offset offset (in elements) of the first value.
+ * @param[in] kind CACHERCISE_WRITE or CACHERCISE_READ.
+ * @param[out] req request to test or wait on.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_io_async(
+        cachercise_cache_handle_t handle,
+        void *buf,
+        uint64_t count,
+        int64_t offset,
+        int kind,
+        cachercise_request_t* req);
+
+/**
+ * @brief Checks, without blocking, whether a request has completed.
+ *
+ * @param[in] req request from cachercise_io_async.
+ * @param[out] flag set to 1 if the request completed, 0 otherwise.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_test(
+        cachercise_request_t req,
+        int* flag);
+
+/**
+ * @brief Waits for a request to complete and releases it.
+ *
+ * @param[in] req request from cachercise_io_async.
+ *
+ * @return what cachercise_io would have returned for the same transfer
+ */
+cachercise_return_t cachercise_wait(cachercise_request_t req);
+
+/**
+ * @brief Reads or writes many individual int64 values in a single RPC.
+ * The provider applies the whole batch at once, so a batch of n values
+ * costs one round trip instead of n.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] offsets array of count offsets (in elements).
+ * @param[inout] values array of count values: written from (CACHERCISE_WRITE)
+ * or read into (CACHERCISE_READ).
+ * @param[in] count number of offset/value pairs.
+ * @param[in] kind CACHERCISE_WRITE or CACHERCISE_READ.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_io_batch(
+        cachercise_cache_handle_t handle,
+        const int64_t *offsets,
+        int64_t *values,
+        size_t count,
+        int kind);
+
+/**
+ * @brief Starts the same batch as cachercise_io_batch without waiting for
+ * it.  offsets may be reused as soon as this returns; values must stay valid
+ * until the request completes.  cachercise_wait returns CACHERCISE_SUCCESS
+ * or an error code.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] offsets array of count offsets (in elements).
+ * @param[inout] values array of count values.
+ * @param[in] count number of offset/value pairs.
+ * @param[in] kind CACHERCISE_WRITE or CACHERCISE_READ.
+ * @param[out] req request to test or wait on.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_io_batch_async(
+        cachercise_cache_handle_t handle,
+        const int64_t *offsets,
+        int64_t *values,
+        size_t count,
+        int kind,
+        cachercise_request_t* req);
+/**
+ * @brief Applies a read-modify-write operation to one int64 slot, atomically
+ * on the provider, and returns the value the slot held before.  Use it for
+ * counters and flags instead of a read followed by a write.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] op one of the CACHERCISE_ATOMIC_* operations.
+ * @param[in] offset offset (in elements) of the slot.
+ * @param[in] operand value to add, store, or compare against (min/max).
+ * @param[in] compare expected value (CACHERCISE_ATOMIC_CAS only).
+ * @param[out] old value of the slot before the operation (may be NULL).
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_atomic(
+        cachercise_cache_handle_t handle,
+        int op,
+        int64_t offset,
+        int64_t operand,
+        int64_t compare,
+        int64_t* old);
+
+/**
+ * @brief Applies the same operation to many slots in a single RPC.  Each
+ * operation is atomic on its own; operations on the same offset take effect
+ * in batch order.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] op one of the CACHERCISE_ATOMIC_* operations.
+ * @param[in] offsets array of count offsets (in elements).
+ * @param[in] operands array of count operands.
+ * @param[in] compares array of count expected values (CAS only, else NULL).
+ * @param[out] olds array of count previous values (may be NULL).
+ * @param[in] count number of operations.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_atomic_batch(
+        cachercise_cache_handle_t handle,
+        int op,
+        const int64_t *offsets,
+        const int64_t *operands,
+        const int64_t *compares,
+        int64_t *olds,
+        size_t count);
+
+/**
+ * @brief Stores size bytes under key, replacing whatever value the key had,
+ * in a cache whose backend holds variable-length values (e.g. "slab").
+ * The bytes always travel by bulk transfer.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] key key of the value.
+ * @param[in] data bytes to store.
+ * @param[in] size number of bytes (at most 1 MiB for "slab").
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_blob_put(
+        cachercise_cache_handle_t handle,
+        uint64_t key,
+        const void* data,
+        size_t size);
+
+/**
+ * @brief Reads the value stored under key into buf, copying at most
+ * capacity bytes, and sets *size to the value's whole length: a caller that
+ * made too little room (possibly none) can retry with enough.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] key key of the value.
+ * @param[out] buf where to copy the value.
+ * @param[in] capacity size of buf in bytes.
+ * @param[out] size length of the value (may be NULL).
+ *
+ * @return CACHERCISE_SUCCESS, CACHERCISE_ERR_NOT_FOUND if the key has no
+ * value, or another error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_blob_get(
+        cachercise_cache_handle_t handle,
+        uint64_t key,
+        void* buf,
+        size_t capacity,
+        size_t* size);
+
+/**
+ * @brief Removes the value stored under key.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] key key of the value.
+ *
+ * @return CACHERCISE_SUCCESS, CACHERCISE_ERR_NOT_FOUND if the key has no
+ * value, or another error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_blob_erase(
+        cachercise_cache_handle_t handle,
+        uint64_t key);
+
+/* value_sizes entry of cachercise_kv_get_multi for a key with no value */
+#define CACHERCISE_KV_ABSENT ((size_t)-1)
+
+/**
+ * @brief Stores value_size bytes under a byte-string key, replacing
+ * whatever value the key had, in a cache whose backend is keyed by name
+ * (e.g. "kv").
+ *
+ * @param[in] handle cache handle.
+ * @param[in] key key bytes.
+ * @param[in] key_size number of key bytes.
+ * @param[in] value bytes to store.
+ * @param[in] value_size number of bytes.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_kv_put(
+        cachercise_cache_handle_t handle,
+        const void* key,
+        size_t key_size,
+        const void* value,
+        size_t value_size);
+
+/**
+ * @brief Reads the value stored under a byte-string key into buf, copying
+ * at most capacity bytes, and sets *size to the value's whole length.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] key key bytes.
+ * @param[in] key_size number of key bytes.
+ * @param[out] buf where to copy the value.
+ * @param[in] capacity size of buf in bytes.
+ * @param[out] size length of the value (may be NULL).
+ *
+ * @return CACHERCISE_SUCCESS, CACHERCISE_ERR_NOT_FOUND if the key has no
+ * value, or another error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_kv_get(
+        cachercise_cache_handle_t handle,
+        const void* key,
+        size_t key_size,
+        void* buf,
+        size_t capacity,
+        size_t* size);
+
+/**
+ * @brief Removes the value stored under a byte-string key.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] key key bytes.
+ * @param[in] key_size number of key bytes.
+ *
+ * @return CACHERCISE_SUCCESS, CACHERCISE_ERR_NOT_FOUND if the key has no
+ * value, or another error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_kv_erase(
+        cachercise_cache_handle_t handle,
+        const void* key,
+        size_t key_size);
+
+/**
+ * @brief Stores count values, as cachercise_kv_put, in one RPC: keys,
+ * values and their sizes travel together in a single bulk transfer of at
+ * most 4 MiB (8 bytes of header per pair, each pair padded to 8 bytes).
+ * If a later pair has the same key as an earlier one, it wins.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] count number of pairs.
+ * @param[in] keys key of each pair.
+ * @param[in] key_sizes key size of each pair.
+ * @param[in] values value of each pair.
+ * @param[in] value_sizes value size of each pair.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_kv_put_multi(
+        cachercise_cache_handle_t handle,
+        size_t count,
+        const void* const* keys,
+        const size_t* key_sizes,
+        const void* const* values,
+        const size_t* value_sizes);
+
+/**
+ * @brief Reads count values, as cachercise_kv_get, in one RPC: the keys
+ * go over in one bulk transfer and the values come back in another, the
+ * two together at most 4 MiB (counting each capacity, padded to 8 bytes,
+ * and 8 bytes per key).  A key with no value is not an error: its
+ * value_sizes entry is CACHERCISE_KV_ABSENT.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] count number of keys.
+ * @param[in] keys keys to read.
+ * @param[in] key_sizes size of each key.
+ * @param[out] bufs where to copy each value.
+ * @param[in] capacities size of each buffer.
+ * @param[out] value_sizes length of each value, or CACHERCISE_KV_ABSENT.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_kv_get_multi(
+        cachercise_cache_handle_t handle,
+        size_t count,
+        const void* const* keys,
+        const size_t* key_sizes,
+        void* const* bufs,
+        const size_t* capacities,
+        size_t* value_sizes);
+
+/**
+ * @brief Opens a scan over the elements in [start, end).  The provider
+ * streams them back in chunks of at most chunk_size bytes, each one a
+ * series of extents (an offset, then the values of consecutive elements
+ * from it); the next chunk is already on its way while the caller goes
+ * through the current one.  With CACHERCISE_SCAN_POPULATED the extents
+ * leave out offsets that were never written, which the provider skips
+ * without reading them.  The scan sees each element as it is when its
+ * chunk is read, not as of the call.
+ *
+ * @param[in] handle cache handle.
+ * @param[in] start first element offset.
+ * @param[in] end element offset past the last.
+ * @param[in] flags 0 or CACHERCISE_SCAN_POPULATED.
+ * @param[in] chunk_size bytes per chunk, 0 for 1 MiB (at most 4 MiB).
+ * @param[out] scan resulting scan.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_scan_open(
+        cachercise_cache_handle_t handle,
+        int64_t start,
+        int64_t end,
+        int flags,
+        size_t chunk_size,
+        cachercise_scan_t* scan);
+
+/**
+ * @brief Returns the next extent of a scan.  data stays valid until the
+ * next call on the scan.
+ *
+ * @param[in] scan scan.
+ * @param[out] offset offset of the extent's first element.
+ * @param[out] data values of the extent's elements.
+ * @param[out] size bytes in data, 0 once the scan is done.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_scan_next(
+        cachercise_scan_t scan,
+        int64_t* offset,
+        const void** data,
+        size_t* size);
+
+/**
+ * @brief Where the scan stands: every element before the cursor has been
+ * returned by cachercise_scan_next, and a scan opened from the cursor
+ * picks up with the ones that have not.
+ *
+ * @param[in] scan scan.
+ * @param[out] cursor element offset.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_scan_cursor(
+        cachercise_scan_t scan,
+        int64_t* cursor);
+
+/**
+ * @brief Closes a scan, waiting for a chunk still on its way if need be.
+ *
+ * @param[in] scan scan.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_scan_close(cachercise_scan_t scan);
+
+/**
+ * @brief Sends any writes buffered in the handle (see
+ * cachercise_client_set_write_combining).  Also reports an error from an
+ * earlier background flush, if there was one.
+ *
+ * @param[in] handle cache handle.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_flush(cachercise_cache_handle_t handle);
 #ifdef __cplusplus
 }
 #endif
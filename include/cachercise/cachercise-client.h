@@ -35,6 +35,44 @@ cachercise_return_t cachercise_client_init(margo_instance_id mid, cachercise_cli
  */
 cachercise_return_t cachercise_client_finalize(cachercise_client_t client);
 
+/* io requests larger than this many bytes move through RDMA (bulk) rather
+ * than inline in the RPC */
+#define CACHERCISE_DEFAULT_BULK_THRESHOLD 2048
+
+/**
+ * @brief Sets the size above which cachercise_io transfers its data with
+ * bulk (RDMA) operations instead of carrying it in the RPC itself.
+ *
+ * @param[in] client CACHERCISE client
+ * @param[in] threshold size in bytes
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_client_set_bulk_threshold(
+        cachercise_client_t client,
+        size_t threshold);
+
+/**
+ * @brief Makes cache handles created from now on combine small writes:
+ * writes of up to max_bytes are buffered in the handle, adjacent and
+ * overlapping ones merged, and the buffer sent in a few large RPCs once it
+ * holds max_bytes, once its oldest write is flush_interval_ms old, or on
+ * cachercise_flush.  Reads and non-combined writes through the handle flush
+ * it first.  A max_bytes of 0 turns combining off.  Merging assumes
+ * 8-byte elements: do not combine writes to caches of other types.
+ *
+ * @param[in] client CACHERCISE client
+ * @param[in] max_bytes size of each handle's buffer
+ * @param[in] flush_interval_ms age at which buffered writes are sent in the
+ * background (0: only on size or explicit flush)
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_client_set_write_combining(
+        cachercise_client_t client,
+        size_t max_bytes,
+        unsigned flush_interval_ms);
+
 #ifdef __cplusplus
 }
 #endif
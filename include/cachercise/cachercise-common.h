@@ -29,13 +29,33 @@ typedef enum cachercise_return_t {
     CACHERCISE_ERR_FROM_ARGOBOTS,     /* Argobots error */
     CACHERCISE_ERR_OP_UNSUPPORTED,    /* Unsupported operation */
     CACHERCISE_ERR_OP_FORBIDDEN,      /* Forbidden operation */
+    CACHERCISE_ERR_NOT_FOUND,         /* No value for this key */
     /* ... TODO add more error codes here if needed */
     CACHERCISE_ERR_OTHER              /* Other error */
 } cachercise_return_t;
 
 enum {
  CACHERCISE_WRITE,
- CACHERCISE_READ
+ CACHERCISE_READ,
+ CACHERCISE_ERASE  /* blobs only */
+};
+
+/**
+ * @brief Read-modify-write operations for cachercise_atomic.
+ */
+enum {
+ CACHERCISE_ATOMIC_ADD,   /* fetch-and-add */
+ CACHERCISE_ATOMIC_SWAP,  /* store the operand */
+ CACHERCISE_ATOMIC_CAS,   /* store the operand if the slot equals compare */
+ CACHERCISE_ATOMIC_MIN,   /* store the operand if it is smaller */
+ CACHERCISE_ATOMIC_MAX    /* store the operand if it is larger */
+};
+
+/**
+ * @brief Flags for cachercise_scan_open.
+ */
+enum {
+ CACHERCISE_SCAN_POPULATED = 1  /* skip offsets that were never written */
 };
 
 
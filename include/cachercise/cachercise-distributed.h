@@ -0,0 +1,127 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CACHERCISE_DISTRIBUTED_H
+#define __CACHERCISE_DISTRIBUTED_H
+
+#include <margo.h>
+#include <cachercise/cachercise-common.h>
+#include <cachercise/cachercise-cache.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A distributed handle spreads one offset space over several caches (say
+ * one per member of an SSG group): blocks of block_size consecutive elements
+ * go round-robin to the members, and each member stores its blocks densely
+ * from its own offset 0. */
+typedef struct cachercise_dist_handle *cachercise_dist_handle_t;
+#define CACHERCISE_DIST_HANDLE_NULL ((cachercise_dist_handle_t)NULL)
+
+/**
+ * @brief Creates a distributed handle over existing cache handles.  The
+ * distributed handle takes its own reference on each of them.  The member
+ * caches hold int64 values; see cachercise_dist_handle_create_typed for
+ * other element types.
+ *
+ * @param[in] members array of cache handles, one per member cache.
+ * @param[in] num_members number of handles in members.
+ * @param[in] block_size number of consecutive elements per member block.
+ * @param[out] handle distributed handle.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_dist_handle_create(
+        const cachercise_cache_handle_t* members,
+        size_t num_members,
+        size_t block_size,
+        cachercise_dist_handle_t* handle);
+
+/**
+ * @brief Same as cachercise_dist_handle_create, for member caches whose
+ * elements are element_size bytes (their "type" config).  All members must
+ * have the same type.  cachercise_dist_io_batch only works with 8-byte
+ * elements, like cachercise_io_batch.
+ *
+ * @param[in] members array of cache handles, one per member cache.
+ * @param[in] num_members number of handles in members.
+ * @param[in] block_size number of consecutive elements per member block.
+ * @param[in] element_size bytes per element.
+ * @param[out] handle distributed handle.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_dist_handle_create_typed(
+        const cachercise_cache_handle_t* members,
+        size_t num_members,
+        size_t block_size,
+        size_t element_size,
+        cachercise_dist_handle_t* handle);
+
+/**
+ * @brief Releases a distributed handle and its references on the members.
+ *
+ * @param[in] handle distributed handle.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_dist_handle_release(cachercise_dist_handle_t handle);
+
+/**
+ * @brief Finds the member cache holding a given offset.
+ *
+ * @param[in] handle distributed handle.
+ * @param[in] offset offset (in elements) in the distributed space.
+ * @param[out] member cache handle of the member (not an extra reference).
+ * @param[out] local the offset within that member's cache.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_dist_locate(
+        cachercise_dist_handle_t handle,
+        int64_t offset,
+        cachercise_cache_handle_t* member,
+        int64_t* local);
+
+/**
+ * @brief Same as cachercise_io, over the distributed space.  The range is
+ * split at block boundaries and all pieces are in flight at once.  count
+ * must be a whole number of elements.
+ *
+ * @return number of bytes moved, or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_dist_io(
+        cachercise_dist_handle_t handle,
+        void *buf,
+        uint64_t count,
+        int64_t offset,
+        int kind);
+
+/**
+ * @brief Same as cachercise_io_batch, over the distributed space.  The batch
+ * is split into one batch per member and all of them are in flight at once.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_dist_io_batch(
+        cachercise_dist_handle_t handle,
+        const int64_t *offsets,
+        int64_t *values,
+        size_t count,
+        int kind);
+
+/**
+ * @brief Flushes the write-combining buffers of all members.
+ *
+ * @return CACHERCISE_SUCCESS or error code defined in cachercise-common.h
+ */
+cachercise_return_t cachercise_dist_flush(cachercise_dist_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -24,6 +24,7 @@ cachercise_return_t cachercise_admin_init(margo_instance_id mid, cachercise_admi
         margo_registered_name(mid, "cachercise_close_cache", &a->close_cache_id, &flag);
         margo_registered_name(mid, "cachercise_destroy_cache", &a->destroy_cache_id, &flag);
         margo_registered_name(mid, "cachercise_list_caches", &a->list_caches_id, &flag);
+        margo_registered_name(mid, "cachercise_get_cache_config", &a->get_cache_config_id, &flag);
         /* Get more existing RPCs... */
     } else {
         a->create_cache_id =
@@ -41,6 +42,9 @@ cachercise_return_t cachercise_admin_init(margo_instance_id mid, cachercise_admi
         a->list_caches_id =
             MARGO_REGISTER(mid, "cachercise_list_caches",
             list_caches_in_t, list_caches_out_t, NULL);
+        a->get_cache_config_id =
+            MARGO_REGISTER(mid, "cachercise_get_cache_config",
+            get_cache_config_in_t, get_cache_config_out_t, NULL);
         /* Register more RPCs ... */
     }
 
@@ -275,3 +279,47 @@ cachercise_return_t cachercise_list_caches(
     margo_destroy(h);
     return ret;
 }
+
+cachercise_return_t cachercise_get_cache_config(
+        cachercise_admin_t admin,
+        hg_addr_t address,
+        uint16_t provider_id,
+        const char* token,
+        cachercise_cache_id_t id,
+        char** config)
+{
+    hg_handle_t h;
+    get_cache_config_in_t  in;
+    get_cache_config_out_t out;
+    cachercise_return_t ret;
+    hg_return_t hret;
+
+    memcpy(&in.id, &id, sizeof(id));
+    in.token  = (char*)token;
+
+    hret = margo_create(admin->mid, address, admin->get_cache_config_id, &h);
+    if(hret != HG_SUCCESS)
+        return CACHERCISE_ERR_FROM_MERCURY;
+
+    hret = margo_provider_forward(provider_id, h, &in);
+    if(hret != HG_SUCCESS) {
+        margo_destroy(h);
+        return CACHERCISE_ERR_FROM_MERCURY;
+    }
+
+    hret = margo_get_output(h, &out);
+    if(hret != HG_SUCCESS) {
+        margo_destroy(h);
+        return CACHERCISE_ERR_FROM_MERCURY;
+    }
+
+    ret = out.ret;
+    if(ret == CACHERCISE_SUCCESS) {
+        *config = strdup(out.config);
+        if(!*config) ret = CACHERCISE_ERR_ALLOCATION;
+    }
+
+    margo_free_output(h, &out);
+    margo_destroy(h);
+    return ret;
+}
@@ -16,6 +16,7 @@ typedef struct cachercise_admin {
    hg_id_t           close_cache_id;
    hg_id_t           destroy_cache_id;
    hg_id_t           list_caches_id;
+   hg_id_t           get_cache_config_id;
 } cachercise_admin;
 
 #endif
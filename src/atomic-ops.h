@@ -0,0 +1,62 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef _ATOMIC_OPS_H
+#define _ATOMIC_OPS_H
+
+#include <stdint.h>
+#include "cachercise/cachercise-common.h"
+
+/* The CACHERCISE_ATOMIC_* read-modify-write operations on a plain int64
+ * slot, with compiler atomics.  Relaxed ordering is all they need: each one
+ * is atomic on its own slot, which is the only promise made to clients.
+ * Both return the value the slot held before. */
+
+static inline int cachercise_atomic_op_valid(int64_t op)
+{
+    return op >= CACHERCISE_ATOMIC_ADD && op <= CACHERCISE_ATOMIC_MAX;
+}
+
+static inline int64_t cachercise_atomic_apply(int64_t* slot, int op,
+        int64_t operand, int64_t compare)
+{
+    int64_t old;
+    switch (op) {
+    case CACHERCISE_ATOMIC_ADD:
+        return __atomic_fetch_add(slot, operand, __ATOMIC_RELAXED);
+    case CACHERCISE_ATOMIC_SWAP:
+        return __atomic_exchange_n(slot, operand, __ATOMIC_RELAXED);
+    case CACHERCISE_ATOMIC_CAS:
+        old = compare;
+        __atomic_compare_exchange_n(slot, &old, operand, 0,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        return old;
+    case CACHERCISE_ATOMIC_MIN:
+        old = __atomic_load_n(slot, __ATOMIC_RELAXED);
+        while (operand < old && !__atomic_compare_exchange_n(slot, &old, operand, 1,
+                    __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+        return old;
+    default: /* CACHERCISE_ATOMIC_MAX */
+        old = __atomic_load_n(slot, __ATOMIC_RELAXED);
+        while (operand > old && !__atomic_compare_exchange_n(slot, &old, operand, 1,
+                    __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+        return old;
+    }
+}
+
+/* the value an operation left in a slot that held old */
+static inline int64_t cachercise_atomic_result(int op, int64_t old,
+        int64_t operand, int64_t compare)
+{
+    switch (op) {
+    case CACHERCISE_ATOMIC_ADD:  return (int64_t)((uint64_t)old + (uint64_t)operand);
+    case CACHERCISE_ATOMIC_SWAP: return operand;
+    case CACHERCISE_ATOMIC_CAS:  return old == compare ? operand : old;
+    case CACHERCISE_ATOMIC_MIN:  return operand < old ? operand : old;
+    default:                     return operand > old ? operand : old;
+    }
+}
+
+#endif
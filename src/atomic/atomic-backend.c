@@ -0,0 +1,205 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdint.h>
+#include <string.h>
+#include <json-c/json.h>
+#include "cachercise/cachercise-backend.h"
+#include "../provider.h"
+#include "atomic-backend.h"
+#include "../hoard-c.h"
+
+/* A backend with no locks at all: every slot is an atomic int64 in a
+ * preallocated directory of lazily created pages.  Useful as the ceiling of
+ * what the RPC layer lets us reach when synchronization costs nothing. */
+typedef struct atomic_context {
+    struct json_object* config;
+    atomic_hoard_t h;
+} atomic_context;
+
+#define ATOMIC_DEFAULT_CAPACITY  (1UL << 30)
+#define ATOMIC_DEFAULT_PAGE_SIZE 4096
+#define ATOMIC_MAX_PAGE_SIZE     (1UL << 24)
+/* the most elements whose bytes fit in a size_t, rounded up to a page */
+#define ATOMIC_MAX_CAPACITY      (SIZE_MAX / sizeof(int64_t) - ATOMIC_MAX_PAGE_SIZE)
+
+/* reads an optional integer in [1, max] from the config, filling in the
+ * default if absent so the stored config always reflects what is used */
+static int atomic_config_get_size(struct json_object* config, const char* key,
+        size_t default_value, size_t max, size_t* value)
+{
+    struct json_object* val = json_object_object_get(config, key);
+    if (!val) {
+        json_object_object_add(config, key, json_object_new_int64(default_value));
+        *value = default_value;
+        return 0;
+    }
+    if (!json_object_is_type(val, json_type_int) || json_object_get_int64(val) < 1
+     || (uint64_t)json_object_get_int64(val) > max)
+        return -1;
+    *value = json_object_get_int64(val);
+    return 0;
+}
+
+static cachercise_return_t atomic_init_context(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    struct json_object* config = NULL;
+
+    // read JSON config from provided string argument
+    if (config_str) {
+        struct json_tokener*    tokener = json_tokener_new();
+        enum json_tokener_error jerr;
+        config = json_tokener_parse_ex(
+                tokener, config_str,
+                strlen(config_str));
+        if (!config) {
+            jerr = json_tokener_get_error(tokener);
+            margo_error(provider->mid, "JSON parse error: %s",
+                      json_tokener_error_desc(jerr));
+            json_tokener_free(tokener);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+        json_tokener_free(tokener);
+    } else {
+        // create default JSON config
+        config = json_object_new_object();
+    }
+
+    /* "capacity" (elements) sizes the page directory once and for all */
+    size_t capacity, page_size;
+    if (atomic_config_get_size(config, "capacity", ATOMIC_DEFAULT_CAPACITY,
+                ATOMIC_MAX_CAPACITY, &capacity) != 0
+     || atomic_config_get_size(config, "page_size", ATOMIC_DEFAULT_PAGE_SIZE,
+                ATOMIC_MAX_PAGE_SIZE, &page_size) != 0) {
+        margo_error(provider->mid,
+                "\"capacity\" must be an integer in [1, %zu] and \"page_size\" "
+                "one in [1, %zu]", (size_t)ATOMIC_MAX_CAPACITY,
+                (size_t)ATOMIC_MAX_PAGE_SIZE);
+        json_object_put(config);
+        return CACHERCISE_ERR_INVALID_CONFIG;
+    }
+
+    atomic_hoard_t h = atomic_hoard_init(capacity, page_size);
+    if (!h) {
+        margo_error(provider->mid, "Could not allocate the page directory "
+                "for a capacity of %zu", capacity);
+        json_object_put(config);
+        return CACHERCISE_ERR_ALLOCATION;
+    }
+    atomic_context* ctx = (atomic_context*)calloc(1, sizeof(*ctx));
+    ctx->config = config;
+    ctx->h      = h;
+    *context = (void*)ctx;
+    return CACHERCISE_SUCCESS;
+}
+
+static cachercise_return_t atomic_create_cache(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    return atomic_init_context(provider, config_str, context);
+}
+
+static cachercise_return_t atomic_open_cache(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    return atomic_init_context(provider, config_str, context);
+}
+
+static cachercise_return_t atomic_close_cache(void* ctx)
+{
+    atomic_context* context = (atomic_context*)ctx;
+    json_object_put(context->config);
+    atomic_hoard_finalize(context->h);
+    free(context);
+    return CACHERCISE_SUCCESS;
+}
+
+static cachercise_return_t atomic_destroy_cache(void* ctx)
+{
+    return atomic_close_cache(ctx);
+}
+
+static void atomic_say_hello(void* ctx)
+{
+    (void)ctx;
+    printf("Hello World from Atomic cache\n");
+}
+
+static char* atomic_get_config(void* ctx)
+{
+    atomic_context* context = (atomic_context*)ctx;
+    return strdup(json_object_to_json_string_ext(context->config,
+                JSON_C_TO_STRING_PLAIN));
+}
+
+static int32_t atomic_compute_sum(void* ctx, int32_t x, int32_t y)
+{
+    (void)ctx;
+    return x+y;
+}
+
+static int64_t atomic_io(void *ctx, uint64_t count, int64_t offset, int64_t *scratch, int kind)
+{
+    atomic_context* context = (atomic_context*)ctx;
+    if (offset < 0) return -1;
+    if (kind == CACHERCISE_WRITE)
+        return atomic_hoard_put(context->h, scratch, count/sizeof(int64_t), offset);
+    else
+        return atomic_hoard_get(context->h, scratch, count/sizeof(int64_t), offset);
+}
+
+static int64_t atomic_io_batch(void *ctx, size_t count, const int64_t *offsets, int64_t *values, int kind)
+{
+    atomic_context* context = (atomic_context*)ctx;
+    size_t i;
+    for (i = 0; i < count; i++) {
+        if (offsets[i] < 0) return -1;
+        int ret = (kind == CACHERCISE_WRITE)
+            ? atomic_hoard_put(context->h, values + i, 1, offsets[i])
+            : atomic_hoard_get(context->h, values + i, 1, offsets[i]);
+        if (ret < 0) return ret;
+    }
+    return count;
+}
+
+static int64_t atomic_atomic(void *ctx, int op, size_t count, const int64_t *offsets,
+        const int64_t *operands, const int64_t *compares, int64_t *olds)
+{
+    atomic_context* context = (atomic_context*)ctx;
+    size_t i;
+    for (i = 0; i < count; i++)
+        if (offsets[i] < 0 || atomic_hoard_atomic(context->h, op, offsets[i],
+                    operands[i], compares ? compares[i] : 0, &olds[i]) < 0)
+            return -1;
+    return count;
+}
+
+static cachercise_backend_impl atomic_backend = {
+    .name             = "atomic",
+
+    .create_cache  = atomic_create_cache,
+    .open_cache    = atomic_open_cache,
+    .close_cache   = atomic_close_cache,
+    .destroy_cache = atomic_destroy_cache,
+    .get_config    = atomic_get_config,
+
+    .hello            = atomic_say_hello,
+    .sum              = atomic_compute_sum,
+    .io               = atomic_io,
+    .io_batch         = atomic_io_batch,
+    .atomic           = atomic_atomic
+};
+
+cachercise_return_t cachercise_provider_register_atomic_backend(cachercise_provider_t provider)
+{
+    return cachercise_provider_register_backend(provider, &atomic_backend);
+}
@@ -5,6 +5,7 @@
  */
 #include "types.h"
 #include "client.h"
+#include "combiner.h"
 #include "cachercise/cachercise-client.h"
 
 cachercise_return_t cachercise_client_init(margo_instance_id mid, cachercise_client_t* client)
@@ -13,6 +14,7 @@ cachercise_return_t cachercise_client_init(margo_instance_id mid, cachercise_cli
     if(!c) return CACHERCISE_ERR_ALLOCATION;
 
     c->mid = mid;
+    c->bulk_threshold = CACHERCISE_DEFAULT_BULK_THRESHOLD;
 
     hg_bool_t flag;
     hg_id_t id;
@@ -22,10 +24,22 @@ cachercise_return_t cachercise_client_init(margo_instance_id mid, cachercise_cli
         margo_registered_name(mid, "cachercise_sum", &c->sum_id, &flag);
         margo_registered_name(mid, "cachercise_hello", &c->hello_id, &flag);
         margo_registered_name(mid, "cachercise_io", &c->io_id, &flag);
+        margo_registered_name(mid, "cachercise_io_batch", &c->io_batch_id, &flag);
+        margo_registered_name(mid, "cachercise_io_bulk", &c->io_bulk_id, &flag);
+        margo_registered_name(mid, "cachercise_atomic", &c->atomic_id, &flag);
+        margo_registered_name(mid, "cachercise_blob", &c->blob_id, &flag);
+        margo_registered_name(mid, "cachercise_kv", &c->kv_id, &flag);
+        margo_registered_name(mid, "cachercise_scan", &c->scan_id, &flag);
     } else {
         c->sum_id = MARGO_REGISTER(mid, "cachercise_sum", sum_in_t, sum_out_t, NULL);
         c->hello_id = MARGO_REGISTER(mid, "cachercise_hello", hello_in_t, void, NULL);
         c->io_id = MARGO_REGISTER(mid, "cachercise_io", io_in_t, io_out_t, NULL);
+        c->io_batch_id = MARGO_REGISTER(mid, "cachercise_io_batch", io_batch_in_t, io_batch_out_t, NULL);
+        c->io_bulk_id = MARGO_REGISTER(mid, "cachercise_io_bulk", io_bulk_in_t, io_bulk_out_t, NULL);
+        c->atomic_id = MARGO_REGISTER(mid, "cachercise_atomic", atomic_in_t, atomic_out_t, NULL);
+        c->blob_id = MARGO_REGISTER(mid, "cachercise_blob", blob_in_t, blob_out_t, NULL);
+        c->kv_id = MARGO_REGISTER(mid, "cachercise_kv", kv_in_t, kv_out_t, NULL);
+        c->scan_id = MARGO_REGISTER(mid, "cachercise_scan", scan_in_t, scan_out_t, NULL);
         margo_registered_disable_response(mid, c->hello_id, HG_TRUE);
     }
 
@@ -44,6 +58,28 @@ cachercise_return_t cachercise_client_finalize(cachercise_client_t client)
     return CACHERCISE_SUCCESS;
 }
 
+cachercise_return_t cachercise_client_set_bulk_threshold(
+        cachercise_client_t client,
+        size_t threshold)
+{
+    if(client == CACHERCISE_CLIENT_NULL)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    client->bulk_threshold = threshold;
+    return CACHERCISE_SUCCESS;
+}
+
+cachercise_return_t cachercise_client_set_write_combining(
+        cachercise_client_t client,
+        size_t max_bytes,
+        unsigned flush_interval_ms)
+{
+    if(client == CACHERCISE_CLIENT_NULL)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    client->combine_bytes       = max_bytes;
+    client->combine_interval_ms = flush_interval_ms;
+    return CACHERCISE_SUCCESS;
+}
+
 cachercise_return_t cachercise_cache_handle_create(
         cachercise_client_t client,
         hg_addr_t addr,
@@ -69,6 +105,18 @@ cachercise_return_t cachercise_cache_handle_create(
     rh->provider_id = provider_id;
     rh->cache_id = cache_id;
     rh->refcount    = 1;
+    ABT_mutex_create(&rh->hg_pool_mutex);
+
+    if(client->combine_bytes) {
+        cachercise_return_t cret = combiner_create(rh, client->combine_bytes,
+                client->combine_interval_ms, &rh->combiner);
+        if(cret != CACHERCISE_SUCCESS) {
+            ABT_mutex_free(&rh->hg_pool_mutex);
+            margo_addr_free(client->mid, rh->addr);
+            free(rh);
+            return cret;
+        }
+    }
 
     client->num_cache_handles += 1;
 
@@ -89,13 +137,75 @@ cachercise_return_t cachercise_cache_handle_release(cachercise_cache_handle_t ha
 {
     if(handle == CACHERCISE_CACHE_HANDLE_NULL)
         return CACHERCISE_ERR_INVALID_ARGS;
+    cachercise_return_t ret = CACHERCISE_SUCCESS;
     handle->refcount -= 1;
     if(handle->refcount == 0) {
+        if(handle->combiner)
+            ret = combiner_destroy(handle->combiner);
+        while(handle->hg_pool_count)
+            margo_destroy(handle->hg_pool[--handle->hg_pool_count]);
+        ABT_mutex_free(&handle->hg_pool_mutex);
         margo_addr_free(handle->client->mid, handle->addr);
         handle->client->num_cache_handles -= 1;
         free(handle);
     }
-    return CACHERCISE_SUCCESS;
+    return ret;
+}
+
+/* Take an idle Mercury handle from the cache handle's pool, preferring one
+ * already set up for this RPC and re-targeting another one otherwise; only
+ * create a new one when the pool is empty. */
+static hg_return_t hg_handle_get(
+        cachercise_cache_handle_t handle,
+        hg_id_t id,
+        hg_handle_t* h)
+{
+    hg_handle_t found = HG_HANDLE_NULL;
+    hg_id_t found_id = 0;
+    size_t i;
+
+    ABT_mutex_lock(handle->hg_pool_mutex);
+    if(handle->hg_pool_count) {
+        for(i = handle->hg_pool_count; i > 1; i--)
+            if(handle->hg_pool_ids[i-1] == id) break;
+        found    = handle->hg_pool[i-1];
+        found_id = handle->hg_pool_ids[i-1];
+        handle->hg_pool_count -= 1;
+        handle->hg_pool[i-1]     = handle->hg_pool[handle->hg_pool_count];
+        handle->hg_pool_ids[i-1] = handle->hg_pool_ids[handle->hg_pool_count];
+    }
+    ABT_mutex_unlock(handle->hg_pool_mutex);
+
+    if(found == HG_HANDLE_NULL)
+        return margo_create(handle->client->mid, handle->addr, id, h);
+    if(found_id != id) {
+        hg_return_t hret = margo_reset(found, handle->addr, id);
+        if(hret != HG_SUCCESS) {
+            margo_destroy(found);
+            return hret;
+        }
+    }
+    *h = found;
+    return HG_SUCCESS;
+}
+
+/* Hand a Mercury handle whose operation completed back to the pool.  Handles
+ * from failed operations should be destroyed instead. */
+static void hg_handle_put(
+        cachercise_cache_handle_t handle,
+        hg_id_t id,
+        hg_handle_t h)
+{
+    ABT_mutex_lock(handle->hg_pool_mutex);
+    if(handle->hg_pool_count < CACHERCISE_HG_POOL_SIZE) {
+        handle->hg_pool[handle->hg_pool_count]     = h;
+        handle->hg_pool_ids[handle->hg_pool_count] = id;
+        handle->hg_pool_count += 1;
+        h = HG_HANDLE_NULL;
+    }
+    ABT_mutex_unlock(handle->hg_pool_mutex);
+    if(h != HG_HANDLE_NULL)
+        margo_destroy(h);
 }
 
 cachercise_return_t cachercise_say_hello(cachercise_cache_handle_t handle)
@@ -106,7 +216,7 @@ cachercise_return_t cachercise_say_hello(cachercise_cache_handle_t handle)
 
     memcpy(&in.cache_id, &(handle->cache_id), sizeof(in.cache_id));
 
-    ret = margo_create(handle->client->mid, handle->addr, handle->client->hello_id, &h);
+    ret = hg_handle_get(handle, handle->client->hello_id, &h);
     if(ret != HG_SUCCESS)
         return CACHERCISE_ERR_FROM_MERCURY;
 
@@ -116,7 +226,7 @@ cachercise_return_t cachercise_say_hello(cachercise_cache_handle_t handle)
         return CACHERCISE_ERR_FROM_MERCURY;
     }
 
-    margo_destroy(h);
+    hg_handle_put(handle, handle->client->hello_id, h);
     return CACHERCISE_SUCCESS;
 }
 
@@ -136,29 +246,176 @@ cachercise_return_t cachercise_compute_sum(
     in.x = x;
     in.y = y;
 
-    hret = margo_create(handle->client->mid, handle->addr, handle->client->sum_id, &h);
+    hret = hg_handle_get(handle, handle->client->sum_id, &h);
     if(hret != HG_SUCCESS)
         return CACHERCISE_ERR_FROM_MERCURY;
 
     hret = margo_provider_forward(handle->provider_id, h, &in);
     if(hret != HG_SUCCESS) {
-        ret = CACHERCISE_ERR_FROM_MERCURY;
-        goto finish;
+        margo_destroy(h);
+        return CACHERCISE_ERR_FROM_MERCURY;
     }
 
     hret = margo_get_output(h, &out);
     if(hret != HG_SUCCESS) {
-        ret = CACHERCISE_ERR_FROM_MERCURY;
-        goto finish;
+        margo_destroy(h);
+        return CACHERCISE_ERR_FROM_MERCURY;
     }
 
     ret = out.ret;
     if(ret == CACHERCISE_SUCCESS)
         *result = out.result;
 
-finish:
     margo_free_output(h, &out);
-    margo_destroy(h);
+    hg_handle_put(handle, handle->client->sum_id, h);
+    return ret;
+}
+
+cachercise_return_t cachercise_io_post(
+        cachercise_cache_handle_t handle,
+        void * buf,
+        uint64_t count,
+        int64_t offset,
+        int kind,
+        cachercise_request_t* req)
+{
+    hg_return_t hret;
+    cachercise_request_t r = (cachercise_request_t)calloc(1, sizeof(*r));
+    if(!r) return CACHERCISE_ERR_ALLOCATION;
+
+    r->handle = handle;
+    r->bulk  = HG_BULK_NULL;
+    r->buf   = buf;
+    r->count = count;
+    r->kind  = kind;
+
+    if(count > handle->client->bulk_threshold) {
+        /* the provider pulls or pushes the data itself */
+        io_bulk_in_t in;
+        hg_size_t size = count;
+        memcpy(&in.cache_id, &(handle->cache_id), sizeof(in.cache_id));
+        in.count  = count;
+        in.offset = offset;
+        in.kind   = kind;
+        hret = margo_bulk_create(handle->client->mid, 1, &buf, &size,
+                kind == CACHERCISE_WRITE ? HG_BULK_READ_ONLY : HG_BULK_WRITE_ONLY,
+                &r->bulk);
+        if(hret != HG_SUCCESS) goto error;
+        in.bulk = r->bulk;
+        r->id = handle->client->io_bulk_id;
+        hret = hg_handle_get(handle, r->id, &r->h);
+        if(hret != HG_SUCCESS) goto error;
+        hret = margo_provider_iforward(handle->provider_id, r->h, &in, &r->req);
+    } else {
+        io_in_t in;
+        memcpy(&in.cache_id, &(handle->cache_id), sizeof(in.cache_id));
+        in.count  = count;
+        in.offset = offset;
+        in.kind   = kind;
+        in.data   = (int64_t*)buf;
+        r->id = handle->client->io_id;
+        hret = hg_handle_get(handle, r->id, &r->h);
+        if(hret != HG_SUCCESS) goto error;
+        hret = margo_provider_iforward(handle->provider_id, r->h, &in, &r->req);
+    }
+    if(hret != HG_SUCCESS) goto error;
+
+    *req = r;
+    return CACHERCISE_SUCCESS;
+
+error:
+    if(r->h) margo_destroy(r->h);
+    if(r->bulk != HG_BULK_NULL) margo_bulk_free(r->bulk);
+    free(r);
+    return CACHERCISE_ERR_FROM_MERCURY;
+}
+
+cachercise_return_t cachercise_io_async(
+        cachercise_cache_handle_t handle,
+        void * buf,
+        uint64_t count,
+        int64_t offset,
+        int kind,
+        cachercise_request_t* req)
+{
+    /* buffered writes must land before anything that follows them */
+    if(handle->combiner) {
+        cachercise_return_t ret = combiner_flush(handle->combiner);
+        if(ret != CACHERCISE_SUCCESS) return ret;
+    }
+    return cachercise_io_post(handle, buf, count, offset, kind, req);
+}
+
+cachercise_return_t cachercise_test(
+        cachercise_request_t req,
+        int* flag)
+{
+    if(margo_test(req->req, flag) != HG_SUCCESS)
+        return CACHERCISE_ERR_FROM_MERCURY;
+    return CACHERCISE_SUCCESS;
+}
+
+cachercise_return_t cachercise_wait(cachercise_request_t req)
+{
+    hg_return_t hret;
+    cachercise_return_t ret;
+
+    hret = margo_wait(req->req);
+    if(hret != HG_SUCCESS) {
+        ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    if(req->batch) {
+        io_batch_out_t out;
+        hret = margo_get_output(req->h, &out);
+        if(hret != HG_SUCCESS) {
+            ret = CACHERCISE_ERR_FROM_MERCURY;
+            goto finish;
+        }
+        ret = out.ret;
+        /* a reply with more or fewer values than asked for is broken */
+        if(ret == CACHERCISE_SUCCESS && req->kind == CACHERCISE_READ) {
+            if(out.count != req->count)
+                ret = CACHERCISE_ERR_OTHER;
+            else
+                memcpy(req->buf, out.values, req->count*sizeof(int64_t));
+        }
+        margo_free_output(req->h, &out);
+    } else if(req->bulk != HG_BULK_NULL) {
+        io_bulk_out_t out;
+        hret = margo_get_output(req->h, &out);
+        if(hret != HG_SUCCESS) {
+            ret = CACHERCISE_ERR_FROM_MERCURY;
+            goto finish;
+        }
+        ret = out.ret == CACHERCISE_SUCCESS ? (cachercise_return_t)out.bytes : out.ret;
+        margo_free_output(req->h, &out);
+    } else {
+        io_out_t out;
+        hret = margo_get_output(req->h, &out);
+        if(hret != HG_SUCCESS) {
+            ret = CACHERCISE_ERR_FROM_MERCURY;
+            goto finish;
+        }
+        if (out.ret != CACHERCISE_SUCCESS) {
+            ret = out.ret;
+        } else {
+            if (req->kind == CACHERCISE_READ)
+                memcpy(req->buf, out.data, out.size < req->count ? out.size : req->count);
+            ret = out.bytes;
+        }
+        margo_free_output(req->h, &out);
+    }
+
+finish:
+    if(hret == HG_SUCCESS)
+        hg_handle_put(req->handle, req->id, req->h);
+    else
+        margo_destroy(req->h);
+    if(req->bulk != HG_BULK_NULL)
+        margo_bulk_free(req->bulk);
+    free(req);
     return ret;
 }
 
@@ -168,45 +425,713 @@ cachercise_return_t cachercise_io(
         uint64_t count,
         int64_t offset,
         int kind)
+{
+    cachercise_request_t req;
+    cachercise_return_t ret;
+
+    if(handle->combiner) {
+        /* the combiner buffers whole values only */
+        if(kind == CACHERCISE_WRITE && count % sizeof(int64_t))
+            return CACHERCISE_ERR_INVALID_ARGS;
+        if(kind == CACHERCISE_WRITE && count <= combiner_max_bytes(handle->combiner)) {
+            ret = combiner_write(handle->combiner, (const int64_t*)buf,
+                    count / sizeof(int64_t), offset);
+            return ret == CACHERCISE_SUCCESS ? (cachercise_return_t)count : ret;
+        }
+        ret = combiner_flush(handle->combiner);
+        if(ret != CACHERCISE_SUCCESS) return ret;
+    }
+
+    ret = cachercise_io_post(handle, buf, count, offset, kind, &req);
+    if(ret != CACHERCISE_SUCCESS)
+        return ret;
+    return cachercise_wait(req);
+}
+
+cachercise_return_t cachercise_io_batch(
+        cachercise_cache_handle_t handle,
+        const int64_t *offsets,
+        int64_t *values,
+        size_t count,
+        int kind)
+{
+    if(handle->combiner) {
+        cachercise_return_t ret = combiner_flush(handle->combiner);
+        if(ret != CACHERCISE_SUCCESS) return ret;
+    }
+    return cachercise_io_batch_forward(handle, offsets, values, count, kind);
+}
+
+cachercise_return_t cachercise_io_batch_async(
+        cachercise_cache_handle_t handle,
+        const int64_t *offsets,
+        int64_t *values,
+        size_t count,
+        int kind,
+        cachercise_request_t* req)
+{
+    if(handle->combiner) {
+        cachercise_return_t ret = combiner_flush(handle->combiner);
+        if(ret != CACHERCISE_SUCCESS) return ret;
+    }
+    return cachercise_io_batch_post(handle, offsets, values, count, kind, req);
+}
+
+cachercise_return_t cachercise_io_batch_post(
+        cachercise_cache_handle_t handle,
+        const int64_t *offsets,
+        int64_t *values,
+        size_t count,
+        int kind,
+        cachercise_request_t* req)
+{
+    io_batch_in_t in;
+    hg_return_t hret;
+    if(kind != CACHERCISE_READ && kind != CACHERCISE_WRITE)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    cachercise_request_t r = (cachercise_request_t)calloc(1, sizeof(*r));
+    if(!r) return CACHERCISE_ERR_ALLOCATION;
+
+    r->handle = handle;
+    r->id     = handle->client->io_batch_id;
+    r->bulk   = HG_BULK_NULL;
+    r->batch  = 1;
+    r->buf    = values;
+    r->count  = count;
+    r->kind   = kind;
+
+    memcpy(&in.cache_id, &(handle->cache_id), sizeof(in.cache_id));
+    in.kind    = kind;
+    in.count   = count;
+    in.offsets = (int64_t*)offsets;
+    in.values  = values;
+
+    hret = hg_handle_get(handle, r->id, &r->h);
+    if(hret != HG_SUCCESS) {
+        free(r);
+        return CACHERCISE_ERR_FROM_MERCURY;
+    }
+
+    hret = margo_provider_iforward(handle->provider_id, r->h, &in, &r->req);
+    if(hret != HG_SUCCESS) {
+        margo_destroy(r->h);
+        free(r);
+        return CACHERCISE_ERR_FROM_MERCURY;
+    }
+
+    *req = r;
+    return CACHERCISE_SUCCESS;
+}
+
+cachercise_return_t cachercise_io_batch_forward(
+        cachercise_cache_handle_t handle,
+        const int64_t *offsets,
+        int64_t *values,
+        size_t count,
+        int kind)
+{
+    cachercise_request_t req;
+    cachercise_return_t ret;
+
+    ret = cachercise_io_batch_post(handle, offsets, values, count, kind, &req);
+    if(ret != CACHERCISE_SUCCESS)
+        return ret;
+    return cachercise_wait(req);
+}
+
+cachercise_return_t cachercise_atomic(
+        cachercise_cache_handle_t handle,
+        int op,
+        int64_t offset,
+        int64_t operand,
+        int64_t compare,
+        int64_t* old)
+{
+    return cachercise_atomic_batch(handle, op, &offset, &operand,
+            op == CACHERCISE_ATOMIC_CAS ? &compare : NULL, old, 1);
+}
+
+cachercise_return_t cachercise_atomic_batch(
+        cachercise_cache_handle_t handle,
+        int op,
+        const int64_t *offsets,
+        const int64_t *operands,
+        const int64_t *compares,
+        int64_t *olds,
+        size_t count)
 {
     hg_handle_t h;
-    io_in_t in;
-    io_out_t out;
+    hg_id_t id;
+    atomic_in_t in;
+    atomic_out_t out;
     hg_return_t hret;
     cachercise_return_t ret;
 
-    memcpy(&in.cache_id, &(handle->cache_id), sizeof(in.cache_id));
-    in.count  = count;
-    in.offset = offset;
-    if (kind == CACHERCISE_WRITE) {
-        /* don't want to deal with bulk registration in this concurrency benchmark */
-        if (count > sizeof (int64_t)) count = sizeof(int64_t);
-        memcpy(&(in.scratch), buf, count);
+    if(handle == CACHERCISE_CACHE_HANDLE_NULL
+    || (op == CACHERCISE_ATOMIC_CAS && !compares))
+        return CACHERCISE_ERR_INVALID_ARGS;
+    if(count == 0)
+        return CACHERCISE_SUCCESS;
+
+    /* buffered writes must land before anything that follows them */
+    if(handle->combiner) {
+        ret = combiner_flush(handle->combiner);
+        if(ret != CACHERCISE_SUCCESS) return ret;
     }
-    in.kind   = kind;
 
-    hret = margo_create(handle->client->mid, handle->addr, handle->client->io_id, &h);
+    memcpy(&in.cache_id, &(handle->cache_id), sizeof(in.cache_id));
+    in.op       = op;
+    in.count    = count;
+    in.offsets  = (int64_t*)offsets;
+    in.operands = (int64_t*)operands;
+    in.compares = (int64_t*)compares;
+
+    id = handle->client->atomic_id;
+    hret = hg_handle_get(handle, id, &h);
     if(hret != HG_SUCCESS)
         return CACHERCISE_ERR_FROM_MERCURY;
 
     hret = margo_provider_forward(handle->provider_id, h, &in);
     if(hret != HG_SUCCESS) {
+        margo_destroy(h);
+        return CACHERCISE_ERR_FROM_MERCURY;
+    }
+
+    hret = margo_get_output(h, &out);
+    if(hret != HG_SUCCESS) {
+        margo_destroy(h);
+        return CACHERCISE_ERR_FROM_MERCURY;
+    }
+
+    ret = out.ret;
+    if(ret == CACHERCISE_SUCCESS && olds)
+        memcpy(olds, out.olds,
+                (out.count < count ? out.count : count) * sizeof(int64_t));
+
+    margo_free_output(h, &out);
+    hg_handle_put(handle, id, h);
+    return ret;
+}
+
+/* one blob RPC; buf (size bytes) is exposed to the provider unless empty */
+static cachercise_return_t blob_forward(
+        cachercise_cache_handle_t handle,
+        uint64_t key,
+        void* buf,
+        size_t size,
+        int kind,
+        size_t* length)
+{
+    hg_handle_t h;
+    hg_id_t id;
+    blob_in_t in;
+    blob_out_t out;
+    hg_return_t hret;
+    cachercise_return_t ret;
+
+    if(handle == CACHERCISE_CACHE_HANDLE_NULL || (size > 0 && !buf))
+        return CACHERCISE_ERR_INVALID_ARGS;
+
+    memcpy(&in.cache_id, &(handle->cache_id), sizeof(in.cache_id));
+    in.key  = key;
+    in.size = size;
+    in.kind = kind;
+    in.bulk = HG_BULK_NULL;
+    if(size > 0) {
+        hg_size_t bsize = size;
+        hret = margo_bulk_create(handle->client->mid, 1, &buf, &bsize,
+                kind == CACHERCISE_WRITE ? HG_BULK_READ_ONLY : HG_BULK_WRITE_ONLY,
+                &in.bulk);
+        if(hret != HG_SUCCESS)
+            return CACHERCISE_ERR_FROM_MERCURY;
+    }
+
+    id = handle->client->blob_id;
+    hret = hg_handle_get(handle, id, &h);
+    if(hret != HG_SUCCESS) {
+        ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    hret = margo_provider_forward(handle->provider_id, h, &in);
+    if(hret != HG_SUCCESS) {
+        margo_destroy(h);
+        ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    hret = margo_get_output(h, &out);
+    if(hret != HG_SUCCESS) {
+        margo_destroy(h);
+        ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    ret = out.ret;
+    if(ret == CACHERCISE_SUCCESS && length)
+        *length = out.size;
+
+    margo_free_output(h, &out);
+    hg_handle_put(handle, id, h);
+
+finish:
+    if(in.bulk != HG_BULK_NULL)
+        margo_bulk_free(in.bulk);
+    return ret;
+}
+
+cachercise_return_t cachercise_blob_put(
+        cachercise_cache_handle_t handle,
+        uint64_t key,
+        const void* data,
+        size_t size)
+{
+    return blob_forward(handle, key, (void*)data, size, CACHERCISE_WRITE, NULL);
+}
+
+cachercise_return_t cachercise_blob_get(
+        cachercise_cache_handle_t handle,
+        uint64_t key,
+        void* buf,
+        size_t capacity,
+        size_t* size)
+{
+    return blob_forward(handle, key, buf, capacity, CACHERCISE_READ, size);
+}
+
+cachercise_return_t cachercise_blob_erase(
+        cachercise_cache_handle_t handle,
+        uint64_t key)
+{
+    return blob_forward(handle, key, NULL, 0, CACHERCISE_ERASE, NULL);
+}
+
+/* one kv RPC over a batch of count records (size bytes of buf) and reply
+ * bytes of room after them, all exposed to the provider as one bulk */
+static cachercise_return_t kv_forward(
+        cachercise_cache_handle_t handle,
+        int kind,
+        size_t count,
+        char* buf,
+        size_t size,
+        size_t reply)
+{
+    hg_handle_t h;
+    hg_id_t id;
+    kv_in_t in;
+    kv_out_t out;
+    hg_return_t hret;
+    cachercise_return_t ret;
+    hg_size_t bsize = size + reply;
+
+    memcpy(&in.cache_id, &(handle->cache_id), sizeof(in.cache_id));
+    in.kind  = kind;
+    in.count = count;
+    in.size  = size;
+    in.reply = reply;
+    in.bulk  = HG_BULK_NULL;
+    if(bsize > 0) {
+        hret = margo_bulk_create(handle->client->mid, 1, (void**)&buf, &bsize,
+                reply ? HG_BULK_READWRITE : HG_BULK_READ_ONLY, &in.bulk);
+        if(hret != HG_SUCCESS)
+            return CACHERCISE_ERR_FROM_MERCURY;
+    }
+
+    id = handle->client->kv_id;
+    hret = hg_handle_get(handle, id, &h);
+    if(hret != HG_SUCCESS) {
+        ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    hret = margo_provider_forward(handle->provider_id, h, &in);
+    if(hret != HG_SUCCESS) {
+        margo_destroy(h);
         ret = CACHERCISE_ERR_FROM_MERCURY;
         goto finish;
     }
 
     hret = margo_get_output(h, &out);
     if(hret != HG_SUCCESS) {
+        margo_destroy(h);
         ret = CACHERCISE_ERR_FROM_MERCURY;
         goto finish;
     }
 
-    if (kind == CACHERCISE_READ) {
-        if (out.bytes > sizeof(int64_t)) out.bytes = sizeof(int64_t);
-	memcpy(buf, &(out.scratch), out.bytes);
+    ret = out.ret;
+
+    margo_free_output(h, &out);
+    hg_handle_put(handle, id, h);
+
+finish:
+    if(in.bulk != HG_BULK_NULL)
+        margo_bulk_free(in.bulk);
+    return ret;
+}
+
+/* appends a record at off, returning the offset after it */
+static size_t kv_pack(char* buf, size_t off, const void* key, size_t key_size,
+        const void* value, size_t value_size)
+{
+    kv_record_hdr hdr = { (uint32_t)key_size, (uint32_t)value_size };
+    memcpy(buf + off, &hdr, sizeof(hdr));
+    memcpy(buf + off + sizeof(hdr), key, key_size);
+    if(value)
+        memcpy(buf + off + sizeof(hdr) + key_size, value, value_size);
+    return off + KV_PAD(sizeof(hdr) + key_size + (value ? value_size : 0));
+}
+
+cachercise_return_t cachercise_kv_put_multi(
+        cachercise_cache_handle_t handle,
+        size_t count,
+        const void* const* keys,
+        const size_t* key_sizes,
+        const void* const* values,
+        const size_t* value_sizes)
+{
+    cachercise_return_t ret;
+    size_t i, size = 0;
+    char* buf;
+
+    if(handle == CACHERCISE_CACHE_HANDLE_NULL)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    for(i = 0; i < count; i++) {
+        if(key_sizes[i] > UINT32_MAX || value_sizes[i] > UINT32_MAX)
+            return CACHERCISE_ERR_INVALID_ARGS;
+        size += KV_PAD(sizeof(kv_record_hdr) + key_sizes[i] + value_sizes[i]);
+    }
+    /* zeroed, so that padding sends no stray bytes */
+    buf = calloc(1, size ? size : 1);
+    if(!buf)
+        return CACHERCISE_ERR_ALLOCATION;
+    for(i = 0, size = 0; i < count; i++)
+        size = kv_pack(buf, size, keys[i], key_sizes[i],
+                values[i] ? values[i] : "", value_sizes[i]);
+
+    ret = kv_forward(handle, CACHERCISE_WRITE, count, buf, size, 0);
+    free(buf);
+    return ret;
+}
+
+cachercise_return_t cachercise_kv_get_multi(
+        cachercise_cache_handle_t handle,
+        size_t count,
+        const void* const* keys,
+        const size_t* key_sizes,
+        void* const* bufs,
+        const size_t* capacities,
+        size_t* value_sizes)
+{
+    cachercise_return_t ret;
+    size_t i, size = 0, reply = count * sizeof(int64_t), off;
+    int64_t* lengths;
+    char* buf;
+
+    if(handle == CACHERCISE_CACHE_HANDLE_NULL)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    for(i = 0; i < count; i++) {
+        if(key_sizes[i] > UINT32_MAX || capacities[i] > UINT32_MAX)
+            return CACHERCISE_ERR_INVALID_ARGS;
+        size  += KV_PAD(sizeof(kv_record_hdr) + key_sizes[i]);
+        reply += KV_PAD(capacities[i]);
+    }
+    buf = calloc(1, size + reply ? size + reply : 1);
+    if(!buf)
+        return CACHERCISE_ERR_ALLOCATION;
+    for(i = 0, size = 0; i < count; i++)
+        size = kv_pack(buf, size, keys[i], key_sizes[i], NULL, capacities[i]);
+
+    ret = kv_forward(handle, CACHERCISE_READ, count, buf, size, reply);
+    if(ret != CACHERCISE_SUCCESS)
+        goto finish;
+
+    lengths = (int64_t*)(buf + size);
+    off = size + count * sizeof(int64_t);
+    for(i = 0; i < count; i++) {
+        if(lengths[i] < 0) {
+            value_sizes[i] = CACHERCISE_KV_ABSENT;
+        } else {
+            value_sizes[i] = lengths[i];
+            memcpy(bufs[i], buf + off,
+                   value_sizes[i] < capacities[i] ? value_sizes[i] : capacities[i]);
+        }
+        off += KV_PAD(capacities[i]);
     }
-    return out.bytes;
 
 finish:
+    free(buf);
+    return ret;
+}
+
+cachercise_return_t cachercise_kv_put(
+        cachercise_cache_handle_t handle,
+        const void* key,
+        size_t key_size,
+        const void* value,
+        size_t value_size)
+{
+    return cachercise_kv_put_multi(handle, 1, &key, &key_size, &value, &value_size);
+}
+
+cachercise_return_t cachercise_kv_get(
+        cachercise_cache_handle_t handle,
+        const void* key,
+        size_t key_size,
+        void* buf,
+        size_t capacity,
+        size_t* size)
+{
+    size_t length;
+    cachercise_return_t ret = cachercise_kv_get_multi(
+            handle, 1, &key, &key_size, &buf, &capacity, &length);
+    if(ret != CACHERCISE_SUCCESS)
+        return ret;
+    if(length == CACHERCISE_KV_ABSENT)
+        return CACHERCISE_ERR_NOT_FOUND;
+    if(size)
+        *size = length;
+    return CACHERCISE_SUCCESS;
+}
+
+cachercise_return_t cachercise_kv_erase(
+        cachercise_cache_handle_t handle,
+        const void* key,
+        size_t key_size)
+{
+    cachercise_return_t ret;
+    char* buf;
+    size_t size;
+
+    if(handle == CACHERCISE_CACHE_HANDLE_NULL || key_size > UINT32_MAX)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    buf = calloc(1, KV_PAD(sizeof(kv_record_hdr) + key_size));
+    if(!buf)
+        return CACHERCISE_ERR_ALLOCATION;
+    size = kv_pack(buf, 0, key, key_size, NULL, 0);
+
+    ret = kv_forward(handle, CACHERCISE_ERASE, 1, buf, size, 0);
+    free(buf);
+    return ret;
+}
+
+cachercise_return_t cachercise_flush(cachercise_cache_handle_t handle)
+{
+    if(handle == CACHERCISE_CACHE_HANDLE_NULL)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    if(!handle->combiner)
+        return CACHERCISE_SUCCESS;
+    return combiner_flush(handle->combiner);
+}
+
+/* asks for the chunk from start into buffer b */
+static cachercise_return_t scan_post(cachercise_scan_t scan, int b, int64_t start)
+{
+    scan_in_t in;
+    hg_return_t hret;
+
+    memcpy(&in.cache_id, &(scan->handle->cache_id), sizeof(in.cache_id));
+    in.start = start;
+    in.end   = scan->end;
+    in.flags = scan->flags;
+    in.size  = scan->size;
+    in.bulk  = scan->bulk[b];
+
+    hret = hg_handle_get(scan->handle, scan->handle->client->scan_id, &scan->h);
+    if(hret != HG_SUCCESS) {
+        scan->h = HG_HANDLE_NULL;
+        return CACHERCISE_ERR_FROM_MERCURY;
+    }
+    hret = margo_provider_iforward(scan->handle->provider_id, scan->h, &in, &scan->req);
+    if(hret != HG_SUCCESS) {
+        margo_destroy(scan->h);
+        scan->h = HG_HANDLE_NULL;
+        return CACHERCISE_ERR_FROM_MERCURY;
+    }
+    scan->next = start;
+    return CACHERCISE_SUCCESS;
+}
+
+/* waits for the chunk in flight, which becomes the one being read */
+static cachercise_return_t scan_collect(cachercise_scan_t scan)
+{
+    scan_out_t out;
+    hg_return_t hret;
+    cachercise_return_t ret;
+    hg_handle_t h = scan->h;
+
+    scan->h = HG_HANDLE_NULL;
+    hret = margo_wait(scan->req);
+    if(hret != HG_SUCCESS) {
+        margo_destroy(h);
+        return CACHERCISE_ERR_FROM_MERCURY;
+    }
+    hret = margo_get_output(h, &out);
+    if(hret != HG_SUCCESS) {
+        margo_destroy(h);
+        return CACHERCISE_ERR_FROM_MERCURY;
+    }
+
+    ret = out.ret;
+    /* a chunk that gets nowhere would have the scan spin forever */
+    if(ret == CACHERCISE_SUCCESS
+    && (out.bytes > scan->size || out.cursor <= scan->next || out.cursor > scan->end))
+        ret = CACHERCISE_ERR_OTHER;
+    if(ret == CACHERCISE_SUCCESS) {
+        scan->cur   = !scan->cur;
+        scan->pos   = 0;
+        scan->bytes = out.bytes;
+        scan->done  = out.cursor;
+    }
+
+    margo_free_output(h, &out);
+    hg_handle_put(scan->handle, scan->handle->client->scan_id, h);
     return ret;
 }
+
+cachercise_return_t cachercise_scan_open(
+        cachercise_cache_handle_t handle,
+        int64_t start,
+        int64_t end,
+        int flags,
+        size_t chunk_size,
+        cachercise_scan_t* scan)
+{
+    cachercise_return_t ret;
+    hg_return_t hret;
+    hg_size_t size;
+    int b;
+
+    if(handle == CACHERCISE_CACHE_HANDLE_NULL || start < 0 || end < start
+    || (flags & ~CACHERCISE_SCAN_POPULATED))
+        return CACHERCISE_ERR_INVALID_ARGS;
+    if(chunk_size == 0)
+        chunk_size = CACHERCISE_SCAN_DEFAULT_CHUNK;
+    if(chunk_size > CACHERCISE_SCAN_MAX_CHUNK)
+        chunk_size = CACHERCISE_SCAN_MAX_CHUNK;
+
+    /* buffered writes must land before the scan reads past them */
+    if(handle->combiner) {
+        ret = combiner_flush(handle->combiner);
+        if(ret != CACHERCISE_SUCCESS) return ret;
+    }
+
+    cachercise_scan_t s = (cachercise_scan_t)calloc(1, sizeof(*s));
+    if(!s) return CACHERCISE_ERR_ALLOCATION;
+    s->handle = handle;
+    s->end    = end;
+    s->flags  = flags;
+    s->size   = chunk_size;
+    s->cur    = 1; /* so that the first chunk, into buffer 0, is read next */
+    s->done   = start;
+    s->cursor = start;
+    s->h      = HG_HANDLE_NULL;
+    s->bulk[0] = s->bulk[1] = HG_BULK_NULL;
+
+    for(b = 0; b < 2; b++) {
+        s->buf[b] = malloc(chunk_size);
+        if(!s->buf[b]) {
+            ret = CACHERCISE_ERR_ALLOCATION;
+            goto error;
+        }
+        size = chunk_size;
+        hret = margo_bulk_create(handle->client->mid, 1, (void**)&s->buf[b], &size,
+                HG_BULK_WRITE_ONLY, &s->bulk[b]);
+        if(hret != HG_SUCCESS) {
+            ret = CACHERCISE_ERR_FROM_MERCURY;
+            goto error;
+        }
+    }
+
+    if(start < end) {
+        ret = scan_post(s, 0, start);
+        if(ret != CACHERCISE_SUCCESS)
+            goto error;
+    }
+
+    *scan = s;
+    return CACHERCISE_SUCCESS;
+
+error:
+    for(b = 0; b < 2; b++) {
+        if(s->bulk[b] != HG_BULK_NULL) margo_bulk_free(s->bulk[b]);
+        free(s->buf[b]);
+    }
+    free(s);
+    return ret;
+}
+
+cachercise_return_t cachercise_scan_next(
+        cachercise_scan_t scan,
+        int64_t* offset,
+        const void** data,
+        size_t* size)
+{
+    cachercise_return_t ret;
+    scan_extent_hdr hdr;
+
+    if(scan == CACHERCISE_SCAN_NULL)
+        return CACHERCISE_ERR_INVALID_ARGS;
+
+    while(scan->pos == scan->bytes) {
+        /* everything before where this chunk ended has been seen */
+        scan->cursor = scan->done;
+        if(scan->h == HG_HANDLE_NULL) {
+            *size = 0;
+            return CACHERCISE_SUCCESS;
+        }
+        ret = scan_collect(scan);
+        if(ret != CACHERCISE_SUCCESS)
+            return ret;
+        /* the provider fills the other buffer while this one is read */
+        if(scan->done < scan->end) {
+            ret = scan_post(scan, !scan->cur, scan->done);
+            if(ret != CACHERCISE_SUCCESS)
+                return ret;
+        }
+    }
+
+    char* buf = scan->buf[scan->cur];
+    if(scan->bytes - scan->pos < sizeof(hdr))
+        return CACHERCISE_ERR_OTHER;
+    memcpy(&hdr, buf + scan->pos, sizeof(hdr));
+    if(hdr.size > scan->bytes - scan->pos - sizeof(hdr))
+        return CACHERCISE_ERR_OTHER;
+
+    *offset = hdr.offset;
+    *data   = buf + scan->pos + sizeof(hdr);
+    *size   = hdr.size;
+    scan->pos += sizeof(hdr) + KV_PAD(hdr.size);
+    if(scan->pos > scan->bytes)
+        scan->pos = scan->bytes;
+    scan->cursor = hdr.offset + hdr.count;
+    return CACHERCISE_SUCCESS;
+}
+
+cachercise_return_t cachercise_scan_cursor(
+        cachercise_scan_t scan,
+        int64_t* cursor)
+{
+    if(scan == CACHERCISE_SCAN_NULL)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    *cursor = scan->cursor;
+    return CACHERCISE_SUCCESS;
+}
+
+cachercise_return_t cachercise_scan_close(cachercise_scan_t scan)
+{
+    int b;
+
+    if(scan == CACHERCISE_SCAN_NULL)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    /* the provider may still be pushing into one of the buffers */
+    if(scan->h != HG_HANDLE_NULL) {
+        margo_wait(scan->req);
+        margo_destroy(scan->h);
+    }
+    for(b = 0; b < 2; b++) {
+        margo_bulk_free(scan->bulk[b]);
+        free(scan->buf[b]);
+    }
+    free(scan);
+    return CACHERCISE_SUCCESS;
+}
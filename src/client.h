@@ -15,15 +15,91 @@ typedef struct cachercise_client {
    hg_id_t           hello_id;
    hg_id_t           sum_id;
    hg_id_t           io_id;
+   hg_id_t           io_batch_id;
+   hg_id_t           io_bulk_id;
+   hg_id_t           atomic_id;
+   hg_id_t           blob_id;
+   hg_id_t           kv_id;
+   hg_id_t           scan_id;
+   size_t            bulk_threshold;
+   size_t            combine_bytes;       /* 0: no write combining */
+   unsigned          combine_interval_ms;
    uint64_t          num_cache_handles;
 } cachercise_client;
 
+/* idle Mercury handles each cache handle keeps around for reuse */
+#define CACHERCISE_HG_POOL_SIZE 16
+
 typedef struct cachercise_cache_handle {
     cachercise_client_t      client;
     hg_addr_t           addr;
     uint16_t            provider_id;
     uint64_t            refcount;
     cachercise_cache_id_t cache_id;
+    struct cachercise_combiner* combiner; /* NULL unless combining writes */
+    ABT_mutex           hg_pool_mutex;
+    size_t              hg_pool_count;
+    hg_handle_t         hg_pool[CACHERCISE_HG_POOL_SIZE];
+    hg_id_t             hg_pool_ids[CACHERCISE_HG_POOL_SIZE];
 } cachercise_cache_handle;
 
+typedef struct cachercise_request {
+    cachercise_cache_handle_t handle;
+    hg_id_t       id;
+    hg_handle_t   h;
+    margo_request req;
+    hg_bulk_t     bulk;  /* HG_BULK_NULL when the data went inline */
+    int           batch; /* io_batch rather than io */
+    void*         buf;
+    uint64_t      count; /* bytes for io, entries for io_batch */
+    int           kind;
+} cachercise_request;
+
+/* scan chunk sizes, the largest being what the provider stages at once */
+#define CACHERCISE_SCAN_DEFAULT_CHUNK (1024*1024)
+#define CACHERCISE_SCAN_MAX_CHUNK     (4*1024*1024)
+
+/* a scan reads one buffer while the provider fills the other */
+typedef struct cachercise_scan {
+    cachercise_cache_handle_t handle;
+    int64_t       end;
+    int           flags;
+    size_t        size;     /* bytes per buffer */
+    char*         buf[2];
+    hg_bulk_t     bulk[2];
+    int           cur;      /* buffer being read */
+    size_t        pos;      /* next extent in it */
+    size_t        bytes;    /* extents in it */
+    int64_t       done;     /* where the chunk in it ended */
+    int64_t       cursor;
+    hg_handle_t   h;        /* chunk in flight, if any */
+    margo_request req;
+    int64_t       next;     /* where the chunk in flight starts */
+} cachercise_scan;
+
+/* the io paths below go straight to the provider, bypassing the handle's
+ * write-combining buffer (which uses them to flush itself) */
+cachercise_return_t cachercise_io_post(
+        cachercise_cache_handle_t handle,
+        void * buf,
+        uint64_t count,
+        int64_t offset,
+        int kind,
+        cachercise_request_t* req);
+
+cachercise_return_t cachercise_io_batch_post(
+        cachercise_cache_handle_t handle,
+        const int64_t *offsets,
+        int64_t *values,
+        size_t count,
+        int kind,
+        cachercise_request_t* req);
+
+cachercise_return_t cachercise_io_batch_forward(
+        cachercise_cache_handle_t handle,
+        const int64_t *offsets,
+        int64_t *values,
+        size_t count,
+        int kind);
+
 #endif
@@ -0,0 +1,327 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <time.h>
+#include "client.h"
+#include "combiner.h"
+
+/* runs at least this long are flushed as a contiguous io of their own;
+ * shorter ones are gathered into a single io_batch */
+#define COMBINER_CONTIGUOUS_RUN 16
+
+typedef struct combiner_run {
+    int64_t  offset;
+    size_t   count;
+    size_t   capacity;
+    int64_t* values;
+} combiner_run;
+
+typedef struct cachercise_combiner {
+    cachercise_cache_handle_t handle;
+    ABT_mutex     mutex;
+    ABT_cond      cond;
+    ABT_cond      flushed;   /* signalled when a flush is over */
+    ABT_thread    flusher;
+    int           stop;
+    int           flushing;  /* runs are on their way, outside the mutex */
+    combiner_run* runs;      /* sorted by offset, never touching */
+    size_t        num_runs;
+    size_t        max_runs;
+    size_t        pending;   /* values buffered across all runs */
+    size_t        max_values;
+    double        interval;  /* seconds */
+    double        oldest;    /* time of the first write since the last flush */
+    cachercise_return_t error;
+} cachercise_combiner;
+
+static cachercise_return_t flush_locked(cachercise_combiner_t c);
+static void flusher_ult(void* arg);
+
+cachercise_return_t combiner_create(
+        cachercise_cache_handle_t handle,
+        size_t max_bytes,
+        unsigned interval_ms,
+        cachercise_combiner_t* combiner)
+{
+    cachercise_combiner_t c = (cachercise_combiner_t)calloc(1, sizeof(*c));
+    if(!c) return CACHERCISE_ERR_ALLOCATION;
+
+    c->handle     = handle;
+    c->max_values = max_bytes / sizeof(int64_t);
+    c->interval   = interval_ms / 1000.0;
+    c->error      = CACHERCISE_SUCCESS;
+    ABT_mutex_create(&c->mutex);
+    ABT_cond_create(&c->cond);
+    ABT_cond_create(&c->flushed);
+    c->flusher = ABT_THREAD_NULL;
+
+    if(interval_ms) {
+        ABT_pool pool;
+        margo_get_handler_pool(handle->client->mid, &pool);
+        if(ABT_thread_create(pool, flusher_ult, c, ABT_THREAD_ATTR_NULL, &c->flusher) != ABT_SUCCESS) {
+            ABT_cond_free(&c->flushed);
+            ABT_cond_free(&c->cond);
+            ABT_mutex_free(&c->mutex);
+            free(c);
+            return CACHERCISE_ERR_FROM_ARGOBOTS;
+        }
+    }
+
+    *combiner = c;
+    return CACHERCISE_SUCCESS;
+}
+
+size_t combiner_max_bytes(cachercise_combiner_t c)
+{
+    return c->max_values * sizeof(int64_t);
+}
+
+/* make room for count values in run r, keeping its start */
+static int run_reserve(combiner_run* r, size_t count)
+{
+    if(count <= r->capacity) return 0;
+    size_t capacity = r->capacity ? r->capacity : 8;
+    while(capacity < count) capacity *= 2;
+    int64_t* values = (int64_t*)realloc(r->values, capacity*sizeof(int64_t));
+    if(!values) return -1;
+    r->values   = values;
+    r->capacity = capacity;
+    return 0;
+}
+
+cachercise_return_t combiner_write(
+        cachercise_combiner_t c,
+        const int64_t* values,
+        size_t count,
+        int64_t offset)
+{
+    cachercise_return_t ret = CACHERCISE_SUCCESS;
+    int64_t end = offset + count;
+    size_t lo, hi, i;
+
+    if(count == 0) return CACHERCISE_SUCCESS;
+
+    ABT_mutex_lock(c->mutex);
+    int was_empty = c->num_runs == 0;
+
+    /* runs [lo,hi) overlap or touch [offset,end) */
+    size_t l = 0, h = c->num_runs;
+    while(l < h) {
+        size_t m = (l + h) / 2;
+        if(c->runs[m].offset + (int64_t)c->runs[m].count < offset) l = m + 1;
+        else h = m;
+    }
+    lo = l;
+    for(hi = lo; hi < c->num_runs && c->runs[hi].offset <= end; hi++);
+
+    if(lo == hi) {
+        /* nothing nearby: a new run */
+        if(c->num_runs == c->max_runs) {
+            size_t max_runs = c->max_runs ? c->max_runs*2 : 16;
+            combiner_run* runs = (combiner_run*)realloc(c->runs, max_runs*sizeof(*runs));
+            if(!runs) { ret = CACHERCISE_ERR_ALLOCATION; goto finish; }
+            c->runs = runs;
+            c->max_runs = max_runs;
+        }
+        combiner_run r = { offset, 0, 0, NULL };
+        if(run_reserve(&r, count)) { ret = CACHERCISE_ERR_ALLOCATION; goto finish; }
+        memcpy(r.values, values, count*sizeof(int64_t));
+        r.count = count;
+        memmove(&c->runs[lo+1], &c->runs[lo], (c->num_runs - lo)*sizeof(*c->runs));
+        c->runs[lo] = r;
+        c->num_runs += 1;
+        c->pending += count;
+    } else {
+        /* fold runs lo+1..hi-1 and the new values into run lo.  Whatever lies
+         * between two old runs is inside [offset,end), so the result has no
+         * holes. */
+        combiner_run* r = &c->runs[lo];
+        int64_t start = r->offset < offset ? r->offset : offset;
+        int64_t last_end = c->runs[hi-1].offset + c->runs[hi-1].count;
+        int64_t stop = last_end > end ? last_end : end;
+        size_t before = 0;
+        for(i = lo; i < hi; i++) before += c->runs[i].count;
+
+        if(start < r->offset) {
+            /* growing at the front: shift what is there */
+            size_t shift = r->offset - start;
+            if(run_reserve(r, r->count + shift)) { ret = CACHERCISE_ERR_ALLOCATION; goto finish; }
+            memmove(r->values + shift, r->values, r->count*sizeof(int64_t));
+            r->offset = start;
+            r->count += shift;
+        }
+        if(run_reserve(r, stop - start)) { ret = CACHERCISE_ERR_ALLOCATION; goto finish; }
+        for(i = lo+1; i < hi; i++) {
+            memcpy(r->values + (c->runs[i].offset - start), c->runs[i].values,
+                    c->runs[i].count*sizeof(int64_t));
+            free(c->runs[i].values);
+        }
+        memcpy(r->values + (offset - start), values, count*sizeof(int64_t));
+        r->count = stop - start;
+        memmove(&c->runs[lo+1], &c->runs[hi], (c->num_runs - hi)*sizeof(*c->runs));
+        c->num_runs -= hi - lo - 1;
+        c->pending += r->count - before;
+    }
+
+    if(was_empty)
+        c->oldest = ABT_get_wtime();
+    if(c->pending >= c->max_values)
+        ret = flush_locked(c);
+
+finish:
+    if(ret == CACHERCISE_SUCCESS) {
+        ret = c->error;
+        c->error = CACHERCISE_SUCCESS;
+    }
+    ABT_mutex_unlock(c->mutex);
+    return ret;
+}
+
+/* sends runs, holding pending values, and frees them */
+static cachercise_return_t send_runs(
+        cachercise_cache_handle_t handle,
+        combiner_run* runs,
+        size_t num_runs,
+        size_t pending)
+{
+    cachercise_return_t ret = CACHERCISE_SUCCESS;
+    cachercise_request_t* reqs = NULL;
+    size_t* sent = NULL;  /* the run behind each request */
+    int64_t* offsets = NULL;
+    int64_t* values = NULL;
+    size_t num_reqs = 0, num_scattered = 0, i, j;
+
+    reqs = (cachercise_request_t*)malloc(num_runs*sizeof(*reqs));
+    sent = (size_t*)malloc(num_runs*sizeof(*sent));
+    offsets = (int64_t*)malloc(pending*sizeof(int64_t));
+    values = (int64_t*)malloc(pending*sizeof(int64_t));
+    if(!reqs || !sent || !offsets || !values) {
+        ret = CACHERCISE_ERR_ALLOCATION;
+        goto finish;
+    }
+
+    /* long runs go out as contiguous transfers, all in flight at once */
+    for(i = 0; i < num_runs; i++) {
+        combiner_run* r = &runs[i];
+        if(r->count >= COMBINER_CONTIGUOUS_RUN) {
+            ret = cachercise_io_post(handle, r->values, r->count*sizeof(int64_t),
+                    r->offset, CACHERCISE_WRITE, &reqs[num_reqs]);
+            if(ret != CACHERCISE_SUCCESS) break;
+            sent[num_reqs++] = i;
+        } else {
+            for(j = 0; j < r->count; j++) {
+                offsets[num_scattered] = r->offset + j;
+                values[num_scattered]  = r->values[j];
+                num_scattered++;
+            }
+        }
+    }
+    /* the rest travel as one batch of offset/value pairs */
+    if(ret == CACHERCISE_SUCCESS && num_scattered)
+        ret = cachercise_io_batch_forward(handle, offsets, values,
+                num_scattered, CACHERCISE_WRITE);
+    /* a transfer returns its byte count, anything else is an error code */
+    for(i = 0; i < num_reqs; i++) {
+        cachercise_return_t r = cachercise_wait(reqs[i]);
+        if((size_t)r != runs[sent[i]].count*sizeof(int64_t)
+        && ret == CACHERCISE_SUCCESS)
+            ret = (r > CACHERCISE_SUCCESS && r <= CACHERCISE_ERR_OTHER)
+                ? r : CACHERCISE_ERR_OTHER;
+    }
+
+finish:
+    /* on failure the buffered data is dropped and the error reported once */
+    for(i = 0; i < num_runs; i++)
+        free(runs[i].values);
+    free(runs);
+    free(reqs);
+    free(sent);
+    free(offsets);
+    free(values);
+    return ret;
+}
+
+/* Called with the mutex held, and returns with it held, but drops it while
+ * the runs are on their way: writers keep buffering into a fresh set of
+ * runs meanwhile.  Flushes still go one at a time, so that a newer value
+ * for an offset never lands before an older one. */
+static cachercise_return_t flush_locked(cachercise_combiner_t c)
+{
+    cachercise_return_t ret;
+
+    while(c->flushing)
+        ABT_cond_wait(c->flushed, c->mutex);
+    if(c->num_runs == 0) return CACHERCISE_SUCCESS;
+
+    combiner_run* runs = c->runs;
+    size_t num_runs    = c->num_runs;
+    size_t pending     = c->pending;
+    c->runs     = NULL;
+    c->num_runs = 0;
+    c->max_runs = 0;
+    c->pending  = 0;
+    c->flushing = 1;
+    ABT_mutex_unlock(c->mutex);
+
+    ret = send_runs(c->handle, runs, num_runs, pending);
+
+    ABT_mutex_lock(c->mutex);
+    c->flushing = 0;
+    ABT_cond_broadcast(c->flushed);
+    return ret;
+}
+
+cachercise_return_t combiner_flush(cachercise_combiner_t c)
+{
+    cachercise_return_t ret;
+    ABT_mutex_lock(c->mutex);
+    ret = flush_locked(c);
+    if(ret == CACHERCISE_SUCCESS)
+        ret = c->error;
+    c->error = CACHERCISE_SUCCESS;
+    ABT_mutex_unlock(c->mutex);
+    return ret;
+}
+
+static void flusher_ult(void* arg)
+{
+    cachercise_combiner_t c = (cachercise_combiner_t)arg;
+    ABT_mutex_lock(c->mutex);
+    while(!c->stop) {
+        struct timespec deadline;
+        double wakeup;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        wakeup = deadline.tv_sec + deadline.tv_nsec*1e-9 + c->interval;
+        deadline.tv_sec  = (time_t)wakeup;
+        deadline.tv_nsec = (long)((wakeup - deadline.tv_sec)*1e9);
+        ABT_cond_timedwait(c->cond, c->mutex, &deadline);
+        if(c->stop) break;
+        if(c->num_runs && ABT_get_wtime() - c->oldest >= c->interval) {
+            cachercise_return_t ret = flush_locked(c);
+            if(ret != CACHERCISE_SUCCESS) c->error = ret;
+        }
+    }
+    ABT_mutex_unlock(c->mutex);
+}
+
+cachercise_return_t combiner_destroy(cachercise_combiner_t c)
+{
+    cachercise_return_t ret;
+    if(c->flusher != ABT_THREAD_NULL) {
+        ABT_mutex_lock(c->mutex);
+        c->stop = 1;
+        ABT_cond_signal(c->cond);
+        ABT_mutex_unlock(c->mutex);
+        ABT_thread_join(c->flusher);
+        ABT_thread_free(&c->flusher);
+    }
+    ret = combiner_flush(c);
+    free(c->runs);
+    ABT_cond_free(&c->flushed);
+    ABT_cond_free(&c->cond);
+    ABT_mutex_free(&c->mutex);
+    free(c);
+    return ret;
+}
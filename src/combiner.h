@@ -0,0 +1,42 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef _COMBINER_H
+#define _COMBINER_H
+
+#include <margo.h>
+#include "cachercise/cachercise-common.h"
+#include "cachercise/cachercise-cache.h"
+
+/* Per-handle write combining: small writes are buffered as sorted,
+ * non-overlapping runs of values (adjacent or overlapping writes merge into
+ * one run, newest data winning) and sent in a few RPCs once the buffer holds
+ * max_bytes, once the oldest buffered write is interval_ms old, or when
+ * someone asks for a flush. */
+
+typedef struct cachercise_combiner* cachercise_combiner_t;
+
+cachercise_return_t combiner_create(
+        cachercise_cache_handle_t handle,
+        size_t max_bytes,
+        unsigned interval_ms,
+        cachercise_combiner_t* combiner);
+
+/* buffer count values starting at element offset; may flush */
+cachercise_return_t combiner_write(
+        cachercise_combiner_t combiner,
+        const int64_t* values,
+        size_t count,
+        int64_t offset);
+
+/* send everything buffered; also reports errors from background flushes */
+cachercise_return_t combiner_flush(cachercise_combiner_t combiner);
+
+size_t combiner_max_bytes(cachercise_combiner_t combiner);
+
+/* flush and free */
+cachercise_return_t combiner_destroy(cachercise_combiner_t combiner);
+
+#endif
@@ -0,0 +1,238 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "client.h"
+#include "cachercise/cachercise-distributed.h"
+
+typedef struct cachercise_dist_handle {
+    size_t                     num_members;
+    size_t                     block_size;
+    size_t                     element_size;  /* bytes */
+    cachercise_cache_handle_t* members;
+} cachercise_dist_handle;
+
+/* maps a global offset (not negative) to its member and the offset in that
+ * member; *run is how many consecutive offsets stay on the same member */
+static inline size_t dist_locate(cachercise_dist_handle_t dh, int64_t pos,
+        int64_t* local, size_t* run)
+{
+    size_t block  = pos / dh->block_size;
+    size_t within = pos % dh->block_size;
+    *local = (block / dh->num_members) * dh->block_size + within;
+    if (run) *run = dh->block_size - within;
+    return block % dh->num_members;
+}
+
+cachercise_return_t cachercise_dist_handle_create(
+        const cachercise_cache_handle_t* members,
+        size_t num_members,
+        size_t block_size,
+        cachercise_dist_handle_t* handle)
+{
+    return cachercise_dist_handle_create_typed(members, num_members,
+            block_size, sizeof(int64_t), handle);
+}
+
+cachercise_return_t cachercise_dist_handle_create_typed(
+        const cachercise_cache_handle_t* members,
+        size_t num_members,
+        size_t block_size,
+        size_t element_size,
+        cachercise_dist_handle_t* handle)
+{
+    size_t i;
+    if(!members || num_members == 0 || block_size == 0 || element_size == 0)
+        return CACHERCISE_ERR_INVALID_ARGS;
+
+    cachercise_dist_handle_t dh = (cachercise_dist_handle_t)calloc(1, sizeof(*dh));
+    if(!dh) return CACHERCISE_ERR_ALLOCATION;
+    dh->members = (cachercise_cache_handle_t*)malloc(num_members*sizeof(*dh->members));
+    if(!dh->members) {
+        free(dh);
+        return CACHERCISE_ERR_ALLOCATION;
+    }
+
+    dh->num_members  = num_members;
+    dh->block_size   = block_size;
+    dh->element_size = element_size;
+    for(i = 0; i < num_members; i++) {
+        dh->members[i] = members[i];
+        cachercise_cache_handle_ref_incr(members[i]);
+    }
+
+    *handle = dh;
+    return CACHERCISE_SUCCESS;
+}
+
+cachercise_return_t cachercise_dist_handle_release(cachercise_dist_handle_t dh)
+{
+    cachercise_return_t ret = CACHERCISE_SUCCESS;
+    size_t i;
+    if(dh == CACHERCISE_DIST_HANDLE_NULL)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    for(i = 0; i < dh->num_members; i++) {
+        cachercise_return_t r = cachercise_cache_handle_release(dh->members[i]);
+        if(r != CACHERCISE_SUCCESS) ret = r;
+    }
+    free(dh->members);
+    free(dh);
+    return ret;
+}
+
+cachercise_return_t cachercise_dist_locate(
+        cachercise_dist_handle_t dh,
+        int64_t offset,
+        cachercise_cache_handle_t* member,
+        int64_t* local)
+{
+    if(dh == CACHERCISE_DIST_HANDLE_NULL || offset < 0)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    *member = dh->members[dist_locate(dh, offset, local, NULL)];
+    return CACHERCISE_SUCCESS;
+}
+
+cachercise_return_t cachercise_dist_io(
+        cachercise_dist_handle_t dh,
+        void *buf,
+        uint64_t count,
+        int64_t offset,
+        int kind)
+{
+    size_t done = 0, nreqs = 0, i;
+    cachercise_return_t ret = CACHERCISE_SUCCESS;
+
+    if(dh == CACHERCISE_DIST_HANDLE_NULL || offset < 0
+    || count % dh->element_size)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    size_t esize  = dh->element_size;
+    size_t nitems = count / esize;
+    if(nitems == 0)
+        return 0;
+
+    /* within a single block this is just a plain io */
+    int64_t local;
+    size_t run;
+    size_t m = dist_locate(dh, offset, &local, &run);
+    if(run >= nitems)
+        return cachercise_io(dh->members[m], buf, count, local, kind);
+
+    size_t max_reqs = 2 + (nitems - run - 1) / dh->block_size;
+    cachercise_request_t* reqs = (cachercise_request_t*)malloc(max_reqs*sizeof(*reqs));
+    size_t* expected = (size_t*)malloc(max_reqs*sizeof(*expected));
+    if(!reqs || !expected) {
+        free(reqs);
+        free(expected);
+        return CACHERCISE_ERR_ALLOCATION;
+    }
+
+    /* one request per block, all in flight together */
+    while(done < nitems) {
+        m = dist_locate(dh, offset + done, &local, &run);
+        if(run > nitems - done) run = nitems - done;
+        ret = cachercise_io_async(dh->members[m], (char*)buf + done*esize,
+                run*esize, local, kind, &reqs[nreqs]);
+        if(ret != CACHERCISE_SUCCESS) break;
+        expected[nreqs++] = run*esize;
+        done += run;
+    }
+    /* each piece returns its byte count, anything else is an error code
+     * (or a short transfer, which is no better) */
+    for(i = 0; i < nreqs; i++) {
+        cachercise_return_t r = cachercise_wait(reqs[i]);
+        if((size_t)r != expected[i] && ret == CACHERCISE_SUCCESS)
+            ret = (r > CACHERCISE_SUCCESS && r <= CACHERCISE_ERR_OTHER)
+                ? r : CACHERCISE_ERR_OTHER;
+    }
+    free(reqs);
+    free(expected);
+    return ret == CACHERCISE_SUCCESS ? (cachercise_return_t)count : ret;
+}
+
+cachercise_return_t cachercise_dist_io_batch(
+        cachercise_dist_handle_t dh,
+        const int64_t *offsets,
+        int64_t *values,
+        size_t count,
+        int kind)
+{
+    cachercise_return_t ret = CACHERCISE_SUCCESS;
+    size_t n, i, m;
+
+    if(dh == CACHERCISE_DIST_HANDLE_NULL)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    if(count == 0)
+        return CACHERCISE_SUCCESS;
+    for(i = 0; i < count; i++)
+        if(offsets[i] < 0) return CACHERCISE_ERR_INVALID_ARGS;
+    if(dh->num_members == 1)
+        return cachercise_io_batch(dh->members[0], offsets, values, count, kind);
+
+    n = dh->num_members;
+    size_t* start  = (size_t*)calloc(n + 1, sizeof(*start));
+    size_t* fill   = (size_t*)malloc(n * sizeof(*fill));
+    size_t* which  = (size_t*)malloc(count * sizeof(*which));
+    size_t* order  = (size_t*)malloc(count * sizeof(*order));
+    int64_t* locals        = (int64_t*)malloc(count * sizeof(int64_t));
+    int64_t* local_offsets = (int64_t*)malloc(count * sizeof(int64_t));
+    int64_t* local_values  = (int64_t*)malloc(count * sizeof(int64_t));
+    cachercise_request_t* reqs = (cachercise_request_t*)malloc(n * sizeof(*reqs));
+    size_t nreqs = 0;
+    if(!start || !fill || !which || !order || !locals || !local_offsets
+            || !local_values || !reqs) {
+        ret = CACHERCISE_ERR_ALLOCATION;
+        goto finish;
+    }
+
+    /* group the batch by member (counting sort, batch order kept within a
+     * member so a later write to the same offset still wins) */
+    for(i = 0; i < count; i++) {
+        which[i] = dist_locate(dh, offsets[i], &locals[i], NULL);
+        start[which[i] + 1]++;
+    }
+    for(m = 0; m < n; m++)
+        start[m + 1] += start[m];
+    memcpy(fill, start, n * sizeof(*fill));
+    for(i = 0; i < count; i++)
+        order[fill[which[i]]++] = i;
+    for(i = 0; i < count; i++) {
+        local_offsets[i] = locals[order[i]];
+        if(kind == CACHERCISE_WRITE)
+            local_values[i] = values[order[i]];
+    }
+
+    for(m = 0; m < n; m++) {
+        if(start[m] == start[m + 1]) continue;
+        ret = cachercise_io_batch_async(dh->members[m], local_offsets + start[m],
+                local_values + start[m], start[m + 1] - start[m], kind, &reqs[nreqs]);
+        if(ret != CACHERCISE_SUCCESS) break;
+        nreqs++;
+    }
+    for(i = 0; i < nreqs; i++) {
+        cachercise_return_t r = cachercise_wait(reqs[i]);
+        if(r != CACHERCISE_SUCCESS && ret == CACHERCISE_SUCCESS) ret = r;
+    }
+    if(ret == CACHERCISE_SUCCESS && kind == CACHERCISE_READ)
+        for(i = 0; i < count; i++)
+            values[order[i]] = local_values[i];
+
+finish:
+    free(start); free(fill); free(which); free(order);
+    free(locals); free(local_offsets); free(local_values);
+    free(reqs);
+    return ret;
+}
+
+cachercise_return_t cachercise_dist_flush(cachercise_dist_handle_t dh)
+{
+    cachercise_return_t ret = CACHERCISE_SUCCESS;
+    size_t i;
+    if(dh == CACHERCISE_DIST_HANDLE_NULL)
+        return CACHERCISE_ERR_INVALID_ARGS;
+    for(i = 0; i < dh->num_members; i++) {
+        cachercise_return_t r = cachercise_flush(dh->members[i]);
+        if(r != CACHERCISE_SUCCESS) ret = r;
+    }
+    return ret;
+}
@@ -4,26 +4,168 @@
  * See COPYRIGHT in top-level directory.
  */
 #include <string.h>
+#include <time.h>
 #include <json-c/json.h>
 #include "cachercise/cachercise-backend.h"
 #include "../provider.h"
 #include "dummy-backend.h"
 #include "../hoard-c.h"
+#include "../atomic-ops.h"
+#include "dummy-snapshot.h"
+#include "dummy-wal.h"
+#include "dummy-spill.h"
+#include "dummy-combine.h"
+#include "dummy-brlock.h"
+
+/* The offset space is dealt out block-cyclically over "stripes": blocks of
+ * stripe_size consecutive elements go round-robin to num_stripes independent
+ * Hoards, each with its own lock.  Writes landing in different stripes no
+ * longer contend with each other.
+ *
+ * With "shard_pools" each stripe is instead owned by one Argobots pool
+ * (which should be served by a single xstream of its own): every io and
+ * every batched write on the stripe is posted as a ULT to that pool, so the
+ * stripe is only ever modified from one xstream and needs no lock at all.
+ * There is one stripe per pool, so "stripes" can be left out.
+ * Batched reads still go straight to the Hoard, which allows that.
+ *
+ * Reads never lock: the Hoard's per-page sequence words let them see each
+ * stripe block's share of a range as one consistent snapshot.  A write
+ * spanning stripe blocks is applied block by block, so it is only ever
+ * atomic per block anyway.
+ *
+ * A "durable" cache also appends every write to a write-ahead log, while
+ * still holding the stripe (so the log orders writes to an offset the way
+ * they were applied), and only acknowledges the write once the log's
+ * group commit has synced it.  Opening the cache replays the log on top of
+ * the snapshot, if any; a successful snapshot makes the log redundant.
+ *
+ * With a "memory_limit" an evictor ULT keeps each stripe's resident pages
+ * under its share of the limit, pushing CLOCK-chosen pages out to a "spill"
+ * file.  Writers only signal it when they notice a stripe over its share;
+ * the evictor writes pages out with no lock held and takes the stripe lock
+ * just to drop each page.  Reads of a dropped page take the lock to fault
+ * it back in.  The limit is a soft one: writers are never held back.
+ *
+ * "sync" picks how writers get hold of a stripe, so that strategies can be
+ * compared on the same server (see dummy_sync_names):
+ *   "mutex"      each writer takes the stripe's ABT_mutex (the default);
+ *   "rwlock"     an ABT_rwlock, which reads take too, in read mode;
+ *   "brlock"     the same with a reader-biased lock (dummy-brlock.h), whose
+ *                readers on different xstreams share no cache line, for
+ *                read-mostly loads;
+ *   "spinlock"   a test-and-test-and-set lock that yields now and then;
+ *   "combining"  a flat combiner in front of the mutex: writers publish their
+ *                write and one of them applies everything published so far
+ *                in a single hold of the lock, which beats handing the lock
+ *                from ULT to ULT once many xstreams write to the same stripe;
+ *   "lockfree"   writes to pages already in memory go straight to the slots
+ *                with atomic stores; only creating a page takes the mutex.
+ * Striping ("stripes") applies on top of any of them.
+ *
+ * "type" picks the elements the cache holds (see dummy_type_names): 64-bit
+ * integers by default, doubles, 32-bit floats, or opaque records of 16, 32
+ * or 64 bytes, each stored densely by its own instantiation of the Hoard.
+ * io counts and offsets are then in elements of that type; io_batch needs
+ * 8-byte elements and atomic ops integers.
+ *
+ * "storage" picks how each stripe finds its pages: "dense" (the default), a
+ * directory indexed by page number, which is the quickest but as long as
+ * the highest page written; or "sparse", a radix tree whose size follows
+ * the pages written, for caches written at offsets far apart. */
+enum {
+    DUMMY_SYNC_MUTEX,
+    DUMMY_SYNC_RWLOCK,
+    DUMMY_SYNC_BRLOCK,
+    DUMMY_SYNC_SPINLOCK,
+    DUMMY_SYNC_COMBINING,
+    DUMMY_SYNC_LOCKFREE
+};
+static const char* const dummy_sync_names[] = {
+    "mutex", "rwlock", "brlock", "spinlock", "combining", "lockfree"
+};
+#define DUMMY_NUM_SYNC (sizeof(dummy_sync_names)/sizeof(dummy_sync_names[0]))
+
+/* indexed by hoard_type_t */
+static const char* const dummy_type_names[] = {
+    "int64", "double", "float32", "record16", "record32", "record64"
+};
+#define DUMMY_NUM_TYPES (sizeof(dummy_type_names)/sizeof(dummy_type_names[0]))
+
+typedef struct dummy_stripe {
+    hoard_t   h;
+    ABT_mutex mutex;   /* unless "rwlock", "brlock" or "spinlock" */
+    ABT_rwlock rwlock; /* "rwlock" */
+    dummy_brlock* brlock; /* "brlock" */
+    int       spin;    /* "spinlock" */
+    ABT_pool  pool;  /* ABT_POOL_NULL unless sharded */
+    struct dummy_context* context;
+    size_t    index;
+    dummy_combiner* combiner;  /* NULL unless "sync" is "combining" */
+} dummy_stripe;
 
 typedef struct dummy_context {
     struct json_object* config;
-    hoard_t h;
-    ABT_mutex hoard_mutex;
+    size_t        num_stripes;
+    size_t        stripe_size;
+    size_t        page_size;
+    int           sharded;
+    dummy_stripe* stripes;
+    const char*   snapshot;  /* path saved to on close, restored on open */
+    abt_io_instance_id abtio;
+    const char*   wal_path;  /* set if durable */
+    size_t        flush_interval_ms;
+    ABT_pool      wal_pool;
+    dummy_wal*    wal;
+    const char*   spill_path;  /* set if there is a memory limit */
+    size_t        memory_limit;
+    size_t        max_pages;   /* resident pages allowed per stripe */
+    dummy_spill*  spill;
+    ABT_mutex     evict_mutex;
+    ABT_cond      evict_cond;
+    int           evict_stop;
+    ABT_thread    evictor;
+    int           sync;  /* DUMMY_SYNC_* */
+    hoard_type_t  type;
+    size_t        element_size;  /* bytes */
+    int           sparse;  /* "storage" is "sparse" */
     /* ... */
 } dummy_context;
 
+#define DUMMY_DEFAULT_STRIPES     1
+#define DUMMY_DEFAULT_STRIPE_SIZE 1
+#define DUMMY_DEFAULT_PAGE_SIZE   4096
+/* elements; pages are allocated whole, on the first write to them */
+#define DUMMY_MAX_PAGE_SIZE       (1UL << 24)
+#define DUMMY_DEFAULT_FLUSH_MS    1
+#define DUMMY_EVICT_INTERVAL      0.1  /* seconds between evictor checks */
 
-static cachercise_return_t dummy_create_cache(
+static void dummy_free_context(dummy_context* ctx);
+static int dummy_start_evictor(dummy_context* ctx, ABT_pool pool);
+static void dummy_apply_write(dummy_fc_op* fc);
+
+/* reads an optional positive integer from the config, filling in the default
+ * if absent so the stored config always reflects what the cache is using */
+static int dummy_config_get_size(struct json_object* config, const char* key,
+        size_t default_value, size_t* value)
+{
+    struct json_object* val = json_object_object_get(config, key);
+    if (!val) {
+        json_object_object_add(config, key, json_object_new_int64(default_value));
+        *value = default_value;
+        return 0;
+    }
+    if (!json_object_is_type(val, json_type_int) || json_object_get_int64(val) < 1)
+        return -1;
+    *value = json_object_get_int64(val);
+    return 0;
+}
+
+static cachercise_return_t dummy_init_context(
         cachercise_provider_t provider,
         const char* config_str,
-        void** context)
+        dummy_context** context)
 {
-    (void)provider;
     struct json_object* config = NULL;
 
     // read JSON config from provided string argument
@@ -48,63 +190,586 @@ static cachercise_return_t dummy_create_cache(
 
     dummy_context* ctx = (dummy_context*)calloc(1, sizeof(*ctx));
     ctx->config = config;
-    ctx->h      = hoard_init();
-    ABT_mutex_create(&ctx->hoard_mutex);
-    *context = (void*)ctx;
+
+    /* "snapshot" needs the provider's abt-io instance to write through */
+    struct json_object* snapshot = json_object_object_get(config, "snapshot");
+    if (snapshot) {
+        if (!json_object_is_type(snapshot, json_type_string)
+         || provider->abtio == ABT_IO_INSTANCE_NULL) {
+            margo_error(provider->mid, "\"snapshot\" must be a path, and the "
+                    "provider needs an abt-io instance to use it");
+            json_object_put(config);
+            free(ctx);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+        ctx->snapshot = json_object_get_string(snapshot);
+        ctx->abtio    = provider->abtio;
+    }
+
+    /* so does "durable", which also needs a log file */
+    struct json_object* durable = json_object_object_get(config, "durable");
+    if (durable && json_object_get_boolean(durable)) {
+        struct json_object* wal = json_object_object_get(config, "wal");
+        if (!wal || !json_object_is_type(wal, json_type_string)
+         || provider->abtio == ABT_IO_INSTANCE_NULL
+         || dummy_config_get_size(config, "flush_interval_ms",
+                DUMMY_DEFAULT_FLUSH_MS, &ctx->flush_interval_ms) != 0) {
+            margo_error(provider->mid, "\"durable\" needs \"wal\" to be a path, "
+                    "a positive \"flush_interval_ms\" and a provider with an "
+                    "abt-io instance");
+            json_object_put(config);
+            free(ctx);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+        ctx->wal_path = json_object_get_string(wal);
+        ctx->wal_pool = provider->pool;
+        ctx->abtio    = provider->abtio;
+    }
+
+    /* and "memory_limit" (bytes), which needs a file to spill pages to */
+    struct json_object* limit = json_object_object_get(config, "memory_limit");
+    if (limit) {
+        struct json_object* spill = json_object_object_get(config, "spill");
+        if (!json_object_is_type(limit, json_type_int) || json_object_get_int64(limit) < 1
+         || !spill || !json_object_is_type(spill, json_type_string)
+         || provider->abtio == ABT_IO_INSTANCE_NULL
+         || json_object_object_get(config, "shard_pools")) {
+            margo_error(provider->mid, "\"memory_limit\" needs \"spill\" to be a "
+                    "path and a provider with an abt-io instance, and cannot be "
+                    "combined with \"shard_pools\"");
+            json_object_put(config);
+            free(ctx);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+        ctx->memory_limit = json_object_get_int64(limit);
+        ctx->spill_path   = json_object_get_string(spill);
+        ctx->abtio        = provider->abtio;
+    }
+
+    /* how writers get hold of a stripe */
+    struct json_object* sync = json_object_object_get(config, "sync");
+    if (!sync) {
+        json_object_object_add(config, "sync",
+                json_object_new_string(dummy_sync_names[DUMMY_SYNC_MUTEX]));
+    } else {
+        if (json_object_is_type(sync, json_type_string))
+            while (ctx->sync < (int)DUMMY_NUM_SYNC && strcmp(json_object_get_string(sync),
+                        dummy_sync_names[ctx->sync]) != 0)
+                ctx->sync++;
+        /* shards take no lock at all, and lock-free writes would reach the
+         * log out of order */
+        if (!json_object_is_type(sync, json_type_string)
+         || ctx->sync == (int)DUMMY_NUM_SYNC
+         || (ctx->sync != DUMMY_SYNC_MUTEX && json_object_object_get(config, "shard_pools"))
+         || (ctx->sync == DUMMY_SYNC_LOCKFREE && ctx->wal_path)) {
+            margo_error(provider->mid, "\"sync\" must be one of \"mutex\", "
+                    "\"rwlock\", \"brlock\", \"spinlock\", \"combining\" or \"lockfree\"; "
+                    "shards only allow \"mutex\", durable caches anything but "
+                    "\"lockfree\"");
+            json_object_put(config);
+            free(ctx);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+    }
+
+    /* what the elements are */
+    struct json_object* type = json_object_object_get(config, "type");
+    size_t t = 0;
+    if (!type) {
+        json_object_object_add(config, "type",
+                json_object_new_string(dummy_type_names[HOARD_INT64]));
+    } else {
+        if (json_object_is_type(type, json_type_string))
+            while (t < DUMMY_NUM_TYPES && strcmp(json_object_get_string(type),
+                        dummy_type_names[t]) != 0)
+                t++;
+        if (!json_object_is_type(type, json_type_string) || t == DUMMY_NUM_TYPES) {
+            margo_error(provider->mid, "\"type\" must be one of \"int64\", "
+                    "\"double\", \"float32\", \"record16\", \"record32\" "
+                    "or \"record64\"");
+            json_object_put(config);
+            free(ctx);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+    }
+    ctx->type = (hoard_type_t)t;
+
+    /* how pages are found */
+    struct json_object* storage = json_object_object_get(config, "storage");
+    if (!storage) {
+        json_object_object_add(config, "storage", json_object_new_string("dense"));
+    } else if (!json_object_is_type(storage, json_type_string)
+            || (strcmp(json_object_get_string(storage), "dense") != 0
+             && strcmp(json_object_get_string(storage), "sparse") != 0)) {
+        margo_error(provider->mid, "\"storage\" must be \"dense\" or \"sparse\"");
+        json_object_put(config);
+        free(ctx);
+        return CACHERCISE_ERR_INVALID_CONFIG;
+    } else {
+        ctx->sparse = strcmp(json_object_get_string(storage), "sparse") == 0;
+    }
+
+    /* one stripe per shard pool: "stripes" may be left out, but if it is
+     * given it has to agree */
+    struct json_object* shard_pools = json_object_object_get(config, "shard_pools");
+    if (shard_pools) {
+        if (!json_object_is_type(shard_pools, json_type_array)
+         || json_object_array_length(shard_pools) == 0) {
+            margo_error(provider->mid, "\"shard_pools\" must be a non-empty array of pool names");
+            json_object_put(config);
+            free(ctx);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+        size_t npools = json_object_array_length(shard_pools);
+        struct json_object* stripes = json_object_object_get(config, "stripes");
+        if (stripes && (!json_object_is_type(stripes, json_type_int)
+                     || json_object_get_int64(stripes) != (int64_t)npools)) {
+            margo_error(provider->mid, "\"stripes\" must match the number of "
+                    "\"shard_pools\" (or be left out)");
+            json_object_put(config);
+            free(ctx);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+        json_object_object_add(config, "stripes", json_object_new_int64(npools));
+        ctx->sharded = 1;
+    }
+    if (dummy_config_get_size(config, "stripes",
+                DUMMY_DEFAULT_STRIPES, &ctx->num_stripes) != 0
+     || dummy_config_get_size(config, "stripe_size",
+                DUMMY_DEFAULT_STRIPE_SIZE, &ctx->stripe_size) != 0
+     || dummy_config_get_size(config, "page_size",
+                DUMMY_DEFAULT_PAGE_SIZE, &ctx->page_size) != 0
+     || ctx->page_size > DUMMY_MAX_PAGE_SIZE) {
+        margo_error(provider->mid, "\"stripes\", \"stripe_size\" and "
+                "\"page_size\" must be positive integers, \"page_size\" "
+                "no larger than %lu", DUMMY_MAX_PAGE_SIZE);
+        json_object_put(config);
+        free(ctx);
+        return CACHERCISE_ERR_INVALID_CONFIG;
+    }
+
+    ctx->stripes = (dummy_stripe*)calloc(ctx->num_stripes, sizeof(*ctx->stripes));
+    size_t i;
+    for (i = 0; i < ctx->num_stripes; i++) {
+        ctx->stripes[i].pool = ABT_POOL_NULL;
+        if (!ctx->sharded) continue;
+        const char* name = json_object_get_string(
+                json_object_array_get_idx(shard_pools, i));
+        if (!name || margo_get_pool_by_name(provider->mid, name,
+                    &ctx->stripes[i].pool) != 0) {
+            margo_error(provider->mid, "Could not find shard pool \"%s\"",
+                    name ? name : "");
+            json_object_put(config);
+            free(ctx->stripes);
+            free(ctx);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+    }
+    for (i = 0; i < ctx->num_stripes; i++) {
+        ctx->stripes[i].h = hoard_init_typed(ctx->page_size, ctx->type, ctx->sparse);
+        ctx->stripes[i].context = ctx;
+        ctx->stripes[i].index   = i;
+        if (ctx->sync == DUMMY_SYNC_RWLOCK)
+            ABT_rwlock_create(&ctx->stripes[i].rwlock);
+        else if (ctx->sync == DUMMY_SYNC_BRLOCK)
+            ctx->stripes[i].brlock = dummy_brlock_create();
+        else if (ctx->sync != DUMMY_SYNC_SPINLOCK)
+            ABT_mutex_create(&ctx->stripes[i].mutex);
+        if (ctx->sync == DUMMY_SYNC_BRLOCK && !ctx->stripes[i].brlock) {
+            margo_error(provider->mid, "Could not allocate reader-biased locks");
+            ctx->num_stripes = i + 1;
+            dummy_free_context(ctx);
+            return CACHERCISE_ERR_ALLOCATION;
+        }
+        if (ctx->sync == DUMMY_SYNC_COMBINING)
+            ctx->stripes[i].combiner = dummy_combiner_create(
+                    ctx->stripes[i].mutex, dummy_apply_write);
+    }
+    ctx->element_size = hoard_element_size(ctx->stripes[0].h);
+    if (ctx->spill_path && dummy_start_evictor(ctx, provider->pool) != 0) {
+        margo_error(provider->mid, "Could not set up spilling to %s", ctx->spill_path);
+        dummy_free_context(ctx);
+        return CACHERCISE_ERR_OTHER;
+    }
+    *context = ctx;
     return CACHERCISE_SUCCESS;
 }
 
-static cachercise_return_t dummy_open_cache(
+/* excludes every other writer of the stripe, whatever the "sync" */
+static inline void dummy_stripe_lock(dummy_stripe* stripe)
+{
+    unsigned spins = 0;
+    switch (stripe->context->sync) {
+    case DUMMY_SYNC_RWLOCK:
+        ABT_rwlock_wrlock(stripe->rwlock);
+        break;
+    case DUMMY_SYNC_BRLOCK:
+        dummy_brlock_wrlock(stripe->brlock);
+        break;
+    case DUMMY_SYNC_SPINLOCK:
+        while (__atomic_exchange_n(&stripe->spin, 1, __ATOMIC_ACQUIRE))
+            while (__atomic_load_n(&stripe->spin, __ATOMIC_RELAXED))
+                /* the holder may be a ULT of this very xstream */
+                if (++spins % 1024 == 0) ABT_thread_yield();
+        break;
+    default:
+        ABT_mutex_lock(stripe->mutex);
+    }
+}
+
+static inline void dummy_stripe_unlock(dummy_stripe* stripe)
+{
+    switch (stripe->context->sync) {
+    case DUMMY_SYNC_RWLOCK:
+        ABT_rwlock_unlock(stripe->rwlock);
+        break;
+    case DUMMY_SYNC_BRLOCK:
+        dummy_brlock_wrunlock(stripe->brlock);
+        break;
+    case DUMMY_SYNC_SPINLOCK:
+        __atomic_store_n(&stripe->spin, 0, __ATOMIC_RELEASE);
+        break;
+    default:
+        ABT_mutex_unlock(stripe->mutex);
+    }
+}
+
+static int dummy_stripe_fault(void* arg, size_t page, void* data)
+{
+    dummy_stripe* stripe = (dummy_stripe*)arg;
+    return dummy_spill_read(stripe->context->spill, stripe->index, page, data);
+}
+
+/* hoard_get, first bringing back any evicted page in the range */
+static int64_t dummy_stripe_get(dummy_stripe* stripe, void* dest,
+        size_t n, size_t local)
+{
+    int64_t ret;
+    if (stripe->context->sync == DUMMY_SYNC_RWLOCK) {
+        ABT_rwlock_rdlock(stripe->rwlock);
+        ret = hoard_get(stripe->h, dest, n, local);
+        ABT_rwlock_unlock(stripe->rwlock);
+    } else if (stripe->context->sync == DUMMY_SYNC_BRLOCK) {
+        int ticket = dummy_brlock_rdlock(stripe->brlock);
+        ret = hoard_get(stripe->h, dest, n, local);
+        dummy_brlock_rdunlock(stripe->brlock, ticket);
+    } else {
+        ret = hoard_get(stripe->h, dest, n, local);
+    }
+    if (ret != HOARD_EVICTED) return ret;
+    /* with the lock held nothing can be evicted again before the get */
+    dummy_stripe_lock(stripe);
+    ret = hoard_fault(stripe->h, n, local);
+    if (ret == 0) ret = hoard_get(stripe->h, dest, n, local);
+    dummy_stripe_unlock(stripe);
+    return ret;
+}
+
+/* called after a write: wakes the evictor if the stripe went over its share
+ * (the evictor also checks on its own, so a lost wakeup only delays it) */
+static inline void dummy_check_limit(dummy_context* context, dummy_stripe* stripe)
+{
+    if (context->spill && hoard_resident_pages(stripe->h) > context->max_pages)
+        ABT_cond_signal(context->evict_cond);
+}
+
+/* pushes pages of one stripe out until it is down to target resident pages
+ * or nothing more can go; returns how many pages were dropped */
+static size_t dummy_evict_stripe(dummy_context* ctx, dummy_stripe* stripe,
+        size_t target, void* copy)
+{
+    size_t evicted = 0;
+    size_t tries = 2 * hoard_resident_pages(stripe->h);
+    while (tries-- && hoard_resident_pages(stripe->h) > target) {
+        size_t page = hoard_clock_victim(stripe->h);
+        if (page == SIZE_MAX) break;
+        int dirty = hoard_evict_prepare(stripe->h, page, copy);
+        if (dirty < 0) continue;
+        if (dirty && dummy_spill_write(ctx->spill, stripe->index, page, copy) != 0) {
+            dummy_stripe_lock(stripe);
+            hoard_evict_abort(stripe->h, page);
+            dummy_stripe_unlock(stripe);
+            break;
+        }
+        dummy_stripe_lock(stripe);
+        evicted += hoard_evict_commit(stripe->h, page);
+        dummy_stripe_unlock(stripe);
+    }
+    return evicted;
+}
+
+static int dummy_over_limit(dummy_context* ctx)
+{
+    size_t i;
+    for (i = 0; i < ctx->num_stripes; i++)
+        if (hoard_resident_pages(ctx->stripes[i].h) > ctx->max_pages)
+            return 1;
+    return 0;
+}
+
+static void dummy_evictor_ult(void* arg)
+{
+    dummy_context* ctx = (dummy_context*)arg;
+    /* evict a little below the limit so it is not crossed again at once */
+    size_t target = ctx->max_pages - ctx->max_pages / 8;
+    void* copy = malloc(hoard_page_size(ctx->stripes[0].h) * ctx->element_size);
+    int idle = 1;
+    size_t i;
+
+    ABT_mutex_lock(ctx->evict_mutex);
+    while (copy && !ctx->evict_stop) {
+        if (idle || !dummy_over_limit(ctx)) {
+            struct timespec deadline;
+            double wakeup;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            wakeup = deadline.tv_sec + deadline.tv_nsec*1e-9 + DUMMY_EVICT_INTERVAL;
+            deadline.tv_sec  = (time_t)wakeup;
+            deadline.tv_nsec = (long)((wakeup - deadline.tv_sec)*1e9);
+            ABT_cond_timedwait(ctx->evict_cond, ctx->evict_mutex, &deadline);
+            idle = 0;
+            continue;
+        }
+        ABT_mutex_unlock(ctx->evict_mutex);
+        size_t evicted = 0;
+        for (i = 0; i < ctx->num_stripes; i++)
+            if (hoard_resident_pages(ctx->stripes[i].h) > ctx->max_pages)
+                evicted += dummy_evict_stripe(ctx, &ctx->stripes[i], target, copy);
+        /* every page was in use or the spill file failed: back off */
+        idle = evicted == 0;
+        ABT_mutex_lock(ctx->evict_mutex);
+    }
+    ABT_mutex_unlock(ctx->evict_mutex);
+    free(copy);
+}
+
+static int dummy_start_evictor(dummy_context* ctx, ABT_pool pool)
+{
+    size_t i, page_size = hoard_page_size(ctx->stripes[0].h);
+    ctx->max_pages = ctx->memory_limit / (page_size * ctx->element_size) / ctx->num_stripes;
+    if (ctx->max_pages == 0) ctx->max_pages = 1;
+    ctx->spill = dummy_spill_open(ctx->abtio, ctx->spill_path,
+            ctx->num_stripes, page_size, ctx->element_size);
+    if (!ctx->spill) return -1;
+    for (i = 0; i < ctx->num_stripes; i++)
+        hoard_set_spill(ctx->stripes[i].h, dummy_stripe_fault, &ctx->stripes[i]);
+    ABT_mutex_create(&ctx->evict_mutex);
+    ABT_cond_create(&ctx->evict_cond);
+    if (ABT_thread_create(pool, dummy_evictor_ult, ctx, ABT_THREAD_ATTR_NULL,
+                &ctx->evictor) != ABT_SUCCESS) {
+        ctx->evictor = ABT_THREAD_NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/* the evictor must be stopped before anything walks the Hoards */
+static void dummy_stop_evictor(dummy_context* ctx)
+{
+    if (ctx->evictor == ABT_THREAD_NULL) return;
+    ABT_mutex_lock(ctx->evict_mutex);
+    ctx->evict_stop = 1;
+    ABT_cond_signal(ctx->evict_cond);
+    ABT_mutex_unlock(ctx->evict_mutex);
+    ABT_thread_join(ctx->evictor);
+    ABT_thread_free(&ctx->evictor);
+    ctx->evictor = ABT_THREAD_NULL;
+}
+
+static void dummy_free_context(dummy_context* ctx)
+{
+    size_t i;
+    dummy_stop_evictor(ctx);
+    if (ctx->spill) {
+        ABT_mutex_free(&ctx->evict_mutex);
+        ABT_cond_free(&ctx->evict_cond);
+    }
+    for (i = 0; i < ctx->num_stripes; i++) {
+        hoard_finalize(ctx->stripes[i].h);
+        if (ctx->stripes[i].combiner)
+            dummy_combiner_free(ctx->stripes[i].combiner);
+        if (ctx->sync == DUMMY_SYNC_RWLOCK)
+            ABT_rwlock_free(&ctx->stripes[i].rwlock);
+        else if (ctx->sync == DUMMY_SYNC_BRLOCK) {
+            if (ctx->stripes[i].brlock) dummy_brlock_free(ctx->stripes[i].brlock);
+        } else if (ctx->sync != DUMMY_SYNC_SPINLOCK)
+            ABT_mutex_free(&ctx->stripes[i].mutex);
+    }
+    free(ctx->stripes);
+    if (ctx->spill) dummy_spill_close(ctx->spill);
+    json_object_put(ctx->config);
+    free(ctx);
+}
+
+
+static int64_t dummy_io(void *ctx, uint64_t count, int64_t offset, int64_t *scratch, int kind);
+
+/* logs a write just applied to a stripe, under that stripe's lock; *lsn
+ * keeps the highest LSN to wait for (UINT64_MAX once logging failed) */
+static inline void dummy_log_write(dummy_context* context, int64_t offset,
+        const void* values, size_t n, uint64_t* lsn)
+{
+    const char* v = (const char*)values;
+    if (!context->wal) return;
+    while (n) {
+        /* records count values in 32 bits */
+        size_t k = n < (1UL << 30) ? n : (1UL << 30);
+        uint64_t l = dummy_wal_append(context->wal, offset, v, k);
+        if (l == 0) l = UINT64_MAX;
+        if (l > *lsn) *lsn = l;
+        offset += k;
+        v += k * context->element_size;
+        n -= k;
+    }
+}
+
+/* waits for the writes logged up to lsn to be durable; returns 0 or -1 */
+static inline int dummy_log_wait(dummy_context* context, uint64_t lsn)
+{
+    if (!context->wal || lsn == 0) return 0;
+    if (lsn == UINT64_MAX) return -1;
+    return dummy_wal_wait(context->wal, lsn);
+}
+
+static int dummy_replay_write(void* arg, int64_t offset,
+        const void* values, size_t count)
+{
+    dummy_context* ctx = (dummy_context*)arg;
+    return dummy_io(ctx, count*ctx->element_size, offset, (int64_t*)values,
+            CACHERCISE_WRITE) < 0;
+}
+
+/* starts logging, once the cache holds everything already logged */
+static cachercise_return_t dummy_start_wal(dummy_context* ctx, uint64_t end)
+{
+    if (!ctx->wal_path) return CACHERCISE_SUCCESS;
+    ctx->wal = dummy_wal_open(ctx->abtio, ctx->wal_path, ctx->element_size,
+            end, ctx->wal_pool, ctx->flush_interval_ms);
+    return ctx->wal ? CACHERCISE_SUCCESS : CACHERCISE_ERR_OTHER;
+}
+
+/* puts one snapshot page back, mapping it through the snapshot's geometry
+ * to global offsets so that a cache can be reopened with different
+ * striping */
+static int dummy_restore_page(void* arg, const dummy_snapshot_header* header,
+        size_t stripe, size_t page, const void* data)
+{
+    dummy_context* ctx = (dummy_context*)arg;
+    size_t ps = header->page_size, ss = header->stripe_size;
+    size_t done = 0;
+
+    /* a snapshot of other elements cannot be reinterpreted */
+    if (header->element_size != ctx->element_size)
+        return -1;
+    if (header->num_stripes == ctx->num_stripes && ss == ctx->stripe_size
+     && ps == hoard_page_size(ctx->stripes[stripe].h)) {
+        /* the evictor may already be running */
+        dummy_stripe_lock(&ctx->stripes[stripe]);
+        int ret = hoard_put(ctx->stripes[stripe].h, data, ps, page*ps) < 0;
+        dummy_stripe_unlock(&ctx->stripes[stripe]);
+        return ret;
+    }
+
+    while (done < ps) {
+        size_t local  = page*ps + done;
+        size_t within = local % ss;
+        size_t n = ss - within < ps - done ? ss - within : ps - done;
+        size_t global = ((local / ss) * header->num_stripes + stripe) * ss + within;
+        if (dummy_io(ctx, n*ctx->element_size, global,
+                    (int64_t*)((const char*)data + done*ctx->element_size),
+                    CACHERCISE_WRITE) < 0)
+            return -1;
+        done += n;
+    }
+    return 0;
+}
+
+static cachercise_return_t dummy_create_cache(
         cachercise_provider_t provider,
         const char* config_str,
         void** context)
 {
-    (void)provider;
-
-    struct json_object* config = NULL;
+    dummy_context* ctx;
+    cachercise_return_t ret = dummy_init_context(provider, config_str, &ctx);
+    if (ret != CACHERCISE_SUCCESS) return ret;
 
-    // read JSON config from provided string argument
-    if (config_str) {
-        struct json_tokener*    tokener = json_tokener_new();
-        enum json_tokener_error jerr;
-        config = json_tokener_parse_ex(
-                tokener, config_str,
-                strlen(config_str));
-        if (!config) {
-            jerr = json_tokener_get_error(tokener);
-            margo_error(provider->mid, "JSON parse error: %s",
-                      json_tokener_error_desc(jerr));
-            json_tokener_free(tokener);
-            return CACHERCISE_ERR_INVALID_CONFIG;
-        }
-        json_tokener_free(tokener);
-    } else {
-        // create default JSON config
-        config = json_object_new_object();
+    /* a new cache starts a new log */
+    if (dummy_start_wal(ctx, 0) != CACHERCISE_SUCCESS) {
+        margo_error(provider->mid, "Could not open log %s", ctx->wal_path);
+        dummy_free_context(ctx);
+        return CACHERCISE_ERR_OTHER;
     }
+    *context = ctx;
+    return CACHERCISE_SUCCESS;
+}
 
-    dummy_context* ctx = (dummy_context*)calloc(1, sizeof(*ctx));
-    ctx->config = config;
-    *context = (void*)ctx;
+static cachercise_return_t dummy_open_cache(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    dummy_context* ctx;
+    cachercise_return_t ret = dummy_init_context(provider, config_str, &ctx);
+    if (ret != CACHERCISE_SUCCESS) return ret;
+
+    /* no snapshot yet just means an empty cache */
+    if (ctx->snapshot
+     && dummy_snapshot_load(ctx->abtio, ctx->snapshot, dummy_restore_page, ctx) < 0) {
+        margo_error(provider->mid, "Could not restore snapshot %s", ctx->snapshot);
+        dummy_free_context(ctx);
+        return CACHERCISE_ERR_OTHER;
+    }
+    /* then the writes logged since */
+    uint64_t end = 0;
+    if (ctx->wal_path
+     && (dummy_wal_replay(ctx->abtio, ctx->wal_path, ctx->element_size,
+                dummy_replay_write, ctx, &end) != 0
+      || dummy_start_wal(ctx, end) != CACHERCISE_SUCCESS)) {
+        margo_error(provider->mid, "Could not replay log %s", ctx->wal_path);
+        dummy_free_context(ctx);
+        return CACHERCISE_ERR_OTHER;
+    }
+    *context = ctx;
     return CACHERCISE_SUCCESS;
 }
 
 static cachercise_return_t dummy_close_cache(void* ctx)
 {
     dummy_context* context = (dummy_context*)ctx;
-    json_object_put(context->config);
-    hoard_finalize(context->h);
-    free(context);
-    return CACHERCISE_SUCCESS;
+    cachercise_return_t ret = CACHERCISE_SUCCESS;
+
+    dummy_stop_evictor(context);
+    if (context->wal) {
+        if (dummy_wal_close(context->wal) != 0)
+            ret = CACHERCISE_ERR_OTHER;
+        context->wal = NULL;
+    }
+    if (context->snapshot) {
+        hoard_t* hoards = (hoard_t*)malloc(context->num_stripes * sizeof(*hoards));
+        size_t i;
+        for (i = 0; hoards && i < context->num_stripes; i++)
+            hoards[i] = context->stripes[i].h;
+        if (!hoards || dummy_snapshot_save(context->abtio, context->snapshot,
+                    hoards, context->num_stripes, context->stripe_size) != 0)
+            ret = CACHERCISE_ERR_OTHER;
+        /* the snapshot now holds everything the log did */
+        else if (context->wal_path)
+            dummy_wal_remove(context->abtio, context->wal_path);
+        free(hoards);
+    }
+    dummy_free_context(context);
+    return ret;
 }
 
 static cachercise_return_t dummy_destroy_cache(void* ctx)
 {
     dummy_context* context = (dummy_context*)ctx;
-    json_object_put(context->config);
-    hoard_finalize(context->h);
-    ABT_mutex_free(&(context->hoard_mutex));
-    free(context);
+    if (context->wal)
+        dummy_wal_close(context->wal);
+    if (context->wal_path)
+        dummy_wal_remove(context->abtio, context->wal_path);
+    if (context->snapshot)
+        dummy_snapshot_remove(context->abtio, context->snapshot);
+    dummy_free_context(context);
     return CACHERCISE_SUCCESS;
 }
 
@@ -115,25 +780,444 @@ static void dummy_say_hello(void* ctx)
     printf("Hello World from Dummy cache\n");
 }
 
+static char* dummy_get_config(void* ctx)
+{
+    dummy_context* context = (dummy_context*)ctx;
+    return strdup(json_object_to_json_string_ext(context->config,
+                JSON_C_TO_STRING_PLAIN));
+}
+
+static size_t dummy_element_size(void* ctx)
+{
+    return ((dummy_context*)ctx)->element_size;
+}
+
 static int32_t dummy_compute_sum(void* ctx, int32_t x, int32_t y)
 {
     (void)ctx;
     return x+y;
 }
 
+/* maps a cache offset to its stripe and to the offset within that stripe's
+ * Hoard; *run is how many consecutive offsets stay in the same stripe */
+static inline size_t dummy_locate(dummy_context* context, size_t pos,
+        size_t* local, size_t* run)
+{
+    size_t block  = pos / context->stripe_size;
+    size_t within = pos % context->stripe_size;
+    *local = (block / context->num_stripes) * context->stripe_size + within;
+    if (run) *run = context->stripe_size - within;
+    return block % context->num_stripes;
+}
+
+/* the part of an io or io_batch that falls in one shard, run on its pool */
+typedef struct dummy_shard_op {
+    dummy_context* context;
+    size_t         stripe;
+    int            kind;
+    int64_t        ret;
+    uint64_t       lsn;
+    /* io: the whole range, of which only the shard's blocks are touched */
+    size_t         nitems;
+    int64_t        offset;
+    char*          buf;
+    /* io_batch: entries order[begin..end) of the batch */
+    size_t         begin, end;
+    const size_t*  order;
+    const size_t*  local;
+    const int64_t* offsets;
+    int64_t*       values;    /* or operands, for atomic ops */
+    int            atomic;    /* -1 for writes, else a CACHERCISE_ATOMIC_* op */
+    const int64_t* compares;
+    int64_t*       olds;
+} dummy_shard_op;
+
+static void dummy_shard_io_ult(void* arg)
+{
+    dummy_shard_op* op = (dummy_shard_op*)arg;
+    dummy_context* context = op->context;
+    hoard_t h = context->stripes[op->stripe].h;
+    size_t done = 0;
+
+    op->ret = 0;
+    while (done < op->nitems) {
+        size_t local, n;
+        size_t s = dummy_locate(context, op->offset + done, &local, &n);
+        char* buf = op->buf + done * context->element_size;
+        if (n > op->nitems - done) n = op->nitems - done;
+        if (s == op->stripe) {
+            int64_t ret = op->kind == CACHERCISE_WRITE ?
+                hoard_put(h, buf, n, local) :
+                hoard_get(h, buf, n, local);
+            if (ret < 0) {
+                op->ret = ret;
+                return;
+            }
+            if (op->kind == CACHERCISE_WRITE)
+                dummy_log_write(context, op->offset + done, buf, n, &op->lsn);
+        }
+        done += n;
+    }
+}
+
+/* applies one stripe's share of a batch of writes or atomic ops; the
+ * caller holds the stripe (its lock, or its shard) */
+static int64_t dummy_batch_apply(dummy_shard_op* op)
+{
+    hoard_t h = op->context->stripes[op->stripe].h;
+    int64_t ret = 0;
+    size_t i;
+    for (i = op->begin; i < op->end; i++) {
+        size_t j = op->order[i];
+        if (op->atomic < 0) {
+            /* only fails if an evicted page cannot be read back */
+            if (hoard_put(h, op->values + j, 1, op->local[j]) < 0) {
+                ret = -1;
+                continue;
+            }
+            dummy_log_write(op->context, op->offsets[j], op->values + j, 1, &op->lsn);
+        } else {
+            int64_t compare = op->compares ? op->compares[j] : 0;
+            if (hoard_atomic(h, op->atomic, op->local[j], op->values[j], compare,
+                        &op->olds[j], 1) < 0) {
+                ret = -1;
+                continue;
+            }
+            if (op->context->wal) {
+                int64_t value = cachercise_atomic_result(op->atomic, op->olds[j],
+                        op->values[j], compare);
+                dummy_log_write(op->context, op->offsets[j], &value, 1, &op->lsn);
+            }
+        }
+    }
+    return ret;
+}
+
+static void dummy_shard_batch_ult(void* arg)
+{
+    dummy_shard_op* op = (dummy_shard_op*)arg;
+    op->ret = dummy_batch_apply(op);
+}
+
+/* Posts one ULT per op to the owning shards and waits for all of them.
+ * An op is never run anywhere else, not even when its ULT cannot be
+ * created: the stripe takes no lock, so only its own pool may touch it.
+ * Returns CACHERCISE_ERR_ALLOCATION if some op could not be posted (the
+ * ones before it have run), CACHERCISE_ERR_OTHER if some op failed. */
+static cachercise_return_t dummy_shard_run(dummy_context* context,
+        dummy_shard_op* ops, size_t nops, void (*fn)(void*))
+{
+    ABT_thread  few[8];
+    ABT_thread* threads = nops <= 8 ? few : (ABT_thread*)malloc(nops * sizeof(*threads));
+    cachercise_return_t ret = CACHERCISE_SUCCESS;
+    size_t i, posted;
+
+    if (!threads) return CACHERCISE_ERR_ALLOCATION;
+    for (posted = 0; posted < nops; posted++) {
+        if (ABT_thread_create(context->stripes[ops[posted].stripe].pool, fn,
+                    &ops[posted], ABT_THREAD_ATTR_NULL, &threads[posted]) != ABT_SUCCESS) {
+            ret = CACHERCISE_ERR_ALLOCATION;
+            break;
+        }
+    }
+    for (i = 0; i < posted; i++) {
+        ABT_thread_join(threads[i]);
+        ABT_thread_free(&threads[i]);
+        if (ops[i].ret < 0 && ret == CACHERCISE_SUCCESS) ret = CACHERCISE_ERR_OTHER;
+    }
+    if (threads != few) free(threads);
+    return ret;
+}
+
+static int64_t dummy_io_sharded(dummy_context* context, size_t nitems,
+        int64_t offset, char* buf, int kind)
+{
+    dummy_shard_op  few[8];
+    dummy_shard_op* ops;
+    size_t local, n, i;
+    int64_t ret;
+
+    if (nitems == 0) return 0;
+    /* the range covers consecutive blocks, so consecutive stripes */
+    size_t first = dummy_locate(context, offset, &local, &n);
+    size_t nblocks = n >= nitems ? 1 :
+        2 + (nitems - n - 1) / context->stripe_size;
+    size_t nops = nblocks < context->num_stripes ? nblocks : context->num_stripes;
+
+    ops = nops <= 8 ? few : (dummy_shard_op*)calloc(nops, sizeof(*ops));
+    if (!ops) return -1;
+    for (i = 0; i < nops; i++) {
+        memset(&ops[i], 0, sizeof(ops[i]));
+        ops[i].context = context;
+        ops[i].stripe  = (first + i) % context->num_stripes;
+        ops[i].kind    = kind;
+        ops[i].nitems  = nitems;
+        ops[i].offset  = offset;
+        ops[i].buf     = buf;
+    }
+    ret = dummy_shard_run(context, ops, nops, dummy_shard_io_ult) == CACHERCISE_SUCCESS ? 0 : -1;
+    uint64_t lsn = 0;
+    for (i = 0; i < nops; i++)
+        if (ops[i].lsn > lsn) lsn = ops[i].lsn;
+    if (ops != few) free(ops);
+    if (ret >= 0 && dummy_log_wait(context, lsn) != 0) ret = -1;
+    return ret < 0 ? ret : (int64_t)nitems;
+}
+
+/* a write handed to a stripe's combiner */
+typedef struct dummy_write_op {
+    dummy_fc_op   fc;
+    dummy_stripe* stripe;
+    const char*   src;
+    size_t        n, local;
+    int64_t       offset;
+    int64_t       ret;
+    uint64_t      lsn;
+} dummy_write_op;
+
+static void dummy_apply_write(dummy_fc_op* fc)
+{
+    dummy_write_op* op = (dummy_write_op*)fc;
+    op->ret = hoard_put(op->stripe->h, op->src, op->n, op->local);
+    if (op->ret >= 0)
+        dummy_log_write(op->stripe->context, op->offset, op->src, op->n, &op->lsn);
+}
+
 static int64_t dummy_io(void *ctx, uint64_t count, int64_t offset, int64_t *scratch, int kind)
 {
     dummy_context* context = (dummy_context*)ctx;
+    size_t nitems = count/context->element_size;
+    size_t done = 0;
+    uint64_t lsn = 0;
     int64_t ret;
-    if (kind == CACHERCISE_WRITE) {
-        ABT_mutex_lock(context->hoard_mutex);
-        ret = hoard_put(context->h, scratch, count/sizeof(int64_t), offset);
-        ABT_mutex_unlock(context->hoard_mutex);
-        return ret;
+
+    if (context->sharded)
+        return dummy_io_sharded(context, nitems, offset, (char*)scratch, kind);
+
+    /* walk the range one stripe block at a time */
+    while (done < nitems) {
+        size_t local, n;
+        dummy_stripe* stripe = &context->stripes[
+            dummy_locate(context, offset + done, &local, &n)];
+        char* buf = (char*)scratch + done * context->element_size;
+        if (n > nitems - done) n = nitems - done;
+
+        if (kind == CACHERCISE_WRITE && stripe->combiner) {
+            dummy_write_op op;
+            op.stripe = stripe;
+            op.src    = buf;
+            op.n      = n;
+            op.local  = local;
+            op.offset = offset + done;
+            op.lsn    = 0;
+            dummy_combiner_run(stripe->combiner, &op.fc);
+            ret = op.ret;
+            if (op.lsn > lsn) lsn = op.lsn;
+            dummy_check_limit(context, stripe);
+        } else if (kind == CACHERCISE_WRITE) {
+            ret = context->sync == DUMMY_SYNC_LOCKFREE
+                ? hoard_try_put(stripe->h, buf, n, local) : HOARD_RETRY;
+            if (ret == HOARD_RETRY) {
+                dummy_stripe_lock(stripe);
+                ret = hoard_put(stripe->h, buf, n, local);
+                if (ret >= 0)
+                    dummy_log_write(context, offset + done, buf, n, &lsn);
+                dummy_stripe_unlock(stripe);
+            }
+            dummy_check_limit(context, stripe);
+        } else {
+            /* no lock: hoard_get is safe against a concurrent, growing put,
+             * and retries rather than return half of one */
+            ret = dummy_stripe_get(stripe, buf, n, local);
+        }
+        if (ret < 0) return ret;
+        done += n;
+    }
+    if (dummy_log_wait(context, lsn) != 0) return -1;
+    return done;
+}
+
+/* Applies the writes or atomic ops of a batch, grouped by stripe (counting
+ * sort) so that each stripe's lock is taken once for all of its entries
+ * rather than once per entry -- or, sharded, so that each shard gets one
+ * ULT for its share, all shards at once.  atomic is -1 for plain writes of
+ * values, otherwise values are the operands. */
+static int64_t dummy_batch_run(dummy_context* context, size_t count,
+        const int64_t *offsets, int64_t *values, int atomic,
+        const int64_t *compares, int64_t *olds)
+{
+    size_t nstripes = context->num_stripes;
+    size_t i, s, nops = 0;
+    uint64_t lsn = 0;
+    int64_t ret = count;
+
+    size_t* start = (size_t*)calloc(nstripes + 1, sizeof(*start));
+    size_t* fill  = (size_t*)malloc(nstripes * sizeof(*fill));
+    size_t* order = (size_t*)malloc(count * sizeof(*order));
+    size_t* local = (size_t*)malloc(count * sizeof(*local));
+    size_t* which = (size_t*)malloc(count * sizeof(*which));
+    dummy_shard_op* ops = (dummy_shard_op*)calloc(nstripes, sizeof(*ops));
+    if (!start || !fill || !order || !local || !which || !ops) {
+        ret = -1;
+        goto finish;
+    }
+    for (i = 0; i < count; i++) {
+        which[i] = dummy_locate(context, offsets[i], &local[i], NULL);
+        start[which[i] + 1]++;
+    }
+    for (s = 0; s < nstripes; s++)
+        start[s + 1] += start[s];
+    /* order[] lists entries stripe by stripe; within a stripe entries keep
+     * their batch order, so a later write to the same offset still wins */
+    memcpy(fill, start, nstripes * sizeof(*fill));
+    for (i = 0; i < count; i++)
+        order[fill[which[i]]++] = i;
+
+    for (s = 0; s < nstripes; s++) {
+        if (start[s] == start[s + 1]) continue;
+        ops[nops].context  = context;
+        ops[nops].stripe   = s;
+        ops[nops].kind     = CACHERCISE_WRITE;
+        ops[nops].begin    = start[s];
+        ops[nops].end      = start[s + 1];
+        ops[nops].order    = order;
+        ops[nops].local    = local;
+        ops[nops].offsets  = offsets;
+        ops[nops].values   = values;
+        ops[nops].atomic   = atomic;
+        ops[nops].compares = compares;
+        ops[nops].olds     = olds;
+        nops++;
+    }
+
+    if (context->sharded) {
+        if (dummy_shard_run(context, ops, nops, dummy_shard_batch_ult) != CACHERCISE_SUCCESS)
+            ret = -1;
     } else {
-        ret = hoard_get(context->h, scratch, count/sizeof(int64_t), offset);
-        return ret;
+        for (i = 0; i < nops; i++) {
+            dummy_stripe* stripe = &context->stripes[ops[i].stripe];
+            dummy_stripe_lock(stripe);
+            if (dummy_batch_apply(&ops[i]) < 0) ret = -1;
+            dummy_stripe_unlock(stripe);
+            dummy_check_limit(context, stripe);
+        }
+    }
+    for (i = 0; i < nops; i++)
+        if (ops[i].lsn > lsn) lsn = ops[i].lsn;
+
+finish:
+    if (ret >= 0 && dummy_log_wait(context, lsn) != 0) ret = -1;
+    free(start); free(fill); free(order); free(local); free(which); free(ops);
+    return ret;
+}
+
+static int64_t dummy_io_batch(void *ctx, size_t count, const int64_t *offsets, int64_t *values, int kind)
+{
+    dummy_context* context = (dummy_context*)ctx;
+    size_t i;
+
+    /* values travel as 64-bit words */
+    if (context->element_size != sizeof(int64_t))
+        return -1;
+    if (kind != CACHERCISE_READ && kind != CACHERCISE_WRITE)
+        return -1;
+    /* checked up front, so that a bad entry fails the batch before any of
+     * it is applied */
+    for (i = 0; i < count; i++)
+        if (offsets[i] < 0) return -1;
+    if (kind == CACHERCISE_READ) {
+        for (i = 0; i < count; i++) {
+            size_t local;
+            dummy_stripe* stripe = &context->stripes[
+                dummy_locate(context, offsets[i], &local, NULL)];
+            if (dummy_stripe_get(stripe, values + i, 1, local) < 0)
+                return -1;
+        }
+        return count;
+    }
+    return dummy_batch_run(context, count, offsets, values, -1, NULL, NULL);
+}
+
+/* Atomic ops on pages already in memory need no lock at all: the hardware
+ * atomic on the slot is enough, even against a concurrent put.  Creating or
+ * faulting in a page does need the stripe lock, as does logging: a durable
+ * (or sharded) cache runs the whole batch like a batch of writes, so that
+ * the log sees the ops on an offset in the order they were applied. */
+static int64_t dummy_atomic(void *ctx, int op, size_t count, const int64_t *offsets,
+        const int64_t *operands, const int64_t *compares, int64_t *olds)
+{
+    dummy_context* context = (dummy_context*)ctx;
+    size_t i;
+
+    if (context->type != HOARD_INT64)
+        return -1;
+    if (context->sharded || context->wal)
+        return dummy_batch_run(context, count, offsets, (int64_t*)operands,
+                op, compares, olds);
+
+    for (i = 0; i < count; i++) {
+        size_t local;
+        int64_t compare = compares ? compares[i] : 0;
+        dummy_stripe* stripe = &context->stripes[
+            dummy_locate(context, offsets[i], &local, NULL)];
+        int ret = hoard_atomic(stripe->h, op, local, operands[i], compare, &olds[i], 0);
+        if (ret == 1) {
+            dummy_stripe_lock(stripe);
+            ret = hoard_atomic(stripe->h, op, local, operands[i], compare, &olds[i], 1);
+            dummy_stripe_unlock(stripe);
+            dummy_check_limit(context, stripe);
+        }
+        if (ret < 0) return -1;
+    }
+    return count;
+}
+
+/* whether a stripe has ever written the page holding local */
+static inline int dummy_local_populated(dummy_stripe* stripe, size_t local)
+{
+    size_t page = local / hoard_page_size(stripe->h);
+    return hoard_next_page(stripe->h, page) == page;
+}
+
+/* The first populated extent in [offset, end): each stripe's Hoard names
+ * its next written page, which maps back to a cache offset; the closest of
+ * them starts the extent, which then runs on for as long as consecutive
+ * offsets fall in written pages.  Lock-free, like a read. */
+static int64_t dummy_populated(void *ctx, int64_t offset, int64_t end,
+        uint64_t max, int64_t *start)
+{
+    dummy_context* context = (dummy_context*)ctx;
+    size_t ns = context->num_stripes, ss = context->stripe_size;
+    size_t block = offset / ss, round = block / ns, first = SIZE_MAX;
+    size_t s, len = 0, pos;
+
+    if (offset < 0 || end <= offset) return 0;
+    for (s = 0; s < ns; s++) {
+        /* the first offset of stripe s at or after offset */
+        size_t local = s == block % ns ? round * ss + offset % ss
+                     : s > block % ns  ? round * ss : (round + 1) * ss;
+        size_t ps   = hoard_page_size(context->stripes[s].h);
+        size_t page = hoard_next_page(context->stripes[s].h, local / ps);
+        if (page == SIZE_MAX) continue;
+        if (page * ps > local) local = page * ps;
+        pos = ((local / ss) * ns + s) * ss + local % ss;
+        if (pos < first) first = pos;
+    }
+    if (first >= (size_t)end) return 0;
+
+    for (pos = first; pos < (size_t)end && len < max; ) {
+        size_t local, n;
+        dummy_stripe* stripe = &context->stripes[dummy_locate(context, pos, &local, &n)];
+        size_t ps = hoard_page_size(stripe->h);
+        if (!dummy_local_populated(stripe, local)) break;
+        if (n > ps - local % ps) n = ps - local % ps;
+        if (n > (size_t)end - pos) n = end - pos;
+        if (n > max - len) n = max - len;
+        len += n;
+        pos += n;
     }
+    *start = first;
+    return len;
 }
 
 static cachercise_backend_impl dummy_backend = {
@@ -143,10 +1227,15 @@ static cachercise_backend_impl dummy_backend = {
     .open_cache    = dummy_open_cache,
     .close_cache   = dummy_close_cache,
     .destroy_cache = dummy_destroy_cache,
+    .get_config    = dummy_get_config,
+    .element_size  = dummy_element_size,
 
     .hello            = dummy_say_hello,
     .sum              = dummy_compute_sum,
-    .io               = dummy_io
+    .io               = dummy_io,
+    .io_batch         = dummy_io_batch,
+    .atomic           = dummy_atomic,
+    .populated        = dummy_populated
 };
 
 cachercise_return_t cachercise_provider_register_dummy_backend(cachercise_provider_t provider)
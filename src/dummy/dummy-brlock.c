@@ -0,0 +1,84 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdlib.h>
+#include <abt.h>
+#include "dummy-brlock.h"
+
+/* xstreams beyond this many share counters */
+#define DUMMY_BR_SLOTS 64
+
+typedef struct dummy_br_slot {
+    long readers;
+    char pad[64 - sizeof(long)];
+} dummy_br_slot;
+
+struct dummy_brlock {
+    dummy_br_slot slots[DUMMY_BR_SLOTS];
+    int           writer;  /* set while a writer holds or waits for the lock */
+    ABT_mutex     writers; /* one writer at a time */
+};
+
+dummy_brlock* dummy_brlock_create(void)
+{
+    dummy_brlock* l;
+    int i;
+    if (posix_memalign((void**)&l, 64, sizeof(*l)) != 0) return NULL;
+    for (i = 0; i < DUMMY_BR_SLOTS; i++)
+        l->slots[i].readers = 0;
+    l->writer = 0;
+    if (ABT_mutex_create(&l->writers) != ABT_SUCCESS) {
+        free(l);
+        return NULL;
+    }
+    return l;
+}
+
+void dummy_brlock_free(dummy_brlock* l)
+{
+    ABT_mutex_free(&l->writers);
+    free(l);
+}
+
+int dummy_brlock_rdlock(dummy_brlock* l)
+{
+    int rank = 0;
+    ABT_self_get_xstream_rank(&rank);
+    int ticket = (unsigned)rank % DUMMY_BR_SLOTS;
+    long* readers = &l->slots[ticket].readers;
+
+    while (1) {
+        /* announce ourselves, then look for a writer: a writer does the
+         * same the other way round, so one of the two always sees the
+         * other */
+        __atomic_fetch_add(readers, 1, __ATOMIC_SEQ_CST);
+        if (!__atomic_load_n(&l->writer, __ATOMIC_SEQ_CST))
+            return ticket;
+        __atomic_fetch_sub(readers, 1, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&l->writer, __ATOMIC_RELAXED))
+            ABT_thread_yield();
+    }
+}
+
+void dummy_brlock_rdunlock(dummy_brlock* l, int ticket)
+{
+    __atomic_fetch_sub(&l->slots[ticket].readers, 1, __ATOMIC_RELEASE);
+}
+
+void dummy_brlock_wrlock(dummy_brlock* l)
+{
+    int i;
+    ABT_mutex_lock(l->writers);
+    __atomic_store_n(&l->writer, 1, __ATOMIC_SEQ_CST);
+    for (i = 0; i < DUMMY_BR_SLOTS; i++)
+        while (__atomic_load_n(&l->slots[i].readers, __ATOMIC_SEQ_CST))
+            ABT_thread_yield();
+}
+
+void dummy_brlock_wrunlock(dummy_brlock* l)
+{
+    __atomic_store_n(&l->writer, 0, __ATOMIC_RELEASE);
+    ABT_mutex_unlock(l->writers);
+}
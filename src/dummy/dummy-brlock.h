@@ -0,0 +1,27 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef _DUMMY_BRLOCK_H
+#define _DUMMY_BRLOCK_H
+
+/* A reader-biased reader-writer lock.  Each xstream counts its readers on a
+ * cache line of its own, so readers on different xstreams never touch the
+ * same memory and read locking scales with the number of xstreams.  Writers
+ * pay for it: one at a time, a writer raises a flag that turns new readers
+ * away and then waits for every counter to drain.  Both sides yield while
+ * they wait, since whoever they wait for may be a ULT of the same xstream. */
+typedef struct dummy_brlock dummy_brlock;
+
+dummy_brlock* dummy_brlock_create(void);
+void dummy_brlock_free(dummy_brlock* l);
+
+/* returns the ticket to hand back to dummy_brlock_rdunlock */
+int  dummy_brlock_rdlock(dummy_brlock* l);
+void dummy_brlock_rdunlock(dummy_brlock* l, int ticket);
+
+void dummy_brlock_wrlock(dummy_brlock* l);
+void dummy_brlock_wrunlock(dummy_brlock* l);
+
+#endif
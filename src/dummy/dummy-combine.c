@@ -0,0 +1,93 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdlib.h>
+#include "dummy-combine.h"
+
+/* xstreams beyond this many share slots, which only costs a little more
+ * contention on the slot's head */
+#define DUMMY_FC_SLOTS  64
+/* passes a combiner makes over the slots while it still finds work */
+#define DUMMY_FC_PASSES 4
+
+/* each slot is a stack of published operations, on a cache line of its own */
+typedef struct dummy_fc_slot {
+    dummy_fc_op* head;
+    char         pad[64 - sizeof(dummy_fc_op*)];
+} dummy_fc_slot;
+
+struct dummy_combiner {
+    dummy_fc_slot slots[DUMMY_FC_SLOTS];
+    ABT_mutex     mutex;
+    void        (*apply)(dummy_fc_op* op);
+};
+
+dummy_combiner* dummy_combiner_create(ABT_mutex mutex,
+        void (*apply)(dummy_fc_op* op))
+{
+    dummy_combiner* c;
+    int i;
+    if (posix_memalign((void**)&c, 64, sizeof(*c)) != 0) return NULL;
+    for (i = 0; i < DUMMY_FC_SLOTS; i++)
+        c->slots[i].head = NULL;
+    c->mutex = mutex;
+    c->apply = apply;
+    return c;
+}
+
+/* applies what is published, oldest first within each slot; returns how
+ * many operations that was */
+static size_t dummy_combine_pass(dummy_combiner* c)
+{
+    size_t n = 0;
+    int i;
+    for (i = 0; i < DUMMY_FC_SLOTS; i++) {
+        if (!__atomic_load_n(&c->slots[i].head, __ATOMIC_RELAXED)) continue;
+        dummy_fc_op* op = __atomic_exchange_n(&c->slots[i].head, NULL, __ATOMIC_ACQUIRE);
+        dummy_fc_op* fifo = NULL;
+        while (op) {
+            dummy_fc_op* next = op->next;
+            op->next = fifo;
+            fifo = op;
+            op = next;
+        }
+        while (fifo) {
+            /* the owner may return as soon as done is set */
+            dummy_fc_op* next = fifo->next;
+            c->apply(fifo);
+            __atomic_store_n(&fifo->done, 1, __ATOMIC_RELEASE);
+            fifo = next;
+            n++;
+        }
+    }
+    return n;
+}
+
+void dummy_combiner_run(dummy_combiner* c, dummy_fc_op* op)
+{
+    int rank = 0, pass;
+    ABT_self_get_xstream_rank(&rank);
+    dummy_fc_slot* slot = &c->slots[(unsigned)rank % DUMMY_FC_SLOTS];
+
+    op->done = 0;
+    op->next = __atomic_load_n(&slot->head, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&slot->head, &op->next, op, 1,
+                __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    while (!__atomic_load_n(&op->done, __ATOMIC_ACQUIRE)) {
+        if (ABT_mutex_trylock(c->mutex) == ABT_SUCCESS) {
+            for (pass = 0; pass < DUMMY_FC_PASSES; pass++)
+                if (dummy_combine_pass(c) == 0) break;
+            ABT_mutex_unlock(c->mutex);
+        } else {
+            ABT_thread_yield();
+        }
+    }
+}
+
+void dummy_combiner_free(dummy_combiner* c)
+{
+    free(c);
+}
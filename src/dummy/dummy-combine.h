@@ -0,0 +1,35 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef _DUMMY_COMBINE_H
+#define _DUMMY_COMBINE_H
+
+#include <abt.h>
+
+/* Flat combining over a mutex.  Rather than queue on the mutex, a ULT
+ * publishes its operation in the slot of the xstream it runs on and tries
+ * to take the mutex without waiting.  Whoever gets it becomes the combiner
+ * and applies every published operation in one pass before letting go, so
+ * the lock changes hands once per pass instead of once per operation; the
+ * others yield until theirs is marked done.  Code that takes the mutex
+ * directly still excludes the combiner, and the other way round. */
+typedef struct dummy_combiner dummy_combiner;
+
+/* embedded first in the caller's own operation record, which stays on its
+ * stack: apply() is called with the mutex held, by whichever ULT combines */
+typedef struct dummy_fc_op {
+    struct dummy_fc_op* next;
+    int                 done;
+} dummy_fc_op;
+
+dummy_combiner* dummy_combiner_create(ABT_mutex mutex,
+        void (*apply)(dummy_fc_op* op));
+
+/* publishes op and returns once it has been applied */
+void dummy_combiner_run(dummy_combiner* c, dummy_fc_op* op);
+
+void dummy_combiner_free(dummy_combiner* c);
+
+#endif
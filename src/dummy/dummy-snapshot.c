@@ -0,0 +1,215 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include "dummy-snapshot.h"
+
+#define DUMMY_SNAPSHOT_CHUNK (8*1024*1024)
+#define DUMMY_SNAPSHOT_ALIGN 4096
+
+/* a file streamed one chunk-sized, aligned buffer at a time */
+typedef struct snapshot_stream {
+    abt_io_instance_id abtio;
+    int    fd;
+    char*  buf;
+    size_t used;    /* bytes filled (writing) or consumed (reading) */
+    size_t avail;   /* bytes valid in buf (reading) */
+    off_t  offset;  /* file offset of the next chunk */
+} snapshot_stream;
+
+static int stream_open(snapshot_stream* s, abt_io_instance_id abtio,
+        const char* path, int flags)
+{
+    memset(s, 0, sizeof(*s));
+    s->abtio = abtio;
+    if (posix_memalign((void**)&s->buf, DUMMY_SNAPSHOT_ALIGN, DUMMY_SNAPSHOT_CHUNK))
+        return -ENOMEM;
+    s->fd = abt_io_open(abtio, path, flags, 0644);
+    if (s->fd < 0) {
+        free(s->buf);
+        return s->fd;
+    }
+    return 0;
+}
+
+static void stream_close(snapshot_stream* s)
+{
+    abt_io_close(s->abtio, s->fd);
+    free(s->buf);
+}
+
+static int stream_flush(snapshot_stream* s)
+{
+    if (s->used == 0) return 0;
+    if (abt_io_pwrite(s->abtio, s->fd, s->buf, s->used, s->offset) != (ssize_t)s->used)
+        return -1;
+    s->offset += s->used;
+    s->used = 0;
+    return 0;
+}
+
+static int stream_write(snapshot_stream* s, const void* src, size_t n)
+{
+    const char* p = (const char*)src;
+    while (n) {
+        size_t k = DUMMY_SNAPSHOT_CHUNK - s->used;
+        if (k > n) k = n;
+        memcpy(s->buf + s->used, p, k);
+        s->used += k;
+        p += k;
+        n -= k;
+        if (s->used == DUMMY_SNAPSHOT_CHUNK && stream_flush(s) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int stream_read(snapshot_stream* s, void* dst, size_t n)
+{
+    char* p = (char*)dst;
+    while (n) {
+        if (s->used == s->avail) {
+            ssize_t got = abt_io_pread(s->abtio, s->fd, s->buf,
+                    DUMMY_SNAPSHOT_CHUNK, s->offset);
+            if (got <= 0) return -1; /* error or truncated file */
+            s->offset += got;
+            s->avail = got;
+            s->used = 0;
+        }
+        size_t k = s->avail - s->used;
+        if (k > n) k = n;
+        memcpy(p, s->buf + s->used, k);
+        s->used += k;
+        p += k;
+        n -= k;
+    }
+    return 0;
+}
+
+typedef struct snapshot_writer {
+    snapshot_stream stream;
+    uint64_t        stripe;
+    size_t          page_bytes;
+    uint64_t        num_pages;
+} snapshot_writer;
+
+static int count_page(void* arg, size_t page, const void* data)
+{
+    (void)page;
+    (void)data;
+    ((snapshot_writer*)arg)->num_pages++;
+    return 0;
+}
+
+static int write_page(void* arg, size_t page, const void* data)
+{
+    snapshot_writer* w = (snapshot_writer*)arg;
+    uint64_t ids[2] = { w->stripe, page };
+    if (stream_write(&w->stream, ids, sizeof(ids)) != 0
+     || stream_write(&w->stream, data, w->page_bytes) != 0)
+        return -1;
+    return 0;
+}
+
+int dummy_snapshot_save(abt_io_instance_id abtio, const char* path,
+        const hoard_t* hoards, size_t num_stripes, size_t stripe_size)
+{
+    snapshot_writer w;
+    dummy_snapshot_header header;
+    size_t s;
+    int ret = -1;
+
+    size_t len = strlen(path);
+    char* tmp = (char*)malloc(len + 5);
+    if (!tmp) return -1;
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", 5);
+
+    if (stream_open(&w.stream, abtio, tmp, O_WRONLY | O_CREAT | O_TRUNC) != 0) {
+        free(tmp);
+        return -1;
+    }
+    w.page_bytes = hoard_page_size(hoards[0]) * hoard_element_size(hoards[0]);
+    w.num_pages = 0;
+    for (s = 0; s < num_stripes; s++)
+        hoard_for_each_page(hoards[s], count_page, &w);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DUMMY_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.num_stripes = num_stripes;
+    header.stripe_size = stripe_size;
+    header.page_size   = hoard_page_size(hoards[0]);
+    header.element_size = hoard_element_size(hoards[0]);
+    header.num_pages   = w.num_pages;
+    if (stream_write(&w.stream, &header, sizeof(header)) != 0)
+        goto finish;
+    for (s = 0; s < num_stripes; s++) {
+        w.stripe = s;
+        if (hoard_for_each_page(hoards[s], write_page, &w) != 0)
+            goto finish;
+    }
+    if (stream_flush(&w.stream) != 0
+     || abt_io_fdatasync(abtio, w.stream.fd) != 0)
+        goto finish;
+    ret = 0;
+
+finish:
+    stream_close(&w.stream);
+    /* only replace the previous snapshot with a complete one */
+    if (ret == 0 && rename(tmp, path) != 0)
+        ret = -1;
+    if (ret != 0)
+        abt_io_unlink(abtio, tmp);
+    free(tmp);
+    return ret;
+}
+
+int dummy_snapshot_load(abt_io_instance_id abtio, const char* path,
+        int (*restore)(void* arg, const dummy_snapshot_header* header,
+            size_t stripe, size_t page, const void* data),
+        void* arg)
+{
+    snapshot_stream stream;
+    dummy_snapshot_header header;
+    char* data = NULL;
+    uint64_t i;
+    int ret;
+
+    ret = stream_open(&stream, abtio, path, O_RDONLY);
+    if (ret == -ENOENT) return 1;
+    if (ret != 0) return -1;
+
+    ret = -1;
+    if (stream_read(&stream, &header, sizeof(header)) != 0
+     || memcmp(header.magic, DUMMY_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0
+     || header.num_stripes == 0 || header.stripe_size == 0 || header.page_size == 0
+     || header.element_size == 0)
+        goto finish;
+    data = (char*)malloc(header.page_size*header.element_size);
+    if (!data) goto finish;
+    for (i = 0; i < header.num_pages; i++) {
+        uint64_t ids[2];
+        if (stream_read(&stream, ids, sizeof(ids)) != 0
+         || stream_read(&stream, data, header.page_size*header.element_size) != 0
+         || ids[0] >= header.num_stripes
+         || restore(arg, &header, ids[0], ids[1], data) != 0)
+            goto finish;
+    }
+    ret = 0;
+
+finish:
+    free(data);
+    stream_close(&stream);
+    return ret;
+}
+
+void dummy_snapshot_remove(abt_io_instance_id abtio, const char* path)
+{
+    abt_io_unlink(abtio, path);
+}
@@ -0,0 +1,45 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef _DUMMY_SNAPSHOT_H
+#define _DUMMY_SNAPSHOT_H
+
+#include <stdint.h>
+#include <abt-io.h>
+#include "../hoard-c.h"
+
+/* A snapshot is a header followed by one record per written Hoard page:
+ * (stripe, page) and then the page's values, element_size bytes each.  Files are written and read in
+ * large aligned chunks through abt-io, so the actual I/O runs on abt-io's
+ * own xstreams rather than on the RPC ones. */
+
+#define DUMMY_SNAPSHOT_MAGIC "CACHSNP2"
+
+typedef struct dummy_snapshot_header {
+    char     magic[8];
+    uint64_t num_stripes;
+    uint64_t stripe_size;
+    uint64_t page_size;   /* elements per record */
+    uint64_t element_size;
+    uint64_t num_pages;   /* records that follow */
+} dummy_snapshot_header;
+
+/* writes every written page of the num_stripes Hoards to path (through a
+ * temporary file, renamed once complete).  Returns 0 or -1. */
+int dummy_snapshot_save(abt_io_instance_id abtio, const char* path,
+        const hoard_t* hoards, size_t num_stripes, size_t stripe_size);
+
+/* calls restore() for every record of the snapshot at path.  Returns 0,
+ * 1 if there is no snapshot there, or -1 on error (including a non-zero
+ * return from restore). */
+int dummy_snapshot_load(abt_io_instance_id abtio, const char* path,
+        int (*restore)(void* arg, const dummy_snapshot_header* header,
+            size_t stripe, size_t page, const void* data),
+        void* arg);
+
+/* removes the snapshot at path, if any */
+void dummy_snapshot_remove(abt_io_instance_id abtio, const char* path);
+
+#endif
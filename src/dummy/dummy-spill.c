@@ -0,0 +1,63 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include "dummy-spill.h"
+
+struct dummy_spill {
+    abt_io_instance_id abtio;
+    int    fd;
+    char*  path;
+    size_t num_stripes;
+    size_t page_bytes;
+};
+
+dummy_spill* dummy_spill_open(abt_io_instance_id abtio, const char* path,
+        size_t num_stripes, size_t page_size, size_t element_size)
+{
+    dummy_spill* spill = (dummy_spill*)calloc(1, sizeof(*spill));
+    if (!spill) return NULL;
+    spill->abtio       = abtio;
+    spill->num_stripes = num_stripes;
+    spill->page_bytes  = page_size * element_size;
+    spill->path        = strdup(path);
+    spill->fd = abt_io_open(abtio, path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (!spill->path || spill->fd < 0) {
+        free(spill->path);
+        free(spill);
+        return NULL;
+    }
+    return spill;
+}
+
+static off_t spill_offset(dummy_spill* spill, size_t stripe, size_t page)
+{
+    return (off_t)(page * spill->num_stripes + stripe) * spill->page_bytes;
+}
+
+int dummy_spill_read(dummy_spill* spill, size_t stripe, size_t page, void* data)
+{
+    /* only pages that were written out are ever read back */
+    ssize_t got = abt_io_pread(spill->abtio, spill->fd, data, spill->page_bytes,
+            spill_offset(spill, stripe, page));
+    return got == (ssize_t)spill->page_bytes ? 0 : -1;
+}
+
+int dummy_spill_write(dummy_spill* spill, size_t stripe, size_t page, const void* data)
+{
+    ssize_t put = abt_io_pwrite(spill->abtio, spill->fd, data, spill->page_bytes,
+            spill_offset(spill, stripe, page));
+    return put == (ssize_t)spill->page_bytes ? 0 : -1;
+}
+
+void dummy_spill_close(dummy_spill* spill)
+{
+    abt_io_close(spill->abtio, spill->fd);
+    abt_io_unlink(spill->abtio, spill->path);
+    free(spill->path);
+    free(spill);
+}
@@ -0,0 +1,28 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef _DUMMY_SPILL_H
+#define _DUMMY_SPILL_H
+
+#include <stdint.h>
+#include <abt-io.h>
+
+/* The spill tier: a scratch file holding pages evicted from a cache's
+ * stripes, each at a fixed place ((page * num_stripes + stripe) pages in),
+ * so the file is sparse and needs no allocator.  It is not a copy of the
+ * cache to restart from (that is what snapshots are for) and is removed on
+ * close. */
+typedef struct dummy_spill dummy_spill;
+
+dummy_spill* dummy_spill_open(abt_io_instance_id abtio, const char* path,
+        size_t num_stripes, size_t page_size, size_t element_size);
+
+/* both return 0 or -1 */
+int dummy_spill_read(dummy_spill* spill, size_t stripe, size_t page, void* data);
+int dummy_spill_write(dummy_spill* spill, size_t stripe, size_t page, const void* data);
+
+void dummy_spill_close(dummy_spill* spill);
+
+#endif
@@ -0,0 +1,298 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "dummy-wal.h"
+
+#define DUMMY_WAL_READ_CHUNK (8*1024*1024)
+
+/* a record is this header followed by count values; check guards against
+ * a record torn by a crash in the middle of a flush */
+typedef struct wal_record {
+    int64_t  offset;
+    uint32_t count;
+    uint32_t check;
+} wal_record;
+
+struct dummy_wal {
+    abt_io_instance_id abtio;
+    int        fd;
+    size_t     element_size;
+    ABT_mutex  mutex;
+    ABT_cond   wake;      /* flusher: something to write, or stop */
+    ABT_cond   done;      /* writers: durable moved */
+    char*      buf;       /* records not yet handed to the flusher */
+    size_t     used, cap;
+    char*      spare;     /* the other buffer, written by the flusher */
+    size_t     spare_cap;
+    uint64_t   appended;  /* LSN just past the last buffered record */
+    uint64_t   durable;   /* LSN up to which the log is synced */
+    int        error;
+    int        stop;
+    double     interval;
+    ABT_thread flusher;
+};
+
+/* hashes the values 64 bits at a time (and a last 32 bits, for an odd
+ * number of 4-byte elements) */
+static uint32_t wal_check(const wal_record* r, const void* values,
+        size_t element_size)
+{
+    uint64_t h = 14695981039346656037ULL;
+    size_t bytes = r->count * element_size;
+    const char* p = (const char*)values;
+    uint64_t w;
+    size_t i;
+    h = (h ^ (uint64_t)r->offset) * 1099511628211ULL;
+    h = (h ^ r->count) * 1099511628211ULL;
+    for (i = 0; i + sizeof(w) <= bytes; i += sizeof(w)) {
+        memcpy(&w, p + i, sizeof(w));
+        h = (h ^ w) * 1099511628211ULL;
+    }
+    if (i < bytes) {
+        uint32_t tail;
+        memcpy(&tail, p + i, sizeof(tail));
+        h = (h ^ tail) * 1099511628211ULL;
+    }
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+static void flusher_ult(void* arg)
+{
+    dummy_wal* wal = (dummy_wal*)arg;
+
+    ABT_mutex_lock(wal->mutex);
+    while (1) {
+        while (!wal->stop && wal->used == 0)
+            ABT_cond_wait(wal->wake, wal->mutex);
+        if (wal->used == 0) break;
+        if (wal->interval > 0 && !wal->stop) {
+            /* let the other writers of this interval join the commit */
+            struct timespec deadline;
+            double wakeup;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            wakeup = deadline.tv_sec + deadline.tv_nsec*1e-9 + wal->interval;
+            deadline.tv_sec  = (time_t)wakeup;
+            deadline.tv_nsec = (long)((wakeup - deadline.tv_sec)*1e9);
+            ABT_cond_timedwait(wal->wake, wal->mutex, &deadline);
+        }
+
+        /* swap buffers so writers keep appending during the I/O */
+        char*    data   = wal->buf;
+        size_t   n      = wal->used;
+        size_t   cap    = wal->cap;
+        uint64_t target = wal->appended;
+        wal->buf       = wal->spare;
+        wal->cap       = wal->spare_cap;
+        wal->used      = 0;
+        wal->spare     = NULL;
+        wal->spare_cap = 0;
+        ABT_mutex_unlock(wal->mutex);
+
+        /* only this ULT writes, and the file ends at durable */
+        int ok = abt_io_pwrite(wal->abtio, wal->fd, data, n, wal->durable) == (ssize_t)n
+              && abt_io_fdatasync(wal->abtio, wal->fd) == 0;
+
+        ABT_mutex_lock(wal->mutex);
+        wal->spare     = data;
+        wal->spare_cap = cap;
+        if (ok) wal->durable = target;
+        else    wal->error = 1;
+        ABT_cond_broadcast(wal->done);
+    }
+    ABT_mutex_unlock(wal->mutex);
+}
+
+typedef struct wal_reader {
+    abt_io_instance_id abtio;
+    int      fd;
+    char*    buf;
+    size_t   cap, pos, avail;
+    uint64_t offset;  /* file offset of buf + avail */
+} wal_reader;
+
+/* makes n bytes available at buf + pos: returns 0, 1 at the end of the
+ * file, or -1 on error */
+static int wal_reader_fill(wal_reader* r, size_t n)
+{
+    if (r->avail - r->pos >= n) return 0;
+    memmove(r->buf, r->buf + r->pos, r->avail - r->pos);
+    r->avail -= r->pos;
+    r->pos = 0;
+    if (n > r->cap) {
+        size_t cap = 2*r->cap > n ? 2*r->cap : n;
+        char* buf = (char*)realloc(r->buf, cap);
+        if (!buf) return -1;
+        r->buf = buf;
+        r->cap = cap;
+    }
+    while (r->avail < n) {
+        ssize_t got = abt_io_pread(r->abtio, r->fd, r->buf + r->avail,
+                r->cap - r->avail, r->offset);
+        if (got < 0) return -1;
+        if (got == 0) return 1;
+        r->avail  += got;
+        r->offset += got;
+    }
+    return 0;
+}
+
+int dummy_wal_replay(abt_io_instance_id abtio, const char* path,
+        size_t element_size,
+        int (*apply)(void* arg, int64_t offset, const void* values, size_t count),
+        void* arg, uint64_t* end)
+{
+    wal_reader r;
+    struct stat st;
+    int ret = -1;
+
+    *end = 0;
+    if (stat(path, &st) != 0) return 0; /* no log yet */
+
+    memset(&r, 0, sizeof(r));
+    r.abtio = abtio;
+    r.cap   = DUMMY_WAL_READ_CHUNK;
+    r.buf   = (char*)malloc(r.cap);
+    if (!r.buf) return -1;
+    r.fd = abt_io_open(abtio, path, O_RDONLY, 0);
+    if (r.fd < 0) {
+        free(r.buf);
+        return -1;
+    }
+
+    while (1) {
+        wal_record rec;
+        int f = wal_reader_fill(&r, sizeof(rec));
+        if (f < 0) goto finish;
+        if (f > 0) break;
+        memcpy(&rec, r.buf + r.pos, sizeof(rec));
+        size_t len = sizeof(rec) + rec.count*element_size;
+        /* a torn record ends the log */
+        if (rec.count == 0 || *end + len > (uint64_t)st.st_size) break;
+        if (wal_reader_fill(&r, len) != 0) goto finish;
+        const char* values = r.buf + r.pos + sizeof(rec);
+        if (wal_check(&rec, values, element_size) != rec.check) break;
+        if (apply(arg, rec.offset, values, rec.count) != 0) goto finish;
+        r.pos += len;
+        *end  += len;
+    }
+    ret = 0;
+
+finish:
+    abt_io_close(abtio, r.fd);
+    free(r.buf);
+    return ret;
+}
+
+dummy_wal* dummy_wal_open(abt_io_instance_id abtio, const char* path,
+        size_t element_size, uint64_t end, ABT_pool pool, unsigned interval_ms)
+{
+    dummy_wal* wal = (dummy_wal*)calloc(1, sizeof(*wal));
+    if (!wal) return NULL;
+    wal->abtio    = abtio;
+    wal->element_size = element_size;
+    wal->appended = end;
+    wal->durable  = end;
+    wal->interval = interval_ms * 1e-3;
+    wal->flusher  = ABT_THREAD_NULL;
+
+    wal->fd = abt_io_open(abtio, path, O_WRONLY | O_CREAT, 0644);
+    if (wal->fd < 0) {
+        free(wal);
+        return NULL;
+    }
+    if (abt_io_ftruncate(abtio, wal->fd, end) != 0) {
+        abt_io_close(abtio, wal->fd);
+        free(wal);
+        return NULL;
+    }
+    ABT_mutex_create(&wal->mutex);
+    ABT_cond_create(&wal->wake);
+    ABT_cond_create(&wal->done);
+    if (ABT_thread_create(pool, flusher_ult, wal, ABT_THREAD_ATTR_NULL,
+                &wal->flusher) != ABT_SUCCESS) {
+        wal->flusher = ABT_THREAD_NULL;
+        dummy_wal_close(wal);
+        return NULL;
+    }
+    return wal;
+}
+
+uint64_t dummy_wal_append(dummy_wal* wal, int64_t offset,
+        const void* values, size_t count)
+{
+    wal_record rec;
+    size_t len = sizeof(rec) + count*wal->element_size;
+    uint64_t lsn = 0;
+
+    rec.offset = offset;
+    rec.count  = count;
+    rec.check  = wal_check(&rec, values, wal->element_size);
+
+    ABT_mutex_lock(wal->mutex);
+    if (wal->error) goto finish;
+    if (wal->used + len > wal->cap) {
+        size_t cap = wal->cap ? wal->cap : 4096;
+        while (cap < wal->used + len) cap *= 2;
+        char* buf = (char*)realloc(wal->buf, cap);
+        if (!buf) goto finish;
+        wal->buf = buf;
+        wal->cap = cap;
+    }
+    memcpy(wal->buf + wal->used, &rec, sizeof(rec));
+    memcpy(wal->buf + wal->used + sizeof(rec), values, count*wal->element_size);
+    if (wal->used == 0)
+        ABT_cond_signal(wal->wake);
+    wal->used     += len;
+    wal->appended += len;
+    lsn = wal->appended;
+
+finish:
+    ABT_mutex_unlock(wal->mutex);
+    return lsn;
+}
+
+int dummy_wal_wait(dummy_wal* wal, uint64_t lsn)
+{
+    int ret;
+    if (lsn == 0) return -1;
+    ABT_mutex_lock(wal->mutex);
+    while (wal->durable < lsn && !wal->error)
+        ABT_cond_wait(wal->done, wal->mutex);
+    ret = wal->durable >= lsn ? 0 : -1;
+    ABT_mutex_unlock(wal->mutex);
+    return ret;
+}
+
+int dummy_wal_close(dummy_wal* wal)
+{
+    int ret;
+    if (wal->flusher != ABT_THREAD_NULL) {
+        ABT_mutex_lock(wal->mutex);
+        wal->stop = 1;
+        ABT_cond_signal(wal->wake);
+        ABT_mutex_unlock(wal->mutex);
+        ABT_thread_join(wal->flusher);
+        ABT_thread_free(&wal->flusher);
+    }
+    ret = wal->error ? -1 : 0;
+    abt_io_close(wal->abtio, wal->fd);
+    ABT_mutex_free(&wal->mutex);
+    ABT_cond_free(&wal->wake);
+    ABT_cond_free(&wal->done);
+    free(wal->buf);
+    free(wal->spare);
+    free(wal);
+    return ret;
+}
+
+void dummy_wal_remove(abt_io_instance_id abtio, const char* path)
+{
+    abt_io_unlink(abtio, path);
+}
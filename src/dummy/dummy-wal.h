@@ -0,0 +1,47 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef _DUMMY_WAL_H
+#define _DUMMY_WAL_H
+
+#include <stdint.h>
+#include <abt.h>
+#include <abt-io.h>
+
+/* A write-ahead log of (offset, count, values) records, appended through
+ * abt-io.  Appending only copies the record into a memory buffer; a flusher
+ * ULT writes whatever has accumulated and syncs it once per flush interval,
+ * so all the writers of an interval share a single fdatasync (group
+ * commit).  Positions in the log (LSNs) are byte offsets in the file. */
+typedef struct dummy_wal dummy_wal;
+
+/* calls apply() for every complete record of the log at path, in order, and
+ * sets *end to the byte just past the last of them (0 if there is no log).
+ * Returns 0, or -1 on error (including a non-zero return from apply). */
+int dummy_wal_replay(abt_io_instance_id abtio, const char* path,
+        size_t element_size,
+        int (*apply)(void* arg, int64_t offset, const void* values, size_t count),
+        void* arg, uint64_t* end);
+
+/* opens the log at path for appending from end (dropping anything past it,
+ * e.g. a record torn by a crash) and starts its flusher on pool.  Values
+ * are element_size bytes each. */
+dummy_wal* dummy_wal_open(abt_io_instance_id abtio, const char* path,
+        size_t element_size, uint64_t end, ABT_pool pool, unsigned interval_ms);
+
+/* buffers a record; returns the LSN to wait for, or 0 on error */
+uint64_t dummy_wal_append(dummy_wal* wal, int64_t offset,
+        const void* values, size_t count);
+
+/* blocks until everything up to lsn is on disk.  Returns 0 or -1. */
+int dummy_wal_wait(dummy_wal* wal, uint64_t lsn);
+
+/* flushes what is pending, stops the flusher and closes the log */
+int dummy_wal_close(dummy_wal* wal);
+
+/* removes the log at path, if any */
+void dummy_wal_remove(abt_io_instance_id abtio, const char* path);
+
+#endif
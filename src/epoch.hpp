@@ -0,0 +1,103 @@
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/* Epoch-based reclamation.  Readers bracket their accesses with a Guard and
+ * never block; writers unlink an object, hand it to retire(), and it is only
+ * freed once every reader that could still be looking at it has left.
+ *
+ * Readers are counted per epoch in a small array of cache-line sized slots,
+ * picked per OS thread (i.e. per xstream) so that readers on different
+ * xstreams do not bounce the same line.  A reader must not yield while it
+ * holds a Guard.
+ *
+ * retire() and the epoch advance that goes with it are not thread safe: the
+ * owner calls them from the (already serialized) write path. */
+
+class EpochDomain {
+    public:
+        static const size_t NUM_SLOTS = 64;
+
+        class Guard {
+            public:
+                Guard(EpochDomain & domain) : m_counter(domain.enter()) {}
+                ~Guard() { m_counter->fetch_sub(1, std::memory_order_release); }
+                Guard(const Guard &) = delete;
+                Guard & operator=(const Guard &) = delete;
+            private:
+                std::atomic<uint64_t> * m_counter;
+        };
+
+        EpochDomain() : m_epoch(0) {
+            for (size_t s = 0; s < NUM_SLOTS; s++)
+                for (size_t e = 0; e < 3; e++)
+                    m_slots[s].active[e].store(0, std::memory_order_relaxed);
+        }
+        ~EpochDomain() {
+            for (size_t e = 0; e < 3; e++)
+                drain(m_limbo[e]);
+        }
+
+        void retire(void * p, void (*deleter)(void *)) {
+            uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+            m_limbo[epoch % 3].push_back(Retired{p, deleter});
+            try_advance();
+        }
+
+    private:
+        struct Retired {
+            void * p;
+            void (*deleter)(void *);
+        };
+        /* padded rather than alignas(64) so Hoards can still be new'ed
+         * without C++17 aligned allocation */
+        struct Slot {
+            std::atomic<uint64_t> active[3];
+            char pad[64 - 3*sizeof(std::atomic<uint64_t>)];
+        };
+
+        std::atomic<uint64_t> m_epoch;
+        Slot m_slots[NUM_SLOTS];
+        std::vector<Retired> m_limbo[3];
+
+        static size_t my_slot() {
+            static std::atomic<size_t> next(0);
+            thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed) % NUM_SLOTS;
+            return slot;
+        }
+
+        std::atomic<uint64_t> * enter() {
+            Slot & slot = m_slots[my_slot()];
+            for (;;) {
+                uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+                std::atomic<uint64_t> * counter = &slot.active[epoch % 3];
+                counter->fetch_add(1, std::memory_order_seq_cst);
+                /* only counts as being in 'epoch' if it did not move on meanwhile */
+                if (m_epoch.load(std::memory_order_seq_cst) == epoch)
+                    return counter;
+                counter->fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        /* An object retired during epoch E-1 was unlinked before the epoch
+         * moved to E, so only readers that entered in E-1 or earlier can still
+         * hold it.  Moving from E to E+1 requires E-1 to have no readers left
+         * (E-2 already emptied on the way to E), which makes it the moment to
+         * free E-1's list -- the same list E+2 will fill. */
+        void try_advance() {
+            uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+            size_t previous = (epoch + 2) % 3;
+            for (size_t s = 0; s < NUM_SLOTS; s++)
+                if (m_slots[s].active[previous].load(std::memory_order_seq_cst) != 0)
+                    return;
+            m_epoch.store(epoch + 1, std::memory_order_seq_cst);
+            drain(m_limbo[(epoch + 2) % 3]);
+        }
+
+        static void drain(std::vector<Retired> & limbo) {
+            for (auto & r : limbo)
+                r.deleter(r.p);
+            limbo.clear();
+        }
+};
@@ -1,15 +1,80 @@
+#ifndef __HOARD_C_H
+#define __HOARD_C_H
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 #include <stdint.h>
 #include <stddef.h>
 
-typedef struct Hoard * hoard_t;
+typedef struct HoardHandle * hoard_t;
+
+/* element types a Hoard can be instantiated with (see hoard.cc) */
+typedef enum hoard_type {
+    HOARD_INT64,
+    HOARD_DOUBLE,
+    HOARD_FLOAT32,
+    HOARD_RECORD16,  /* opaque records of 16, 32 and 64 bytes */
+    HOARD_RECORD32,
+    HOARD_RECORD64
+} hoard_type_t;
 
-hoard_t hoard_init();
-int hoard_put(hoard_t h, int64_t *src, size_t count, size_t offset);
-int hoard_get(hoard_t h, int64_t *dest, size_t count, size_t offset);
+/* page_size: elements per storage page, rounded up to a power of two.
+ * hoard_init holds int64_t elements; the buffers passed below hold elements
+ * of the Hoard's type, and counts and offsets are in elements.  A sparse
+ * Hoard keeps its pages in a radix tree, for offsets far apart. */
+hoard_t hoard_init(size_t page_size);
+hoard_t hoard_init_typed(size_t page_size, hoard_type_t type, int sparse);
+/* bytes per element */
+size_t hoard_element_size(hoard_t h);
+int hoard_put(hoard_t h, const void *src, size_t count, size_t offset);
+int hoard_get(hoard_t h, void *dest, size_t count, size_t offset);
 void hoard_finalize(hoard_t h);
+/* hoard_put without the put lock, when it can be done (see Hoard::try_put):
+ * returns HOARD_RETRY when the caller has to hoard_put under its lock instead */
+#define HOARD_RETRY (-3)
+int hoard_try_put(hoard_t h, const void *src, size_t count, size_t offset);
+/* elements per page, after rounding */
+size_t hoard_page_size(hoard_t h);
+/* visits every written page in order (see Hoard::for_each_page) */
+int hoard_for_each_page(hoard_t h,
+        int (*fn)(void *arg, size_t page, const void *data), void *arg);
+/* the first page from page on that was ever written, SIZE_MAX if none */
+size_t hoard_next_page(hoard_t h, size_t page);
+
+/* eviction (see the Hoard class): hoard_get returns HOARD_EVICTED when it
+ * meets a page that was pushed out; hoard_fault brings a range back in */
+#define HOARD_EVICTED (-2)
+void hoard_set_spill(hoard_t h,
+        int (*fault)(void *arg, size_t page, void *data), void *arg);
+size_t hoard_resident_pages(hoard_t h);
+int hoard_fault(hoard_t h, size_t count, size_t offset);
+/* SIZE_MAX if no page is resident */
+size_t hoard_clock_victim(hoard_t h);
+int hoard_evict_prepare(hoard_t h, size_t page, void *copy);
+int hoard_evict_commit(hoard_t h, size_t page);
+void hoard_evict_abort(hoard_t h, size_t page);
+
+/* CACHERCISE_ATOMIC_* on one slot: 0, -1 on error (or if the elements are
+ * not int64_t), or (unlocked only) 1 when the caller has to retry with
+ * locked set, under its put lock */
+int hoard_atomic(hoard_t h, int op, size_t offset, int64_t operand,
+        int64_t compare, int64_t *old, int locked);
+
+/* lock-free variant: safe to put/get from any number of threads at once.
+ * capacity (elements, rounded up to whole pages) is fixed; puts beyond it
+ * return -1.  atomic_hoard_init returns NULL if the page directory for that
+ * capacity cannot be allocated. */
+typedef struct AtomicHoard * atomic_hoard_t;
+
+atomic_hoard_t atomic_hoard_init(size_t capacity, size_t page_size);
+int atomic_hoard_put(atomic_hoard_t h, int64_t *src, size_t count, size_t offset);
+int atomic_hoard_get(atomic_hoard_t h, int64_t *dest, size_t count, size_t offset);
+void atomic_hoard_finalize(atomic_hoard_t h);
+int atomic_hoard_atomic(atomic_hoard_t h, int op, size_t offset,
+        int64_t operand, int64_t compare, int64_t *old);
 #ifdef __cplusplus
 }
 #endif
+
+#endif
@@ -1,15 +1,107 @@
+#include <new>
 #include "hoard.hpp"
 #include "hoard-c.h"
 
-hoard_t hoard_init() {
-    Hoard * h = new(Hoard);
-    return h;
+/* hoard_t hides the element type: each HOARD_* type is one instantiation of
+ * TypedHoard, reached through a virtual call per operation (never per
+ * element) */
+struct HoardHandle {
+    virtual ~HoardHandle() {}
+    virtual size_t element_size() const = 0;
+    virtual int put(const void * src, size_t count, size_t offset) = 0;
+    virtual int try_put(const void * src, size_t count, size_t offset) = 0;
+    virtual int get(void * dest, size_t count, size_t offset) = 0;
+    virtual size_t page_size() const = 0;
+    virtual int for_each_page(int (*fn)(void *, size_t, const void *), void * arg) = 0;
+    virtual size_t next_page(size_t page) = 0;
+    virtual void set_spill(int (*fault)(void *, size_t, void *), void * arg) = 0;
+    virtual size_t resident_pages() const = 0;
+    virtual int fault(size_t count, size_t offset) = 0;
+    virtual size_t clock_victim() = 0;
+    virtual int evict_prepare(size_t page, void * copy) = 0;
+    virtual int evict_commit(size_t page) = 0;
+    virtual void evict_abort(size_t page) = 0;
+    virtual int atomic(int op, size_t offset, int64_t operand, int64_t compare,
+            int64_t * old, bool locked) = 0;
+};
+
+template <typename T>
+struct TypedHoard : HoardHandle {
+    Hoard<T> h;
+    TypedHoard(size_t page_size, bool sparse) : h(page_size, sparse) {}
+    size_t element_size() const { return sizeof(T); }
+    int put(const void * src, size_t count, size_t offset) {
+        return h.put(static_cast<const T*>(src), count, offset);
+    }
+    int try_put(const void * src, size_t count, size_t offset) {
+        return h.try_put(static_cast<const T*>(src), count, offset);
+    }
+    int get(void * dest, size_t count, size_t offset) {
+        return h.get(static_cast<T*>(dest), count, offset);
+    }
+    size_t page_size() const { return h.page_size(); }
+    int for_each_page(int (*fn)(void *, size_t, const void *), void * arg) {
+        return h.for_each_page(fn, arg);
+    }
+    size_t next_page(size_t page) { return h.next_page(page); }
+    void set_spill(int (*fault)(void *, size_t, void *), void * arg) {
+        h.set_spill(fault, arg);
+    }
+    size_t resident_pages() const { return h.resident_pages(); }
+    int fault(size_t count, size_t offset) { return h.fault(count, offset); }
+    size_t clock_victim() { return h.clock_victim(); }
+    int evict_prepare(size_t page, void * copy) {
+        return h.evict_prepare(page, static_cast<T*>(copy));
+    }
+    int evict_commit(size_t page) { return h.evict_commit(page); }
+    void evict_abort(size_t page) { h.evict_abort(page); }
+    /* only int64_t elements have atomic operations */
+    int atomic(int, size_t, int64_t, int64_t, int64_t *, bool) { return -1; }
+};
+
+template <>
+int TypedHoard<int64_t>::atomic(int op, size_t offset, int64_t operand,
+        int64_t compare, int64_t * old, bool locked)
+{
+    return h.atomic(op, offset, operand, compare, old, locked);
 }
-int hoard_put(hoard_t h, int64_t *src, size_t count, size_t offset)
+
+template struct TypedHoard<int64_t>;
+template struct TypedHoard<double>;
+template struct TypedHoard<float>;
+template struct TypedHoard<HoardRecord<16> >;
+template struct TypedHoard<HoardRecord<32> >;
+template struct TypedHoard<HoardRecord<64> >;
+
+hoard_t hoard_init(size_t page_size) {
+    return hoard_init_typed(page_size, HOARD_INT64, 0);
+}
+hoard_t hoard_init_typed(size_t page_size, hoard_type_t type, int sparse)
+{
+    bool s = sparse != 0;
+    switch (type) {
+    case HOARD_INT64:    return new TypedHoard<int64_t>(page_size, s);
+    case HOARD_DOUBLE:   return new TypedHoard<double>(page_size, s);
+    case HOARD_FLOAT32:  return new TypedHoard<float>(page_size, s);
+    case HOARD_RECORD16: return new TypedHoard<HoardRecord<16> >(page_size, s);
+    case HOARD_RECORD32: return new TypedHoard<HoardRecord<32> >(page_size, s);
+    case HOARD_RECORD64: return new TypedHoard<HoardRecord<64> >(page_size, s);
+    }
+    return nullptr;
+}
+size_t hoard_element_size(hoard_t h)
+{
+    return h->element_size();
+}
+int hoard_put(hoard_t h, const void *src, size_t count, size_t offset)
 {
     return (h->put(src, count, offset) );
 }
-int hoard_get(hoard_t h, int64_t *dest, size_t count, size_t offset)
+int hoard_try_put(hoard_t h, const void *src, size_t count, size_t offset)
+{
+    return h->try_put(src, count, offset);
+}
+int hoard_get(hoard_t h, void *dest, size_t count, size_t offset)
 {
     return h->get(dest, count, offset);
 }
@@ -17,3 +109,158 @@ void hoard_finalize(hoard_t h)
 {
     delete h;
 }
+size_t hoard_page_size(hoard_t h)
+{
+    return h->page_size();
+}
+int hoard_for_each_page(hoard_t h,
+        int (*fn)(void *arg, size_t page, const void *data), void *arg)
+{
+    return h->for_each_page(fn, arg);
+}
+size_t hoard_next_page(hoard_t h, size_t page)
+{
+    return h->next_page(page);
+}
+void hoard_set_spill(hoard_t h,
+        int (*fault)(void *arg, size_t page, void *data), void *arg)
+{
+    h->set_spill(fault, arg);
+}
+size_t hoard_resident_pages(hoard_t h)
+{
+    return h->resident_pages();
+}
+int hoard_fault(hoard_t h, size_t count, size_t offset)
+{
+    return h->fault(count, offset);
+}
+size_t hoard_clock_victim(hoard_t h)
+{
+    return h->clock_victim();
+}
+int hoard_evict_prepare(hoard_t h, size_t page, void *copy)
+{
+    return h->evict_prepare(page, copy);
+}
+int hoard_evict_commit(hoard_t h, size_t page)
+{
+    return h->evict_commit(page);
+}
+void hoard_evict_abort(hoard_t h, size_t page)
+{
+    h->evict_abort(page);
+}
+int hoard_atomic(hoard_t h, int op, size_t offset, int64_t operand,
+        int64_t compare, int64_t *old, int locked)
+{
+    return h->atomic(op, offset, operand, compare, old, locked != 0);
+}
+
+/* AtomicHoard is not a template: its members are defined once, here */
+AtomicHoard::AtomicHoard(size_t capacity, size_t page_size) : m_page_shift(0)
+{
+    while ((size_t(1) << m_page_shift) < page_size)
+        m_page_shift++;
+    m_page_mask = (size_t(1) << m_page_shift) - 1;
+    m_num_pages = (capacity + m_page_mask) >> m_page_shift;
+    m_directory.reset(new std::atomic<slot*>[m_num_pages]);
+    for (size_t p = 0; p < m_num_pages; p++)
+        m_directory[p].store(nullptr, std::memory_order_relaxed);
+}
+
+AtomicHoard::~AtomicHoard()
+{
+    for (size_t p = 0; p < m_num_pages; p++)
+        delete[] m_directory[p].load(std::memory_order_relaxed);
+}
+
+AtomicHoard::slot * AtomicHoard::page_for_write(size_t page)
+{
+    slot * data = m_directory[page].load(std::memory_order_acquire);
+    if (data) return data;
+    slot * fresh = new slot[m_page_mask+1];
+    for (size_t i = 0; i <= m_page_mask; i++)
+        fresh[i].store(0, std::memory_order_relaxed);
+    /* somebody else may have installed the page first: use theirs */
+    if (m_directory[page].compare_exchange_strong(data, fresh,
+                std::memory_order_acq_rel, std::memory_order_acquire))
+        return fresh;
+    delete[] fresh;
+    return data;
+}
+
+int AtomicHoard::put(int64_t* src, size_t count, size_t offset)
+{
+    /* offset + count may wrap */
+    if (offset >= capacity() || count > capacity() - offset)
+        return -1;
+    size_t i = 0;
+    while (i < count) {
+        size_t page   = (offset+i) >> m_page_shift;
+        size_t within = (offset+i) & m_page_mask;
+        size_t n      = std::min(count - i, m_page_mask + 1 - within);
+        slot * data = page_for_write(page);
+        for (size_t j = 0; j < n; j++)
+            data[within+j].store(src[i+j], std::memory_order_relaxed);
+        i += n;
+    }
+    return count;
+}
+
+int AtomicHoard::get(int64_t *dest, size_t count, size_t offset)
+{
+    /* past the capacity reads as zero, as a page never written does */
+    size_t stored = offset >= capacity() ? 0 : std::min(count, capacity() - offset);
+    std::fill(dest + stored, dest + count, 0);
+    size_t i = 0;
+    while (i < stored) {
+        size_t page   = (offset+i) >> m_page_shift;
+        size_t within = (offset+i) & m_page_mask;
+        size_t n      = std::min(stored - i, m_page_mask + 1 - within);
+        const slot * data = m_directory[page].load(std::memory_order_acquire);
+        for (size_t j = 0; j < n; j++)
+            dest[i+j] = data ? data[within+j].load(std::memory_order_relaxed) : 0;
+        i += n;
+    }
+    return count;
+}
+
+int AtomicHoard::atomic(int op, size_t offset, int64_t operand, int64_t compare,
+        int64_t * old)
+{
+    if (offset >= capacity())
+        return -1;
+    static_assert(sizeof(slot) == sizeof(int64_t),
+            "the slot's int64_t is operated on in place");
+    slot & s = page_for_write(offset >> m_page_shift)[offset & m_page_mask];
+    *old = cachercise_atomic_apply(reinterpret_cast<int64_t*>(&s), op, operand, compare);
+    return 0;
+}
+
+atomic_hoard_t atomic_hoard_init(size_t capacity, size_t page_size)
+{
+    /* the directory is sized up front, and may be too big to allocate */
+    try {
+        return new AtomicHoard(capacity, page_size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+int atomic_hoard_put(atomic_hoard_t h, int64_t *src, size_t count, size_t offset)
+{
+    return h->put(src, count, offset);
+}
+int atomic_hoard_get(atomic_hoard_t h, int64_t *dest, size_t count, size_t offset)
+{
+    return h->get(dest, count, offset);
+}
+void atomic_hoard_finalize(atomic_hoard_t h)
+{
+    delete h;
+}
+int atomic_hoard_atomic(atomic_hoard_t h, int op, size_t offset,
+        int64_t operand, int64_t compare, int64_t *old)
+{
+    return h->atomic(op, offset, operand, compare, old);
+}
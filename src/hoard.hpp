@@ -1,48 +1,633 @@
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
+#include <type_traits>
 #include <iostream>
 
-/* just a big ol' flat array of data.  There is no paging out of excess
+#include "epoch.hpp"
+#include "page-tree.hpp"
+#include "atomic-ops.h"
+
+/* just a big ol' array of data.  There is no paging out of excess
  * data.  no least recently used or anything like that.  Just how fast
- * can we update this data structure concurrently */
+ * can we update this data structure concurrently
+ *
+ * The array is segmented: data lives in fixed-size pages allocated on first
+ * write and found through a directory of page pointers.  Growing the hoard
+ * allocates one page (and now and then a bigger directory, which only copies
+ * pointers), so existing data is never moved and a writer never stalls
+ * behind a copy of the whole array.
+ *
+ * put() must be serialized by the caller; get() may run concurrently with
+ * it.  Readers reach the directory inside an epoch guard, and a directory
+ * replaced by growth is only freed once no reader can still be using it.
+ *
+ * Well, there is paging out now, if the owner asks for it (set_spill()).
+ * Pages then carry a referenced bit, set by get(), and a dirty bit, set by
+ * put(), and an owner-run evictor can push pages out to its own backing
+ * store with a CLOCK sweep:
+ *   clock_victim()  picks a page, clearing referenced bits on the way;
+ *   evict_prepare() clears its dirty bit and copies it out if it was dirty;
+ *   (the owner writes the copy out, with no lock held)
+ *   evict_commit()  drops the page unless it was written or read meanwhile.
+ * Only evict_commit() and evict_abort() need to be serialized with put(),
+ * and dropped pages are retired through the epochs like directories.
+ * get() on a dropped page returns EVICTED rather than doing I/O itself; the
+ * caller then calls fault() (serialized with put()) and tries again.  put()
+ * faults pages in on its own, except for pages it overwrites entirely.
+ *
+ * Each page ends with a sequence word, so that a get() of several elements
+ * sees the whole range as it was at one instant rather than half of a
+ * concurrent put().  Writers count themselves in and out of the word (the
+ * low half counts writers in the page, the high half is a version bumped by
+ * each of them on the way out); readers take no lock and write nothing,
+ * they just read the range again if a writer was in any of its pages.
+ *
+ * The element type T is a template parameter: any trivially copyable type
+ * whose size is a whole number of 32- or 64-bit words.  Pages hold the
+ * elements densely, exactly as an array of T would, and HoardSlot moves one
+ * element in or out with a relaxed atomic per word; a record is only whole
+ * to a reader thanks to the sequence words.
+ *
+ * A sparse hoard finds its pages through a radix tree (page-tree.hpp)
+ * instead of the directory, so that an offset of 2^40 costs a handful of
+ * tree nodes rather than a directory of 2^40 / page_size() entries, for a
+ * load per tree level on each page looked up.  The tree is never replaced,
+ * only grown in place, so the epochs are left with just the pages. */
+
+template <typename T>
+struct HoardSlot {
+    static_assert(std::is_trivially_copyable<T>::value,
+            "Hoard elements are copied word by word");
+    typedef typename std::conditional<sizeof(T) % sizeof(uint64_t) == 0,
+            uint64_t, uint32_t>::type word;
+    static_assert(sizeof(T) % sizeof(word) == 0,
+            "Hoard elements are a whole number of words");
+    static const size_t WORDS = sizeof(T) / sizeof(word);
 
+    static void store(word * dst, const T * src) {
+        word w[WORDS];
+        std::memcpy(w, src, sizeof(T));
+        for (size_t k = 0; k < WORDS; k++)
+            __atomic_store_n(&dst[k], w[k], __ATOMIC_RELAXED);
+    }
+    static void load(const word * src, T * dst) {
+        word w[WORDS];
+        for (size_t k = 0; k < WORDS; k++)
+            w[k] = __atomic_load_n(&src[k], __ATOMIC_RELAXED);
+        std::memcpy(dst, w, sizeof(T));
+    }
+};
+
+/* an opaque fixed-size record, for caches of small structs */
+template <size_t N>
+struct HoardRecord {
+    alignas(8) unsigned char bytes[N];
+};
+
+template <typename T>
 class Hoard {
     public:
-        Hoard() = default;
-        int put(int64_t * src, size_t count, size_t offset);
-        int get(int64_t * dest, size_t count, size_t offset);
+        Hoard(size_t page_size, bool sparse = false);
+        ~Hoard();
+        int put(const T * src, size_t count, size_t offset);
+        int get(T * dest, size_t count, size_t offset);
+        /* put() without the caller's lock: only onto pages already in
+         * memory, and never with eviction on.  Returns count like put(), or
+         * RETRY, having written nothing, when the caller has to put() under
+         * its lock instead.
+         * Racing writes to the same elements may interleave element by
+         * element. */
+        int try_put(const T * src, size_t count, size_t offset);
+        /* a CACHERCISE_ATOMIC_* operation on one slot (int64_t elements
+         * only).  Unlocked, it only works on a page already in memory (and
+         * never with eviction on) and returns 1 otherwise; locked
+         * (serialized with put()), it always works.  Returns 0 on success,
+         * -1 on error. */
+        int atomic(int op, size_t offset, int64_t operand, int64_t compare,
+                int64_t * old, bool locked);
+        size_t page_size() const { return m_page_mask + 1; }
+        /* calls fn(arg, page, data) for every page written so far, in page
+         * order, stopping early if fn returns non-zero.  data is the page's
+         * page_size() elements.  Not to be run alongside put(). */
+        int for_each_page(int (*fn)(void *, size_t, const void *), void * arg);
+        /* the first page from page on that was ever written (in memory or
+         * evicted), SIZE_MAX if none; may run alongside put() */
+        size_t next_page(size_t page) {
+            EpochDomain::Guard guard(m_epochs);
+            Entry e;
+            return next(m_directory.load(std::memory_order_seq_cst), page, &e);
+        }
+
+        static const int EVICTED = -2;
+        static const int RETRY   = -3;
+        /* fills data with the page_size() elements of page */
+        typedef int (*fault_fn)(void * arg, size_t page, void * data);
+        /* enables eviction; fn reads a page back from the backing store */
+        void set_spill(fault_fn fn, void * arg) { m_fault = fn; m_fault_arg = arg; }
+        size_t resident_pages() const { return m_resident.load(std::memory_order_relaxed); }
+        int fault(size_t count, size_t offset);
+        size_t clock_victim();
+        int evict_prepare(size_t page, T * copy);
+        int evict_commit(size_t page);
+        void evict_abort(size_t page);
     private:
-       std::vector<int64_t> m_hoard;
+       typedef HoardSlot<T> Slot;
+       typedef typename Slot::word word;
+       enum { REFERENCED = 1, DIRTY = 2 };
+       struct Directory {
+           size_t size;
+           std::unique_ptr<std::atomic<word*>[]> pages;
+           std::unique_ptr<std::atomic<uint8_t>[]> flags;
+           Directory(size_t n) : size(n), pages(new std::atomic<word*>[n]),
+                   flags(new std::atomic<uint8_t>[n]) {
+               for (size_t p = 0; p < n; p++) {
+                   pages[p].store(nullptr, std::memory_order_relaxed);
+                   flags[p].store(0, std::memory_order_relaxed);
+               }
+           }
+       };
+       size_t m_page_shift;
+       size_t m_page_mask;
+       size_t m_seq_at;  /* words before the sequence word */
+       std::atomic<Directory*> m_directory;  /* null if sparse */
+       std::unique_ptr<PageTree<word> > m_tree;  /* null unless sparse */
+       EpochDomain m_epochs;
+       fault_fn m_fault;
+       void * m_fault_arg;
+       std::atomic<size_t> m_resident;
+       size_t m_hand;  /* CLOCK hand, owned by the evictor */
+       /* a page's pointer and flags, from whichever table the hoard has */
+       typedef typename PageTree<word>::Ref Entry;
+       static const size_t NONE = PageTree<word>::NONE;
+       /* the page's entry (empty if it has none) in dir, the directory the
+        * caller loaded */
+       Entry find(Directory * dir, size_t page) const {
+           if (m_tree) return m_tree->find(page);
+           return page < dir->size ? Entry(&dir->pages[page], &dir->flags[page]) : Entry();
+       }
+       word * load_page(Directory * dir, size_t page) const {
+           Entry e = find(dir, page);
+           return e.page ? e.page->load(std::memory_order_acquire) : nullptr;
+       }
+       /* the first page from page on with a (possibly evicted) page, and its
+        * entry; NONE if there is none */
+       size_t next(Directory * dir, size_t page, Entry * e) const {
+           if (m_tree) return m_tree->next(page, e);
+           for (; page < dir->size; page++)
+               if (dir->pages[page].load(std::memory_order_acquire)) {
+                   *e = Entry(&dir->pages[page], &dir->flags[page]);
+                   return page;
+               }
+           return NONE;
+       }
+       Entry make(size_t page);
+       word * page_for_write(size_t page, bool whole);
+       word * new_page(bool zero);
+       /* the sequence word after the page's elements */
+       uint64_t * seq(const word * data) const {
+           return reinterpret_cast<uint64_t*>(const_cast<word*>(data) + m_seq_at);
+       }
+       static const uint64_t WRITERS = 0xffffffffULL;
+       static const uint64_t VERSION = WRITERS + 1;
+       void write_begin(word * data) {
+           __atomic_fetch_add(seq(data), 1, __ATOMIC_RELAXED);
+           __atomic_thread_fence(__ATOMIC_RELEASE);
+       }
+       void write_end(word * data) {
+           __atomic_fetch_add(seq(data), VERSION - 1, __ATOMIC_RELEASE);
+       }
+       void write_pages(word ** pages, size_t npages, const T * src,
+               size_t count, size_t offset);
+       struct Seen { const word * data; uint64_t seq; };
+       int read_range(Directory * dir, T * dest, size_t count,
+               size_t offset, Seen * seen);
+       word * fault_page(Entry e, size_t page);
+       /* stands in the directory for a page that was pushed out */
+       static word * evicted() { return reinterpret_cast<word*>(uintptr_t(1)); }
+       static bool present(const word * data) { return data && data != evicted(); }
+       static void free_directory(void * d) { delete static_cast<Directory*>(d); }
+       static void free_page(void * p) { delete[] static_cast<word*>(p); }
        void show() {
-           for (const auto &x : m_hoard)
-               std::cout << x << " ";
+           EpochDomain::Guard guard(m_epochs);
+           Directory * dir = m_directory.load(std::memory_order_acquire);
+           Entry e;
+           for (size_t p = next(dir, 0, &e); p != NONE; p = next(dir, p+1, &e)) {
+               word * data = e.page->load(std::memory_order_acquire);
+               if (!present(data)) continue;
+               std::cout << "[" << p << "] ";
+               for (size_t i = 0; i < m_seq_at; i++)
+                   std::cout << data[i] << " ";
+           }
            std::cout << std::endl;
        }
 };
 
-int Hoard::put(int64_t* src, size_t count, size_t offset)
+template <typename T>
+Hoard<T>::Hoard(size_t page_size, bool sparse) : m_page_shift(0),
+    m_directory(sparse ? nullptr : new Directory(1)),
+    m_tree(sparse ? new PageTree<word>() : nullptr), m_fault(nullptr), m_fault_arg(nullptr), m_resident(0), m_hand(0)
+{
+    /* round up to a power of two so offsets split with a shift and a mask */
+    while ((size_t(1) << m_page_shift) < page_size)
+        m_page_shift++;
+    m_page_mask = (size_t(1) << m_page_shift) - 1;
+    /* keep the sequence word 64-bit aligned after 32-bit elements */
+    const size_t seq_words = sizeof(uint64_t) / sizeof(word);
+    m_seq_at = ((m_page_mask + 1) * Slot::WORDS + seq_words - 1) / seq_words * seq_words;
+}
+
+template <typename T>
+Hoard<T>::~Hoard()
 {
-    if (m_hoard.size() < offset + count)
-        m_hoard.resize( (m_hoard.size()+offset+count) * 2);
+    Directory * dir = m_directory.load(std::memory_order_relaxed);
+    Entry e;
+    for (size_t p = next(dir, 0, &e); p != NONE; p = next(dir, p+1, &e)) {
+        word * data = e.page->load(std::memory_order_relaxed);
+        if (present(data)) delete[] data;
+    }
+    delete dir;
+}
+
+template <typename T>
+typename Hoard<T>::word * Hoard<T>::new_page(bool zero)
+{
+    const size_t words = m_seq_at + sizeof(uint64_t) / sizeof(word);
+    word * data = zero ? new word[words]() : new word[words];
+    *seq(data) = 0;
+    return data;
+}
+
+template <typename T>
+typename Hoard<T>::word * Hoard<T>::fault_page(Entry e, size_t page)
+{
+    word * data = new_page(false);
+    if (m_fault(m_fault_arg, page, data) != 0) {
+        delete[] data;
+        return nullptr;
+    }
+    e.flags->store(REFERENCED, std::memory_order_relaxed);
+    e.page->store(data, std::memory_order_release);
+    m_resident.fetch_add(1, std::memory_order_relaxed);
+    return data;
+}
+
+template <typename T>
+typename Hoard<T>::Entry Hoard<T>::make(size_t page)
+{
+    if (m_tree) return m_tree->make(page);
+    Directory * dir = m_directory.load(std::memory_order_relaxed);
+    if (dir->size <= page) {
+        /* copy the page pointers into a bigger directory, publish it, and
+         * leave the old one to the epoch domain: readers may still be in it */
+        Directory * bigger = new Directory((dir->size+page+1) * 2);
+        for (size_t p = 0; p < dir->size; p++) {
+            bigger->pages[p].store(dir->pages[p].load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+            bigger->flags[p].store(dir->flags[p].load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+        }
+        m_directory.store(bigger, std::memory_order_seq_cst);
+        m_epochs.retire(dir, free_directory);
+        dir = bigger;
+    }
+    return Entry(&dir->pages[page], &dir->flags[page]);
+}
 
-    // having trouble using insert() correctly concurrently...
-    //m_hoard.insert(m_hoard.begin()+offset, src, src+count);
-    for (size_t i = 0; i< count ; i++)
-        m_hoard[offset+i] = src[i];
+template <typename T>
+typename Hoard<T>::word * Hoard<T>::page_for_write(size_t page, bool whole)
+{
+    Entry e = make(page);
+    word * data = e.page->load(std::memory_order_relaxed);
+    if (data == evicted() && !whole)
+        return fault_page(e, page);
+    if (!present(data)) {
+        data = new_page(true);
+        e.page->store(data, std::memory_order_release);
+        m_resident.fetch_add(1, std::memory_order_relaxed);
+    }
+    return data;
+}
+
+template <typename T>
+int Hoard<T>::put(const T* src, size_t count, size_t offset)
+{
+    if (count == 0) return 0;
+    size_t first  = offset >> m_page_shift;
+    size_t npages = ((offset+count-1) >> m_page_shift) - first + 1;
+    word * few[4];
+    std::unique_ptr<word*[]> many;
+    word ** pages = few;
+    if (npages > 4) {
+        many.reset(new word*[npages]);
+        pages = many.get();
+    }
+    /* enter every page of the range before writing any of them, so that no
+     * reader sees one page written and the next one not yet */
+    size_t i = 0, p;
+    for (p = 0; p < npages; p++) {
+        size_t within = (offset+i) & m_page_mask;
+        size_t n      = std::min(count - i, m_page_mask + 1 - within);
+        pages[p] = page_for_write(first+p, n == m_page_mask + 1);
+        if (!pages[p]) return -1;
+        i += n;
+    }
+    write_pages(pages, npages, src, count, offset);
+    /* after the data: an evictor that then sees the page clean has copied
+     * all of it */
+    if (m_fault)
+        for (p = 0; p < npages; p++)
+            find(m_directory.load(std::memory_order_relaxed), first+p).flags->fetch_or(
+                    DIRTY, std::memory_order_release);
 #ifdef DEBUG_HOARD
-    std::cout << "Hoard::put: " << src[0] << "...  " << count << " items at " << offset << std::endl;;
+    std::cout << "Hoard::put: " << count << " items at " << offset << std::endl;;
     show();
 #endif
     return count;
 }
-int Hoard::get(int64_t *dest, size_t count, size_t offset)
+
+template <typename T>
+void Hoard<T>::write_pages(word ** pages, size_t npages, const T * src,
+        size_t count, size_t offset)
+{
+    size_t i = 0, p;
+    for (p = 0; p < npages; p++)
+        write_begin(pages[p]);
+    for (p = 0; p < npages; p++) {
+        size_t within = (offset+i) & m_page_mask;
+        size_t n      = std::min(count - i, m_page_mask + 1 - within);
+        for (size_t j = 0; j < n; j++)
+            Slot::store(&pages[p][(within+j) * Slot::WORDS], &src[i+j]);
+        i += n;
+    }
+    for (p = 0; p < npages; p++)
+        write_end(pages[p]);
+}
+
+template <typename T>
+int Hoard<T>::try_put(const T* src, size_t count, size_t offset)
+{
+    /* with eviction on a page could be dropped under our feet */
+    if (m_fault) return RETRY;
+    if (count == 0) return 0;
+    size_t first  = offset >> m_page_shift;
+    size_t npages = ((offset+count-1) >> m_page_shift) - first + 1;
+    word * few[4];
+    std::unique_ptr<word*[]> many;
+    word ** pages = few;
+    if (npages > 4) {
+        many.reset(new word*[npages]);
+        pages = many.get();
+    }
+    EpochDomain::Guard guard(m_epochs);
+    Directory * dir = m_directory.load(std::memory_order_seq_cst);
+    for (size_t p = 0; p < npages; p++) {
+        pages[p] = load_page(dir, first+p);
+        if (!pages[p]) return RETRY;
+    }
+    write_pages(pages, npages, src, count, offset);
+    return count;
+}
+
+template <typename T>
+int Hoard<T>::get(T *dest, size_t count, size_t offset)
 {
 #ifdef DEBUG_HOARD
-    std::cout << "Hoard::get: " << count << " items at " << offset << " " << m_hoard[offset] << std::endl;
+    std::cout << "Hoard::get: " << count << " items at " << offset << std::endl;
     show();
 #endif
-    for (size_t i= 0; i< count; i++)
-        dest[i] = m_hoard[offset+i];
-    return count;
+    EpochDomain::Guard guard(m_epochs);
+    size_t npages = count ?
+        ((offset+count-1) >> m_page_shift) - (offset >> m_page_shift) + 1 : 0;
+    Seen few[4];
+    std::unique_ptr<Seen[]> many;
+    Seen * seen = few;
+    if (npages > 4) {
+        many.reset(new Seen[npages]);
+        seen = many.get();
+    }
+    /* a single element cannot tear, unless it spans several words */
+    if (count <= 1 && Slot::WORDS == 1) {
+        int ret = read_range(m_directory.load(std::memory_order_seq_cst),
+                dest, count, offset, nullptr);
+        return ret == EVICTED ? EVICTED : count;
+    }
+    while (true) {
+        Directory * dir = m_directory.load(std::memory_order_seq_cst);
+        int ret = read_range(dir, dest, count, offset, seen);
+        if (ret == EVICTED) return EVICTED;
+        if (ret != 0) continue;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        /* consistent if no page was written, replaced or created since */
+        dir = m_directory.load(std::memory_order_seq_cst);
+        size_t first = offset >> m_page_shift;
+        size_t p;
+        for (p = 0; p < npages; p++) {
+            const word * data = load_page(dir, first+p);
+            if (data != seen[p].data
+             || (data && __atomic_load_n(seq(data), __ATOMIC_RELAXED) != seen[p].seq))
+                break;
+        }
+        if (p == npages) return count;
+    }
+}
+
+/* one pass of get(): 0, EVICTED, or 1 if a writer was in one of the pages.
+ * seen (one per page) receives the sequence words; NULL skips them. */
+template <typename T>
+int Hoard<T>::read_range(Directory * dir, T * dest, size_t count,
+        size_t offset, Seen * seen)
+{
+    size_t i = 0;
+    while (i < count) {
+        size_t page   = (offset+i) >> m_page_shift;
+        size_t within = (offset+i) & m_page_mask;
+        size_t n      = std::min(count - i, m_page_mask + 1 - within);
+        /* never-written pages read back as zero */
+        Entry e = find(dir, page);
+        const word * data = e.page ? e.page->load(std::memory_order_acquire) : nullptr;
+        if (data == evicted())
+            return EVICTED;
+        if (seen) {
+            /* keep the pages read so far from being read before this word */
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            seen->data = data;
+            if (data) {
+                seen->seq = __atomic_load_n(seq(data), __ATOMIC_ACQUIRE);
+                if (seen->seq & WRITERS)
+                    return 1;
+            }
+            seen++;
+        }
+        if (data && m_fault
+         && !(e.flags->load(std::memory_order_relaxed) & REFERENCED))
+            e.flags->fetch_or(REFERENCED, std::memory_order_relaxed);
+        if (data)
+            for (size_t j = 0; j < n; j++)
+                Slot::load(&data[(within+j) * Slot::WORDS], &dest[i+j]);
+        else
+            std::memset(static_cast<void*>(dest + i), 0, n * sizeof(T));
+        i += n;
+    }
+    return 0;
+}
+
+template <typename T>
+int Hoard<T>::atomic(int op, size_t offset, int64_t operand, int64_t compare,
+        int64_t * old, bool locked)
+{
+    static_assert(std::is_same<T, int64_t>::value,
+            "atomic operations work on int64_t elements");
+    size_t page   = offset >> m_page_shift;
+    size_t within = offset & m_page_mask;
+    if (!locked) {
+        /* with eviction on the page could be dropped under our feet */
+        if (m_fault) return 1;
+        EpochDomain::Guard guard(m_epochs);
+        word * data = load_page(m_directory.load(std::memory_order_seq_cst), page);
+        if (!data) return 1;
+        write_begin(data);
+        *old = cachercise_atomic_apply(reinterpret_cast<int64_t*>(&data[within]),
+                op, operand, compare);
+        write_end(data);
+        return 0;
+    }
+    word * data = page_for_write(page, false);
+    if (!data) return -1;
+    write_begin(data);
+    *old = cachercise_atomic_apply(reinterpret_cast<int64_t*>(&data[within]),
+            op, operand, compare);
+    write_end(data);
+    if (m_fault)
+        find(m_directory.load(std::memory_order_relaxed), page).flags->fetch_or(
+                DIRTY | REFERENCED, std::memory_order_release);
+    return 0;
+}
+
+template <typename T>
+int Hoard<T>::for_each_page(int (*fn)(void *, size_t, const void *), void * arg)
+{
+    Directory * dir = m_directory.load(std::memory_order_acquire);
+    std::unique_ptr<word[]> spilled;
+    Entry e;
+    for (size_t p = next(dir, 0, &e); p != NONE; p = next(dir, p+1, &e)) {
+        const word * data = e.page->load(std::memory_order_acquire);
+        if (data == evicted()) {
+            /* read it back without bringing it in */
+            if (!spilled) spilled.reset(new word[m_seq_at]);
+            if (m_fault(m_fault_arg, p, spilled.get()) != 0) return -1;
+            data = spilled.get();
+        }
+        int ret = fn(arg, p, data);
+        if (ret) return ret;
+    }
+    return 0;
+}
+
+template <typename T>
+int Hoard<T>::fault(size_t count, size_t offset)
+{
+    Directory * dir = m_directory.load(std::memory_order_relaxed);
+    size_t first = offset >> m_page_shift;
+    size_t last  = count ? (offset + count - 1) >> m_page_shift : first;
+    Entry e;
+    for (size_t p = next(dir, first, &e); p != NONE && p <= last; p = next(dir, p+1, &e))
+        if (e.page->load(std::memory_order_relaxed) == evicted()
+         && !fault_page(e, p))
+            return -1;
+    return 0;
+}
+
+template <typename T>
+size_t Hoard<T>::clock_victim()
+{
+    EpochDomain::Guard guard(m_epochs);
+    Directory * dir = m_directory.load(std::memory_order_seq_cst);
+    Entry e;
+    /* two whole turns: the first may only clear referenced bits */
+    for (size_t wraps = 0; wraps < 3; ) {
+        size_t p = next(dir, m_hand, &e);
+        if (p == NONE) {
+            m_hand = 0;
+            wraps++;
+            continue;
+        }
+        m_hand = p + 1;
+        if (!present(e.page->load(std::memory_order_relaxed)))
+            continue;
+        if (e.flags->load(std::memory_order_relaxed) & REFERENCED) {
+            e.flags->fetch_and(~REFERENCED, std::memory_order_relaxed);
+            continue;
+        }
+        return p;
+    }
+    return SIZE_MAX;
+}
+
+/* returns 1 if copy now holds the page and must be written out, 0 if the
+ * backing store already has it, -1 if the page is not in memory */
+template <typename T>
+int Hoard<T>::evict_prepare(size_t page, T * copy)
+{
+    EpochDomain::Guard guard(m_epochs);
+    Entry e = find(m_directory.load(std::memory_order_seq_cst), page);
+    const word * data = e.page ? e.page->load(std::memory_order_acquire) : nullptr;
+    if (!present(data)) return -1;
+    if (!(e.flags->fetch_and(~DIRTY, std::memory_order_acq_rel) & DIRTY))
+        return 0;
+    for (size_t i = 0; i <= m_page_mask; i++)
+        Slot::load(&data[i * Slot::WORDS], &copy[i]);
+    return 1;
+}
+
+/* returns 1 if the page was dropped, 0 if it was used since prepare */
+template <typename T>
+int Hoard<T>::evict_commit(size_t page)
+{
+    Entry e = find(m_directory.load(std::memory_order_relaxed), page);
+    word * data = e.page ? e.page->load(std::memory_order_relaxed) : nullptr;
+    if (!present(data)
+     || e.flags->load(std::memory_order_acquire) & (DIRTY | REFERENCED))
+        return 0;
+    e.page->store(evicted(), std::memory_order_seq_cst);
+    m_epochs.retire(data, free_page);
+    m_resident.fetch_sub(1, std::memory_order_relaxed);
+    return 1;
+}
+
+/* the copy could not be written out: keep the page dirty */
+template <typename T>
+void Hoard<T>::evict_abort(size_t page)
+{
+    Entry e = find(m_directory.load(std::memory_order_relaxed), page);
+    if (e.flags)
+        e.flags->fetch_or(DIRTY, std::memory_order_relaxed);
 }
+
+/* Same paged layout, but every slot is a std::atomic<int64_t> and the
+ * directory is sized once, up front, from a fixed capacity.  Pages are still
+ * allocated on first touch, installed with a compare-and-swap, so neither
+ * put nor get ever takes a lock.  Writes past the capacity are refused. */
+
+class AtomicHoard {
+    public:
+        AtomicHoard(size_t capacity, size_t page_size);
+        ~AtomicHoard();
+        int put(int64_t * src, size_t count, size_t offset);
+        int get(int64_t * dest, size_t count, size_t offset);
+        /* a CACHERCISE_ATOMIC_* operation on one slot; -1 past the capacity */
+        int atomic(int op, size_t offset, int64_t operand, int64_t compare,
+                int64_t * old);
+    private:
+       typedef std::atomic<int64_t> slot;
+       size_t m_page_shift;
+       size_t m_page_mask;
+       size_t m_num_pages;
+       std::unique_ptr<std::atomic<slot*>[]> m_directory;
+       slot * page_for_write(size_t page);
+       size_t capacity() const { return m_num_pages << m_page_shift; }
+};
@@ -0,0 +1,447 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <json-c/json.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "cachercise/cachercise-backend.h"
+#include "../provider.h"
+#include "kv-backend.h"
+
+/* A store of values by byte-string key, for applications that name their
+ * data rather than lay it out at offsets.
+ *
+ * Keys are found through an open-addressing table laid out the way Swiss
+ * tables are: beside the slots is an array of one control byte per slot,
+ * either EMPTY, DELETED or the low 7 bits of the key's hash.  The table is
+ * probed a group of 16 slots at a time, by comparing the group's 16
+ * control bytes with the hash's 7 bits at once (one SSE2 compare), so only
+ * slots whose byte matches -- about one in 128 of the others -- have their
+ * key looked at, and a probe ends at the first group with an EMPTY slot.
+ * Groups are visited in triangular order, which reaches every group of a
+ * power-of-two table.  A slot keeps the whole hash, so a key is compared
+ * byte by byte only when its hash matches too, and the table is rebuilt
+ * from the hashes alone when it grows.
+ *
+ * Each key and its value are one allocation.  Keys are spread by hash over
+ * "shards", each with its own lock and table, as in the slab backend. */
+
+#define KV_GROUP          16
+#define KV_EMPTY          0x80
+#define KV_DELETED        0xfe
+#define KV_DEFAULT_SHARDS 16
+/* each shard starts with a table of its own */
+#define KV_MAX_SHARDS     4096
+#define KV_INITIAL_SLOTS  1024
+
+typedef struct kv_item {
+    uint32_t key_size;
+    uint32_t value_size;
+    char     data[];  /* key, then value */
+} kv_item;
+
+typedef struct kv_slot {
+    uint64_t hash;
+    kv_item* item;
+} kv_slot;
+
+typedef struct kv_shard {
+    ABT_mutex mutex;
+    uint8_t*  ctrl;      /* one byte per slot, 16-byte aligned */
+    kv_slot*  slots;
+    size_t    capacity;  /* slots, a power of two, at least KV_GROUP */
+    size_t    used;      /* live slots */
+    size_t    deleted;   /* DELETED slots */
+} kv_shard;
+
+typedef struct kv_context {
+    struct json_object* config;
+    size_t    num_shards;
+    kv_shard* shards;
+} kv_context;
+
+static void kv_free_context(kv_context* ctx);
+
+static int kv_alloc_table(kv_shard* s, size_t capacity)
+{
+    void* ctrl;
+    if (posix_memalign(&ctrl, KV_GROUP, capacity)) return -1;
+    kv_slot* slots = (kv_slot*)malloc(capacity * sizeof(*slots));
+    if (!slots) {
+        free(ctrl);
+        return -1;
+    }
+    memset(ctrl, KV_EMPTY, capacity);
+    s->ctrl     = (uint8_t*)ctrl;
+    s->slots    = slots;
+    s->capacity = capacity;
+    s->deleted  = 0;
+    return 0;
+}
+
+static cachercise_return_t kv_init_context(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    struct json_object* config = NULL;
+
+    // read JSON config from provided string argument
+    if (config_str) {
+        struct json_tokener*    tokener = json_tokener_new();
+        enum json_tokener_error jerr;
+        config = json_tokener_parse_ex(
+                tokener, config_str,
+                strlen(config_str));
+        if (!config) {
+            jerr = json_tokener_get_error(tokener);
+            margo_error(provider->mid, "JSON parse error: %s",
+                      json_tokener_error_desc(jerr));
+            json_tokener_free(tokener);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+        json_tokener_free(tokener);
+    } else {
+        // create default JSON config
+        config = json_object_new_object();
+    }
+
+    int64_t shards = KV_DEFAULT_SHARDS;
+    struct json_object* val;
+    int shards_ok = 1;
+    if ((val = json_object_object_get(config, "shards"))) {
+        shards = json_object_get_int64(val);
+        shards_ok = json_object_is_type(val, json_type_int);
+    } else
+        json_object_object_add(config, "shards", json_object_new_int64(shards));
+    if (!shards_ok || shards < 1 || shards > KV_MAX_SHARDS) {
+        margo_error(provider->mid, "\"shards\" must be an integer in [1, %d]",
+                KV_MAX_SHARDS);
+        json_object_put(config);
+        return CACHERCISE_ERR_INVALID_CONFIG;
+    }
+
+    kv_context* ctx = (kv_context*)calloc(1, sizeof(*ctx));
+    if (!ctx) {
+        json_object_put(config);
+        return CACHERCISE_ERR_ALLOCATION;
+    }
+    ctx->config = config;
+
+    ctx->shards = (kv_shard*)calloc(shards, sizeof(*ctx->shards));
+    if (!ctx->shards) {
+        kv_free_context(ctx);
+        return CACHERCISE_ERR_ALLOCATION;
+    }
+    size_t i;
+    for (i = 0; i < (size_t)shards; i++) {
+        kv_shard* s = &ctx->shards[i];
+        if (kv_alloc_table(s, KV_INITIAL_SLOTS)) {
+            kv_free_context(ctx);
+            return CACHERCISE_ERR_ALLOCATION;
+        }
+        ABT_mutex_create(&s->mutex);
+        ctx->num_shards = i + 1;
+    }
+
+    *context = (void*)ctx;
+    return CACHERCISE_SUCCESS;
+}
+
+static void kv_free_context(kv_context* ctx)
+{
+    size_t i, j;
+    for (i = 0; i < ctx->num_shards; i++) {
+        kv_shard* s = &ctx->shards[i];
+        for (j = 0; j < s->capacity; j++)
+            if (s->ctrl[j] < KV_EMPTY) free(s->slots[j].item);
+        free(s->ctrl);
+        free(s->slots);
+        ABT_mutex_free(&s->mutex);
+    }
+    free(ctx->shards);
+    json_object_put(ctx->config);
+    free(ctx);
+}
+
+static cachercise_return_t kv_create_cache(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    return kv_init_context(provider, config_str, context);
+}
+
+static cachercise_return_t kv_open_cache(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    return kv_init_context(provider, config_str, context);
+}
+
+static cachercise_return_t kv_close_cache(void* ctx)
+{
+    kv_free_context((kv_context*)ctx);
+    return CACHERCISE_SUCCESS;
+}
+
+static cachercise_return_t kv_destroy_cache(void* ctx)
+{
+    return kv_close_cache(ctx);
+}
+
+static void kv_say_hello(void* ctx)
+{
+    (void)ctx;
+    printf("Hello World from KV cache\n");
+}
+
+static char* kv_get_config(void* ctx)
+{
+    kv_context* context = (kv_context*)ctx;
+    return strdup(json_object_to_json_string_ext(context->config,
+                JSON_C_TO_STRING_PLAIN));
+}
+
+static int32_t kv_compute_sum(void* ctx, int32_t x, int32_t y)
+{
+    (void)ctx;
+    return x+y;
+}
+
+/* a word at a time, then splitmix64's finalizer; the length goes in first
+ * so that keys differing only by trailing zero bytes differ */
+static inline uint64_t kv_hash(const void* key, size_t size)
+{
+    const unsigned char* p = (const unsigned char*)key;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ size, w;
+    for (; size >= 8; size -= 8, p += 8) {
+        memcpy(&w, p, 8);
+        h = (h ^ w) * 0x9fb21c651e98df25ULL;
+        h ^= h >> 32;
+    }
+    if (size) {
+        w = 0;
+        memcpy(&w, p, size);
+        h = (h ^ w) * 0x9fb21c651e98df25ULL;
+    }
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+/* bit i set where the group's control byte i is b */
+static inline uint32_t kv_match(const uint8_t* group, uint8_t b)
+{
+#if defined(__SSE2__)
+    __m128i g = _mm_load_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)b)));
+#else
+    uint32_t m = 0;
+    int i;
+    for (i = 0; i < KV_GROUP; i++)
+        m |= (uint32_t)(group[i] == b) << i;
+    return m;
+#endif
+}
+
+/* bit i set where the group's slot i is EMPTY or DELETED */
+static inline uint32_t kv_match_free(const uint8_t* group)
+{
+#if defined(__SSE2__)
+    return (uint32_t)_mm_movemask_epi8(_mm_load_si128((const __m128i*)group));
+#else
+    uint32_t m = 0;
+    int i;
+    for (i = 0; i < KV_GROUP; i++)
+        m |= (uint32_t)(group[i] >> 7) << i;
+    return m;
+#endif
+}
+
+static inline kv_shard* kv_shard_of(kv_context* ctx, uint64_t hash)
+{
+    return &ctx->shards[(hash >> 32) % ctx->num_shards];
+}
+
+/* the slot holding key, or -1 */
+static ssize_t kv_find(kv_shard* s, const void* key, size_t size, uint64_t hash)
+{
+    size_t mask = s->capacity / KV_GROUP - 1;
+    size_t g = (hash >> 7) & mask, step = 0;
+    for (;;) {
+        const uint8_t* group = s->ctrl + g * KV_GROUP;
+        uint32_t m = kv_match(group, hash & 0x7f);
+        while (m) {
+            size_t i = g * KV_GROUP + __builtin_ctz(m);
+            const kv_item* item = s->slots[i].item;
+            if (s->slots[i].hash == hash && item->key_size == size
+             && memcmp(item->data, key, size) == 0)
+                return i;
+            m &= m - 1;
+        }
+        if (kv_match(group, KV_EMPTY)) return -1;
+        g = (g + ++step) & mask;
+    }
+}
+
+/* the first EMPTY or DELETED slot on hash's probe sequence */
+static size_t kv_free_slot(kv_shard* s, uint64_t hash)
+{
+    size_t mask = s->capacity / KV_GROUP - 1;
+    size_t g = (hash >> 7) & mask, step = 0;
+    uint32_t m;
+    while (!(m = kv_match_free(s->ctrl + g * KV_GROUP)))
+        g = (g + ++step) & mask;
+    return g * KV_GROUP + __builtin_ctz(m);
+}
+
+/* fills a free slot with item, first rebuilding the table (dropping
+ * DELETED slots, and growing it if need be) once it is 7/8 full */
+static int kv_insert(kv_shard* s, uint64_t hash, kv_item* item)
+{
+    size_t i;
+    if ((s->used + s->deleted + 1) * 8 > s->capacity * 7) {
+        kv_shard old = *s;
+        size_t capacity = s->capacity;
+        while ((s->used + 1) * 2 > capacity) capacity *= 2;
+        if (kv_alloc_table(s, capacity)) {
+            *s = old;
+            return -1;
+        }
+        for (i = 0; i < old.capacity; i++) {
+            if (old.ctrl[i] >= KV_EMPTY) continue;
+            size_t j = kv_free_slot(s, old.slots[i].hash);
+            s->ctrl[j]  = old.ctrl[i];
+            s->slots[j] = old.slots[i];
+        }
+        free(old.ctrl);
+        free(old.slots);
+    }
+    i = kv_free_slot(s, hash);
+    if (s->ctrl[i] == KV_DELETED) s->deleted--;
+    s->used++;
+    s->ctrl[i]        = hash & 0x7f;
+    s->slots[i].hash  = hash;
+    s->slots[i].item  = item;
+    return 0;
+}
+
+static int64_t kv_put(void* ctx, const void* key, size_t key_size,
+                      const void* value, size_t value_size)
+{
+    kv_context* context = (kv_context*)ctx;
+    uint64_t hash = kv_hash(key, key_size);
+    kv_shard* s = kv_shard_of(context, hash);
+    int64_t ret = value_size;
+    kv_item* item;
+
+    if (key_size > UINT32_MAX || value_size > UINT32_MAX) return -1;
+
+    ABT_mutex_lock(s->mutex);
+    ssize_t i = kv_find(s, key, key_size, hash);
+    if (i >= 0) {
+        item = s->slots[i].item;
+        if (item->value_size != value_size) {
+            item = (kv_item*)realloc(item, sizeof(*item) + key_size + value_size);
+            if (!item) {
+                ret = -1;
+                goto finish;
+            }
+            item->value_size = value_size;
+            s->slots[i].item = item;
+        }
+        memcpy(item->data + key_size, value, value_size);
+        goto finish;
+    }
+    item = (kv_item*)malloc(sizeof(*item) + key_size + value_size);
+    if (!item) {
+        ret = -1;
+        goto finish;
+    }
+    item->key_size   = key_size;
+    item->value_size = value_size;
+    memcpy(item->data, key, key_size);
+    memcpy(item->data + key_size, value, value_size);
+    if (kv_insert(s, hash, item)) {
+        free(item);
+        ret = -1;
+    }
+
+finish:
+    ABT_mutex_unlock(s->mutex);
+    return ret;
+}
+
+static int64_t kv_get(void* ctx, const void* key, size_t key_size,
+                      void* buf, size_t size)
+{
+    kv_context* context = (kv_context*)ctx;
+    uint64_t hash = kv_hash(key, key_size);
+    kv_shard* s = kv_shard_of(context, hash);
+    int64_t ret = CACHERCISE_BACKEND_NOT_FOUND;
+
+    ABT_mutex_lock(s->mutex);
+    ssize_t i = kv_find(s, key, key_size, hash);
+    if (i >= 0) {
+        const kv_item* item = s->slots[i].item;
+        memcpy(buf, item->data + key_size,
+               item->value_size < size ? item->value_size : size);
+        ret = item->value_size;
+    }
+    ABT_mutex_unlock(s->mutex);
+    return ret;
+}
+
+static int64_t kv_erase(void* ctx, const void* key, size_t key_size)
+{
+    kv_context* context = (kv_context*)ctx;
+    uint64_t hash = kv_hash(key, key_size);
+    kv_shard* s = kv_shard_of(context, hash);
+    int64_t ret = CACHERCISE_BACKEND_NOT_FOUND;
+
+    ABT_mutex_lock(s->mutex);
+    ssize_t i = kv_find(s, key, key_size, hash);
+    if (i >= 0) {
+        free(s->slots[i].item);
+        /* a group with an EMPTY slot ends every probe that reaches it, so
+         * none goes on past this slot: it can be EMPTY again */
+        if (kv_match(s->ctrl + (i & ~(ssize_t)(KV_GROUP - 1)), KV_EMPTY)) {
+            s->ctrl[i] = KV_EMPTY;
+        } else {
+            s->ctrl[i] = KV_DELETED;
+            s->deleted++;
+        }
+        s->used--;
+        ret = 0;
+    }
+    ABT_mutex_unlock(s->mutex);
+    return ret;
+}
+
+static cachercise_backend_impl kv_backend = {
+    .name             = "kv",
+
+    .create_cache  = kv_create_cache,
+    .open_cache    = kv_open_cache,
+    .close_cache   = kv_close_cache,
+    .destroy_cache = kv_destroy_cache,
+    .get_config    = kv_get_config,
+
+    .hello            = kv_say_hello,
+    .sum              = kv_compute_sum,
+    .kv_put           = kv_put,
+    .kv_get           = kv_get,
+    .kv_erase         = kv_erase
+};
+
+cachercise_return_t cachercise_provider_register_kv_backend(cachercise_provider_t provider)
+{
+    return cachercise_provider_register_backend(provider, &kv_backend);
+}
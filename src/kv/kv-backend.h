@@ -0,0 +1,13 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef _KV_BACKEND_H
+#define _KV_BACKEND_H
+
+#include "cachercise/cachercise-server.h"
+
+cachercise_return_t cachercise_provider_register_kv_backend(cachercise_provider_t provider);
+
+#endif
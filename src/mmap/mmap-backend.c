@@ -0,0 +1,272 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <json-c/json.h>
+#include "cachercise/cachercise-backend.h"
+#include "../provider.h"
+#include "mmap-backend.h"
+#include "../atomic-ops.h"
+
+/* The data lives in a file mapped into memory: a one-page header, then one
+ * int64 slot per element.  The file is sparse, so untouched ranges cost no
+ * disk, and the kernel pages data in on first access and out under memory
+ * pressure.  Reopening a cache just maps the file again, and whatever
+ * was written is immediately readable.
+ *
+ * Slots are read and written with relaxed atomics, as in the "atomic"
+ * backend, so there are no locks. */
+typedef struct mmap_context {
+    struct json_object* config;
+    const char* path;
+    int         fd;
+    size_t      capacity;  /* elements */
+    size_t      length;    /* bytes mapped */
+    char*       base;
+    int64_t*    data;
+} mmap_context;
+
+#define MMAP_MAGIC            "CACHMAP1"
+#define MMAP_HEADER_SIZE      4096
+#define MMAP_DEFAULT_CAPACITY (1UL << 27)
+/* the most elements whose mapping length still fits in a size_t */
+#define MMAP_MAX_CAPACITY     ((SIZE_MAX - MMAP_HEADER_SIZE) / sizeof(int64_t))
+
+typedef struct mmap_header {
+    char     magic[8];
+    uint64_t capacity;
+} mmap_header;
+
+static cachercise_return_t mmap_init_context(
+        cachercise_provider_t provider,
+        const char* config_str,
+        int create,
+        void** context)
+{
+    struct json_object* config = NULL;
+    struct json_object* val;
+    struct stat st;
+
+    // read JSON config from provided string argument
+    if (config_str) {
+        struct json_tokener*    tokener = json_tokener_new();
+        enum json_tokener_error jerr;
+        config = json_tokener_parse_ex(
+                tokener, config_str,
+                strlen(config_str));
+        if (!config) {
+            jerr = json_tokener_get_error(tokener);
+            margo_error(provider->mid, "JSON parse error: %s",
+                      json_tokener_error_desc(jerr));
+            json_tokener_free(tokener);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+        json_tokener_free(tokener);
+    } else {
+        // create default JSON config
+        config = json_object_new_object();
+    }
+
+    /* "path" is required; "capacity" (elements) sets the file size */
+    int64_t capacity = MMAP_DEFAULT_CAPACITY;
+    int capacity_ok = 1;
+    if ((val = json_object_object_get(config, "capacity"))) {
+        capacity = json_object_get_int64(val);
+        capacity_ok = json_object_is_type(val, json_type_int)
+                   && capacity >= 1 && (uint64_t)capacity <= MMAP_MAX_CAPACITY;
+    }
+    val = json_object_object_get(config, "path");
+    if (!val || !json_object_is_type(val, json_type_string) || !capacity_ok) {
+        margo_error(provider->mid, "\"path\" must be a file name and "
+                "\"capacity\" a positive integer no larger than %zu",
+                (size_t)MMAP_MAX_CAPACITY);
+        json_object_put(config);
+        return CACHERCISE_ERR_INVALID_CONFIG;
+    }
+
+    mmap_context* ctx = (mmap_context*)calloc(1, sizeof(*ctx));
+    ctx->config = config;
+    ctx->path   = json_object_get_string(val);
+    ctx->base   = MAP_FAILED;
+
+    ctx->fd = open(ctx->path, O_RDWR | O_CREAT | (create ? O_TRUNC : 0), 0644);
+    if (ctx->fd < 0 || fstat(ctx->fd, &st) != 0) {
+        margo_error(provider->mid, "Could not open %s", ctx->path);
+        goto error;
+    }
+
+    /* an existing file keeps its capacity unless the config asks for more */
+    if (st.st_size >= MMAP_HEADER_SIZE) {
+        mmap_header header;
+        if (pread(ctx->fd, &header, sizeof(header), 0) != sizeof(header)
+         || memcmp(header.magic, MMAP_MAGIC, sizeof(header.magic)) != 0) {
+            margo_error(provider->mid, "%s is not a cache file", ctx->path);
+            goto error;
+        }
+        /* the file was sized for its capacity when it was made */
+        if (header.capacity < 1 || header.capacity > MMAP_MAX_CAPACITY
+         || MMAP_HEADER_SIZE + header.capacity * sizeof(int64_t) > (uint64_t)st.st_size) {
+            margo_error(provider->mid, "%s has a corrupt header", ctx->path);
+            goto error;
+        }
+        if ((int64_t)header.capacity > capacity)
+            capacity = header.capacity;
+    }
+    json_object_object_add(config, "capacity", json_object_new_int64(capacity));
+    ctx->capacity = capacity;
+    ctx->length   = MMAP_HEADER_SIZE + ctx->capacity * sizeof(int64_t);
+
+    if ((size_t)st.st_size < ctx->length && ftruncate(ctx->fd, ctx->length) != 0) {
+        margo_error(provider->mid, "Could not size %s", ctx->path);
+        goto error;
+    }
+    ctx->base = (char*)mmap(NULL, ctx->length, PROT_READ | PROT_WRITE,
+            MAP_SHARED, ctx->fd, 0);
+    if (ctx->base == MAP_FAILED) {
+        margo_error(provider->mid, "Could not map %s", ctx->path);
+        goto error;
+    }
+    ctx->data = (int64_t*)(ctx->base + MMAP_HEADER_SIZE);
+
+    mmap_header* header = (mmap_header*)ctx->base;
+    memcpy(header->magic, MMAP_MAGIC, sizeof(header->magic));
+    header->capacity = ctx->capacity;
+
+    *context = (void*)ctx;
+    return CACHERCISE_SUCCESS;
+
+error:
+    if (ctx->fd >= 0) close(ctx->fd);
+    json_object_put(config);
+    free(ctx);
+    return CACHERCISE_ERR_INVALID_CONFIG;
+}
+
+static cachercise_return_t mmap_create_cache(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    return mmap_init_context(provider, config_str, 1, context);
+}
+
+static cachercise_return_t mmap_open_cache(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    return mmap_init_context(provider, config_str, 0, context);
+}
+
+/* dirty pages stay in the page cache and reach the file on their own, so
+ * closing needs no write-back of its own */
+static cachercise_return_t mmap_close_cache(void* ctx)
+{
+    mmap_context* context = (mmap_context*)ctx;
+    munmap(context->base, context->length);
+    close(context->fd);
+    json_object_put(context->config);
+    free(context);
+    return CACHERCISE_SUCCESS;
+}
+
+static cachercise_return_t mmap_destroy_cache(void* ctx)
+{
+    mmap_context* context = (mmap_context*)ctx;
+    unlink(context->path);
+    return mmap_close_cache(ctx);
+}
+
+static void mmap_say_hello(void* ctx)
+{
+    (void)ctx;
+    printf("Hello World from Mmap cache\n");
+}
+
+static char* mmap_get_config(void* ctx)
+{
+    mmap_context* context = (mmap_context*)ctx;
+    return strdup(json_object_to_json_string_ext(context->config,
+                JSON_C_TO_STRING_PLAIN));
+}
+
+static int32_t mmap_compute_sum(void* ctx, int32_t x, int32_t y)
+{
+    (void)ctx;
+    return x+y;
+}
+
+static int64_t mmap_io(void *ctx, uint64_t count, int64_t offset, int64_t *scratch, int kind)
+{
+    mmap_context* context = (mmap_context*)ctx;
+    size_t nitems = count/sizeof(int64_t);
+    size_t i;
+    if (offset < 0 || offset + nitems > context->capacity)
+        return -1;
+    int64_t* data = context->data + offset;
+    if (kind == CACHERCISE_WRITE)
+        for (i = 0; i < nitems; i++)
+            __atomic_store_n(&data[i], scratch[i], __ATOMIC_RELAXED);
+    else
+        for (i = 0; i < nitems; i++)
+            scratch[i] = __atomic_load_n(&data[i], __ATOMIC_RELAXED);
+    return nitems;
+}
+
+static int64_t mmap_io_batch(void *ctx, size_t count, const int64_t *offsets, int64_t *values, int kind)
+{
+    mmap_context* context = (mmap_context*)ctx;
+    size_t i;
+    for (i = 0; i < count; i++)
+        if (offsets[i] < 0 || (size_t)offsets[i] >= context->capacity)
+            return -1;
+    for (i = 0; i < count; i++) {
+        if (kind == CACHERCISE_WRITE)
+            __atomic_store_n(&context->data[offsets[i]], values[i], __ATOMIC_RELAXED);
+        else
+            values[i] = __atomic_load_n(&context->data[offsets[i]], __ATOMIC_RELAXED);
+    }
+    return count;
+}
+
+static int64_t mmap_atomic(void *ctx, int op, size_t count, const int64_t *offsets,
+        const int64_t *operands, const int64_t *compares, int64_t *olds)
+{
+    mmap_context* context = (mmap_context*)ctx;
+    size_t i;
+    for (i = 0; i < count; i++)
+        if (offsets[i] < 0 || (size_t)offsets[i] >= context->capacity)
+            return -1;
+    for (i = 0; i < count; i++)
+        olds[i] = cachercise_atomic_apply(&context->data[offsets[i]], op,
+                operands[i], compares ? compares[i] : 0);
+    return count;
+}
+
+static cachercise_backend_impl mmap_backend = {
+    .name             = "mmap",
+
+    .create_cache  = mmap_create_cache,
+    .open_cache    = mmap_open_cache,
+    .close_cache   = mmap_close_cache,
+    .destroy_cache = mmap_destroy_cache,
+    .get_config    = mmap_get_config,
+
+    .hello            = mmap_say_hello,
+    .sum              = mmap_compute_sum,
+    .io               = mmap_io,
+    .io_batch         = mmap_io_batch,
+    .atomic           = mmap_atomic
+};
+
+cachercise_return_t cachercise_provider_register_mmap_backend(cachercise_provider_t provider)
+{
+    return cachercise_provider_register_backend(provider, &mmap_backend);
+}
@@ -0,0 +1,179 @@
+#include <atomic>
+#include <new>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+
+/* A radix tree from page numbers to page pointers, for offset spaces that
+ * are used sparsely: memory goes with the pages touched, not with the
+ * highest one, and finding a page costs one load per level.
+ *
+ * Every node has 64 slots (6 bits of the page number), so an inner node is
+ * 512 bytes, eight cache lines, and a leaf adds a 64-byte line of per-page
+ * flags after its page pointers.  The tree is only as tall as the highest
+ * page needs: it grows by putting a new root above the old one, and the
+ * root pointer carries the height in its low bits so that readers pick up
+ * both with one load.
+ *
+ * make() must be serialized by the caller; find() and next() may run
+ * concurrently with it.  Nodes are published with release stores and only
+ * freed with the tree, so readers need no guard to walk it. */
+
+template <typename P>
+class PageTree {
+    public:
+        static const size_t NONE = SIZE_MAX;
+        /* a page's slot in the tree: its pointer and its flags */
+        struct Ref {
+            std::atomic<P*> * page;
+            std::atomic<uint8_t> * flags;
+            Ref() : page(nullptr), flags(nullptr) {}
+            Ref(std::atomic<P*> * p, std::atomic<uint8_t> * f) : page(p), flags(f) {}
+        };
+
+        PageTree() : m_root(0) {}
+        ~PageTree() {
+            uintptr_t root = m_root.load(std::memory_order_relaxed);
+            destroy(node_of(root), height_of(root));
+        }
+        PageTree(const PageTree &) = delete;
+        PageTree & operator=(const PageTree &) = delete;
+
+        /* the page's slot, or an empty Ref if the tree has none for it */
+        Ref find(size_t page) const {
+            uintptr_t root = m_root.load(std::memory_order_acquire);
+            void * n = node_of(root);
+            unsigned h = height_of(root);
+            if (!n || !covers(h, page)) return Ref();
+            for (; h > 0; h--) {
+                n = static_cast<Inner*>(n)->child[(page >> (BITS * h)) & MASK]
+                    .load(std::memory_order_acquire);
+                if (!n) return Ref();
+            }
+            Leaf * leaf = static_cast<Leaf*>(n);
+            return Ref(&leaf->pages[page & MASK], &leaf->flags[page & MASK]);
+        }
+
+        /* the page's slot, adding the nodes on its way if need be */
+        Ref make(size_t page) {
+            uintptr_t root = m_root.load(std::memory_order_relaxed);
+            void * n = node_of(root);
+            unsigned h = height_of(root);
+            if (!n) {
+                n = new Leaf();
+                h = 0;
+            }
+            while (!covers(h, page)) {
+                Inner * above = new Inner();
+                above->child[0].store(n, std::memory_order_relaxed);
+                n = above;
+                h++;
+            }
+            if (pack(n, h) != root)
+                m_root.store(pack(n, h), std::memory_order_release);
+            for (; h > 0; h--) {
+                std::atomic<void*> & slot =
+                    static_cast<Inner*>(n)->child[(page >> (BITS * h)) & MASK];
+                void * child = slot.load(std::memory_order_relaxed);
+                if (!child) {
+                    child = h == 1 ? static_cast<void*>(new Leaf())
+                                   : static_cast<void*>(new Inner());
+                    slot.store(child, std::memory_order_release);
+                }
+                n = child;
+            }
+            Leaf * leaf = static_cast<Leaf*>(n);
+            return Ref(&leaf->pages[page & MASK], &leaf->flags[page & MASK]);
+        }
+
+        /* the first page from page on whose pointer is not null, NONE if
+         * there is none; ref receives its slot */
+        size_t next(size_t page, Ref * ref) const {
+            uintptr_t root = m_root.load(std::memory_order_acquire);
+            void * n = node_of(root);
+            unsigned h = height_of(root);
+            if (!n || !covers(h, page)) return NONE;
+            return next_in(n, h, 0, page, ref);
+        }
+
+    private:
+        static const unsigned BITS = 6;
+        static const size_t FANOUT = size_t(1) << BITS;
+        static const size_t MASK = FANOUT - 1;
+        /* on cache line boundaries, which also frees the low bits of
+         * their addresses for the root's height */
+        struct Aligned {
+            static void * operator new(size_t size) {
+                void * p;
+                if (posix_memalign(&p, 64, size)) throw std::bad_alloc();
+                return p;
+            }
+            static void operator delete(void * p) { free(p); }
+        };
+        struct Inner : Aligned {
+            std::atomic<void*> child[FANOUT];
+            Inner() {
+                for (size_t i = 0; i < FANOUT; i++)
+                    child[i].store(nullptr, std::memory_order_relaxed);
+            }
+        };
+        struct Leaf : Aligned {
+            std::atomic<P*> pages[FANOUT];
+            std::atomic<uint8_t> flags[FANOUT];
+            Leaf() {
+                for (size_t i = 0; i < FANOUT; i++) {
+                    pages[i].store(nullptr, std::memory_order_relaxed);
+                    flags[i].store(0, std::memory_order_relaxed);
+                }
+            }
+        };
+        /* node pointer | height; nodes are 64-byte aligned */
+        std::atomic<uintptr_t> m_root;
+
+        static void * node_of(uintptr_t root) {
+            return reinterpret_cast<void*>(root & ~uintptr_t(63));
+        }
+        static unsigned height_of(uintptr_t root) { return root & 63; }
+        static uintptr_t pack(void * n, unsigned h) {
+            return reinterpret_cast<uintptr_t>(n) | h;
+        }
+        /* whether a tree of height h reaches page */
+        static bool covers(unsigned h, size_t page) {
+            return BITS * (h + 1) >= 64 || (page >> (BITS * (h + 1))) == 0;
+        }
+        /* first non-null page >= page below n, a node of height h whose
+         * first page is base */
+        static size_t next_in(void * n, unsigned h, size_t base, size_t page,
+                Ref * ref) {
+            size_t shift = BITS * h;
+            size_t i = page > base ? (page - base) >> shift : 0;
+            if (h == 0) {
+                Leaf * leaf = static_cast<Leaf*>(n);
+                for (; i < FANOUT; i++)
+                    if (leaf->pages[i].load(std::memory_order_acquire)) {
+                        *ref = Ref(&leaf->pages[i], &leaf->flags[i]);
+                        return base + i;
+                    }
+                return NONE;
+            }
+            for (; i < FANOUT; i++) {
+                void * child = static_cast<Inner*>(n)->child[i]
+                    .load(std::memory_order_acquire);
+                if (!child) continue;
+                size_t found = next_in(child, h - 1, base + (i << shift), page, ref);
+                if (found != NONE) return found;
+            }
+            return NONE;
+        }
+        static void destroy(void * n, unsigned h) {
+            if (!n) return;
+            if (h == 0) {
+                delete static_cast<Leaf*>(n);
+                return;
+            }
+            Inner * inner = static_cast<Inner*>(n);
+            for (size_t i = 0; i < FANOUT; i++)
+                destroy(inner->child[i].load(std::memory_order_relaxed), h - 1);
+            delete inner;
+        }
+};
@@ -6,9 +6,14 @@
 #include "cachercise/cachercise-server.h"
 #include "provider.h"
 #include "types.h"
+#include "atomic-ops.h"
 
 // backends that we want to add at compile time
 #include "dummy/dummy-backend.h"
+#include "atomic/atomic-backend.h"
+#include "mmap/mmap-backend.h"
+#include "slab/slab-backend.h"
+#include "kv/kv-backend.h"
 
 static void cachercise_finalize_provider(void* p);
 
@@ -17,6 +22,8 @@ static inline cachercise_cache* find_cache(
         cachercise_provider_t provider,
         const cachercise_cache_id_t* id);
 
+static inline size_t cache_element_size(cachercise_cache* cache);
+
 static inline cachercise_return_t add_cache(
         cachercise_provider_t provider,
         cachercise_cache* cache);
@@ -55,6 +62,8 @@ static DECLARE_MARGO_RPC_HANDLER(cachercise_destroy_cache_ult)
 static void cachercise_destroy_cache_ult(hg_handle_t h);
 static DECLARE_MARGO_RPC_HANDLER(cachercise_list_caches_ult)
 static void cachercise_list_caches_ult(hg_handle_t h);
+static DECLARE_MARGO_RPC_HANDLER(cachercise_get_cache_config_ult)
+static void cachercise_get_cache_config_ult(hg_handle_t h);
 
 /* Client RPCs */
 static DECLARE_MARGO_RPC_HANDLER(cachercise_hello_ult)
@@ -66,6 +75,18 @@ static void cachercise_sum_ult(hg_handle_t h);
 
 static DECLARE_MARGO_RPC_HANDLER(cachercise_io_ult)
 static void cachercise_io_ult(hg_handle_t h);
+static DECLARE_MARGO_RPC_HANDLER(cachercise_io_batch_ult)
+static void cachercise_io_batch_ult(hg_handle_t h);
+static DECLARE_MARGO_RPC_HANDLER(cachercise_io_bulk_ult)
+static void cachercise_io_bulk_ult(hg_handle_t h);
+static DECLARE_MARGO_RPC_HANDLER(cachercise_atomic_ult)
+static void cachercise_atomic_ult(hg_handle_t h);
+static DECLARE_MARGO_RPC_HANDLER(cachercise_blob_ult)
+static void cachercise_blob_ult(hg_handle_t h);
+static DECLARE_MARGO_RPC_HANDLER(cachercise_kv_ult)
+static void cachercise_kv_ult(hg_handle_t h);
+static DECLARE_MARGO_RPC_HANDLER(cachercise_scan_ult)
+static void cachercise_scan_ult(hg_handle_t h);
 
 int cachercise_provider_register(
         margo_instance_id mid,
@@ -136,6 +157,12 @@ int cachercise_provider_register(
     margo_register_data(mid, id, (void*)p, NULL);
     p->list_caches_id = id;
 
+    id = MARGO_REGISTER_PROVIDER(mid, "cachercise_get_cache_config",
+            get_cache_config_in_t, get_cache_config_out_t,
+            cachercise_get_cache_config_ult, provider_id, p->pool);
+    margo_register_data(mid, id, (void*)p, NULL);
+    p->get_cache_config_id = id;
+
     /* Client RPCs */
 
     id = MARGO_REGISTER_PROVIDER(mid, "cachercise_hello",
@@ -158,8 +185,48 @@ int cachercise_provider_register(
     margo_register_data(mid, id, (void *)p, NULL);
     p->io_id = id;
 
+    id = MARGO_REGISTER_PROVIDER(mid, "cachercise_io_batch",
+            io_batch_in_t, io_batch_out_t,
+            cachercise_io_batch_ult, provider_id, p->pool);
+    margo_register_data(mid, id, (void *)p, NULL);
+    p->io_batch_id = id;
+
+    id = MARGO_REGISTER_PROVIDER(mid, "cachercise_io_bulk",
+            io_bulk_in_t, io_bulk_out_t,
+            cachercise_io_bulk_ult, provider_id, p->pool);
+    margo_register_data(mid, id, (void *)p, NULL);
+    p->io_bulk_id = id;
+
+    id = MARGO_REGISTER_PROVIDER(mid, "cachercise_atomic",
+            atomic_in_t, atomic_out_t,
+            cachercise_atomic_ult, provider_id, p->pool);
+    margo_register_data(mid, id, (void *)p, NULL);
+    p->atomic_id = id;
+
+    id = MARGO_REGISTER_PROVIDER(mid, "cachercise_blob",
+            blob_in_t, blob_out_t,
+            cachercise_blob_ult, provider_id, p->pool);
+    margo_register_data(mid, id, (void *)p, NULL);
+    p->blob_id = id;
+
+    id = MARGO_REGISTER_PROVIDER(mid, "cachercise_kv",
+            kv_in_t, kv_out_t,
+            cachercise_kv_ult, provider_id, p->pool);
+    margo_register_data(mid, id, (void *)p, NULL);
+    p->kv_id = id;
+
+    id = MARGO_REGISTER_PROVIDER(mid, "cachercise_scan",
+            scan_in_t, scan_out_t,
+            cachercise_scan_ult, provider_id, p->pool);
+    margo_register_data(mid, id, (void *)p, NULL);
+    p->scan_id = id;
+
     /* add backends available at compiler time (e.g. default/dummy backends) */
     cachercise_provider_register_dummy_backend(p); // function from "dummy/dummy-backend.h"
+    cachercise_provider_register_atomic_backend(p); // function from "atomic/atomic-backend.h"
+    cachercise_provider_register_mmap_backend(p); // function from "mmap/mmap-backend.h"
+    cachercise_provider_register_slab_backend(p); // function from "slab/slab-backend.h"
+    cachercise_provider_register_kv_backend(p); // function from "kv/kv-backend.h"
 
     margo_provider_push_finalize_callback(mid, p, &cachercise_finalize_provider, p);
 
@@ -178,10 +245,17 @@ static void cachercise_finalize_provider(void* p)
     margo_deregister(provider->mid, provider->close_cache_id);
     margo_deregister(provider->mid, provider->destroy_cache_id);
     margo_deregister(provider->mid, provider->list_caches_id);
+    margo_deregister(provider->mid, provider->get_cache_config_id);
     margo_deregister(provider->mid, provider->hello_id);
     margo_deregister(provider->mid, provider->sum_id);
     /* deregister other RPC ids ... */
     margo_deregister(provider->mid, provider->io_id);
+    margo_deregister(provider->mid, provider->io_batch_id);
+    margo_deregister(provider->mid, provider->io_bulk_id);
+    margo_deregister(provider->mid, provider->atomic_id);
+    margo_deregister(provider->mid, provider->blob_id);
+    margo_deregister(provider->mid, provider->kv_id);
+    margo_deregister(provider->mid, provider->scan_id);
     remove_all_caches(provider);
     free(provider->backend_types);
     free(provider->token);
@@ -511,6 +585,62 @@ finish:
 }
 static DEFINE_MARGO_RPC_HANDLER(cachercise_list_caches_ult)
 
+static void cachercise_get_cache_config_ult(hg_handle_t h)
+{
+    hg_return_t hret;
+    get_cache_config_in_t  in;
+    get_cache_config_out_t out;
+    char* config = NULL;
+
+    /* find margo instance */
+    margo_instance_id mid = margo_hg_handle_get_instance(h);
+
+    /* find provider */
+    const struct hg_info* info = margo_get_info(h);
+    cachercise_provider_t provider = (cachercise_provider_t)margo_registered_data(mid, info->id);
+
+    /* deserialize the input */
+    hret = margo_get_input(h, &in);
+    if(hret != HG_SUCCESS) {
+        margo_error(mid, "Could not deserialize output (mercury error %d)", hret);
+        out.ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    /* check the token sent by the admin */
+    if(!check_token(provider, in.token)) {
+        margo_error(mid, "Invalid token");
+        out.ret = CACHERCISE_ERR_INVALID_TOKEN;
+        goto finish;
+    }
+
+    /* find the cache */
+    cachercise_cache* cache = find_cache(provider, &in.id);
+    if(!cache) {
+        margo_error(mid, "Could not find cache");
+        out.ret = CACHERCISE_ERR_INVALID_CACHE;
+        goto finish;
+    }
+
+    /* check if the backend can report its configuration */
+    if(!cache->fn->get_config) {
+        margo_error(mid, "Backend does not report its configuration");
+        out.ret = CACHERCISE_ERR_OP_UNSUPPORTED;
+        goto finish;
+    }
+
+    config = cache->fn->get_config(cache->ctx);
+    out.ret = config ? CACHERCISE_SUCCESS : CACHERCISE_ERR_ALLOCATION;
+
+finish:
+    out.config = config ? config : (char*)"";
+    hret = margo_respond(h, &out);
+    hret = margo_free_input(h, &in);
+    free(config);
+    margo_destroy(h);
+}
+static DEFINE_MARGO_RPC_HANDLER(cachercise_get_cache_config_ult)
+
 static void cachercise_hello_ult(hg_handle_t h)
 {
     hg_return_t hret;
@@ -595,6 +725,7 @@ static void cachercise_io_ult(hg_handle_t h)
     hg_return_t hret;
     io_in_t in;
     io_out_t out;
+    memset(&out, 0, sizeof(out));
 
     /* find the margo instance */
     margo_instance_id mid = margo_hg_handle_get_instance(h);
@@ -619,22 +750,655 @@ static void cachercise_io_ult(hg_handle_t h)
         goto finish;
     }
 
+    if(!cache->fn->io) {
+        out.ret = CACHERCISE_ERR_OP_UNSUPPORTED;
+        goto finish;
+    }
+
+    /* only writes decode data: anything else must be a read */
+    if((in.kind != CACHERCISE_READ && in.kind != CACHERCISE_WRITE) || in.offset < 0) {
+        out.ret = CACHERCISE_ERR_INVALID_ARGS;
+        goto finish;
+    }
+
+    /* writes bring their data along; reads need somewhere to put it */
+    int64_t* buf = in.data;
+    if(in.kind == CACHERCISE_READ) {
+        buf = in.count <= sizeof(out.scratch) ? &(out.scratch) : (int64_t*)malloc(in.count);
+        if(!buf) {
+            out.ret = CACHERCISE_ERR_ALLOCATION;
+            goto finish;
+        }
+        out.data = buf;
+    }
+
     /* call io on the cache's context */
-    out.result = cache->fn->io(cache->ctx, in.count, in.offset, &(in.scratch), in.kind);
+    out.result = cache->fn->io(cache->ctx, in.count, in.offset, buf, in.kind);
+    if(out.result < 0) {
+        out.ret = CACHERCISE_ERR_OTHER;
+        goto finish;
+    }
     out.ret = CACHERCISE_SUCCESS;
-    out.bytes = out.result * sizeof(int64_t);
-    out.scratch = in.scratch;
+    out.bytes = out.result * cache_element_size(cache);
+    if(in.kind == CACHERCISE_READ)
+        out.size = out.bytes;
 
     margo_debug(mid, "Called I/O RPC");
 
 finish:
     hret = margo_respond(h, &out);
     hret = margo_free_input(h, &in);
+    if(out.data != &(out.scratch))
+        free(out.data);
     margo_destroy(h);
 
 }
 static DEFINE_MARGO_RPC_HANDLER(cachercise_io_ult)
 
+static void cachercise_io_bulk_ult(hg_handle_t h)
+{
+    hg_return_t hret;
+    io_bulk_in_t in;
+    io_bulk_out_t out;
+    hg_bulk_t local = HG_BULK_NULL;
+    int64_t* buf = NULL;
+    out.bytes = 0;
+
+    /* find the margo instance */
+    margo_instance_id mid = margo_hg_handle_get_instance(h);
+
+    /* find the provider */
+    const struct hg_info* info = margo_get_info(h);
+    cachercise_provider_t provider = (cachercise_provider_t)margo_registered_data(mid, info->id);
+
+    /* deserialize the input */
+    hret = margo_get_input(h, &in);
+    if(hret != HG_SUCCESS) {
+        margo_error(mid, "Could not deserialize output (mercury error %d)", hret);
+        out.ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    /* find the cache */
+    cachercise_cache* cache = find_cache(provider, &in.cache_id);
+    if(!cache) {
+        margo_error(mid, "Could not find requested cache");
+        out.ret = CACHERCISE_ERR_INVALID_CACHE;
+        goto finish;
+    }
+
+    if(!cache->fn->io) {
+        out.ret = CACHERCISE_ERR_OP_UNSUPPORTED;
+        goto finish;
+    }
+
+    if((in.kind != CACHERCISE_READ && in.kind != CACHERCISE_WRITE) || in.offset < 0) {
+        out.ret = CACHERCISE_ERR_INVALID_ARGS;
+        goto finish;
+    }
+
+    /* data is staged through a bounded buffer, one chunk at a time: the
+     * backend decides where (and under which lock) it finally lands */
+    size_t esize = cache_element_size(cache);
+    hg_size_t chunk = in.count < CACHERCISE_BULK_CHUNK_SIZE ? in.count : CACHERCISE_BULK_CHUNK_SIZE;
+    chunk -= chunk % esize; /* chunks end on element boundaries */
+    if(chunk < esize) chunk = esize;
+    buf = (int64_t*)malloc(chunk);
+    if(!buf) {
+        out.ret = CACHERCISE_ERR_ALLOCATION;
+        goto finish;
+    }
+    hret = margo_bulk_create(mid, 1, (void**)&buf, &chunk, HG_BULK_READWRITE, &local);
+    if(hret != HG_SUCCESS) {
+        out.ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    out.ret = CACHERCISE_SUCCESS;
+    uint64_t done;
+    for(done = 0; done < in.count; done += chunk) {
+        hg_size_t n = in.count - done < chunk ? in.count - done : chunk;
+        int64_t offset = in.offset + done / esize;
+        int64_t result;
+        if(in.kind == CACHERCISE_WRITE) {
+            hret = margo_bulk_transfer(mid, HG_BULK_PULL, info->addr,
+                    in.bulk, done, local, 0, n);
+            if(hret != HG_SUCCESS) {
+                out.ret = CACHERCISE_ERR_FROM_MERCURY;
+                break;
+            }
+            result = cache->fn->io(cache->ctx, n, offset, buf, in.kind);
+        } else {
+            result = cache->fn->io(cache->ctx, n, offset, buf, in.kind);
+            if(result > 0) {
+                hret = margo_bulk_transfer(mid, HG_BULK_PUSH, info->addr,
+                        in.bulk, done, local, 0, result * esize);
+                if(hret != HG_SUCCESS) {
+                    out.ret = CACHERCISE_ERR_FROM_MERCURY;
+                    break;
+                }
+            }
+        }
+        if(result < 0) {
+            out.ret = CACHERCISE_ERR_OTHER;
+            break;
+        }
+        out.bytes += result * esize;
+    }
+
+    margo_debug(mid, "Called I/O bulk RPC");
+
+finish:
+    hret = margo_respond(h, &out);
+    hret = margo_free_input(h, &in);
+    if(local != HG_BULK_NULL)
+        margo_bulk_free(local);
+    free(buf);
+    margo_destroy(h);
+}
+static DEFINE_MARGO_RPC_HANDLER(cachercise_io_bulk_ult)
+
+static void cachercise_io_batch_ult(hg_handle_t h)
+{
+    hg_return_t hret;
+    io_batch_in_t in;
+    io_batch_out_t out;
+    out.count  = 0;
+    out.values = NULL;
+
+    /* find the margo instance */
+    margo_instance_id mid = margo_hg_handle_get_instance(h);
+
+    /* find the provider */
+    const struct hg_info* info = margo_get_info(h);
+    cachercise_provider_t provider = (cachercise_provider_t)margo_registered_data(mid, info->id);
+
+    /* deserialize the input */
+    hret = margo_get_input(h, &in);
+    if(hret != HG_SUCCESS) {
+        margo_error(mid, "Could not deserialize output (mercury error %d)", hret);
+        out.ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    /* find the cache */
+    cachercise_cache* cache = find_cache(provider, &in.cache_id);
+    if(!cache) {
+        margo_error(mid, "Could not find requested cache");
+        out.ret = CACHERCISE_ERR_INVALID_CACHE;
+        goto finish;
+    }
+
+    if(!cache->fn->io_batch) {
+        out.ret = CACHERCISE_ERR_OP_UNSUPPORTED;
+        goto finish;
+    }
+
+    if(in.kind != CACHERCISE_READ && in.kind != CACHERCISE_WRITE) {
+        out.ret = CACHERCISE_ERR_INVALID_ARGS;
+        goto finish;
+    }
+    hg_size_t i;
+    for(i = 0; i < in.count; i++) {
+        if(in.offsets[i] < 0) {
+            out.ret = CACHERCISE_ERR_INVALID_ARGS;
+            goto finish;
+        }
+    }
+
+    /* call io_batch on the cache's context */
+    if(cache->fn->io_batch(cache->ctx, in.count, in.offsets, in.values, in.kind) < 0) {
+        out.ret = CACHERCISE_ERR_OTHER;
+        goto finish;
+    }
+    out.ret = CACHERCISE_SUCCESS;
+    if(in.kind == CACHERCISE_READ) {
+        out.count  = in.count;
+        out.values = in.values;
+    }
+
+    margo_debug(mid, "Called I/O batch RPC");
+
+finish:
+    hret = margo_respond(h, &out);
+    hret = margo_free_input(h, &in);
+    margo_destroy(h);
+}
+static DEFINE_MARGO_RPC_HANDLER(cachercise_io_batch_ult)
+
+static void cachercise_atomic_ult(hg_handle_t h)
+{
+    hg_return_t hret;
+    atomic_in_t in;
+    atomic_out_t out;
+    out.count = 0;
+    out.olds  = &out.scratch;
+
+    /* find the margo instance */
+    margo_instance_id mid = margo_hg_handle_get_instance(h);
+
+    /* find the provider */
+    const struct hg_info* info = margo_get_info(h);
+    cachercise_provider_t provider = (cachercise_provider_t)margo_registered_data(mid, info->id);
+
+    /* deserialize the input */
+    hret = margo_get_input(h, &in);
+    if(hret != HG_SUCCESS) {
+        margo_error(mid, "Could not deserialize output (mercury error %d)", hret);
+        out.ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    /* find the cache */
+    cachercise_cache* cache = find_cache(provider, &in.cache_id);
+    if(!cache) {
+        margo_error(mid, "Could not find requested cache");
+        out.ret = CACHERCISE_ERR_INVALID_CACHE;
+        goto finish;
+    }
+
+    if(!cache->fn->atomic) {
+        out.ret = CACHERCISE_ERR_OP_UNSUPPORTED;
+        goto finish;
+    }
+    if(!cachercise_atomic_op_valid(in.op)) {
+        out.ret = CACHERCISE_ERR_INVALID_ARGS;
+        goto finish;
+    }
+
+    if(in.count > 1) {
+        out.olds = (int64_t*)malloc(in.count * sizeof(int64_t));
+        if(!out.olds) {
+            out.olds = &out.scratch;
+            out.ret = CACHERCISE_ERR_ALLOCATION;
+            goto finish;
+        }
+    }
+
+    /* call atomic on the cache's context */
+    if(cache->fn->atomic(cache->ctx, in.op, in.count, in.offsets,
+                in.operands, in.compares, out.olds) < 0) {
+        out.ret = CACHERCISE_ERR_OTHER;
+        goto finish;
+    }
+    out.ret   = CACHERCISE_SUCCESS;
+    out.count = in.count;
+
+    margo_debug(mid, "Called atomic RPC");
+
+finish:
+    hret = margo_respond(h, &out);
+    hret = margo_free_input(h, &in);
+    if(out.olds != &out.scratch)
+        free(out.olds);
+    margo_destroy(h);
+}
+static DEFINE_MARGO_RPC_HANDLER(cachercise_atomic_ult)
+
+static void cachercise_blob_ult(hg_handle_t h)
+{
+    hg_return_t hret;
+    blob_in_t in;
+    blob_out_t out;
+    hg_bulk_t local = HG_BULK_NULL;
+    void* buf = NULL;
+    int64_t result;
+    out.size = 0;
+
+    /* find the margo instance */
+    margo_instance_id mid = margo_hg_handle_get_instance(h);
+
+    /* find the provider */
+    const struct hg_info* info = margo_get_info(h);
+    cachercise_provider_t provider = (cachercise_provider_t)margo_registered_data(mid, info->id);
+
+    /* deserialize the input */
+    hret = margo_get_input(h, &in);
+    if(hret != HG_SUCCESS) {
+        margo_error(mid, "Could not deserialize output (mercury error %d)", hret);
+        out.ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    /* find the cache */
+    cachercise_cache* cache = find_cache(provider, &in.cache_id);
+    if(!cache) {
+        margo_error(mid, "Could not find requested cache");
+        out.ret = CACHERCISE_ERR_INVALID_CACHE;
+        goto finish;
+    }
+
+    if(!cache->fn->blob_put || !cache->fn->blob_get || !cache->fn->blob_erase) {
+        out.ret = CACHERCISE_ERR_OP_UNSUPPORTED;
+        goto finish;
+    }
+
+    if(in.kind == CACHERCISE_ERASE) {
+        result = cache->fn->blob_erase(cache->ctx, in.key);
+        out.ret = result == CACHERCISE_BACKEND_NOT_FOUND ? CACHERCISE_ERR_NOT_FOUND
+                : result < 0 ? CACHERCISE_ERR_OTHER : CACHERCISE_SUCCESS;
+        goto finish;
+    }
+
+    /* a value is staged whole, so it must fit in one bulk chunk; reads
+     * never need more room than that either */
+    hg_size_t size = in.size;
+    if(in.kind == CACHERCISE_WRITE && size > CACHERCISE_BULK_CHUNK_SIZE) {
+        out.ret = CACHERCISE_ERR_INVALID_ARGS;
+        goto finish;
+    }
+    if(size > CACHERCISE_BULK_CHUNK_SIZE) size = CACHERCISE_BULK_CHUNK_SIZE;
+    if(size > 0) {
+        buf = malloc(size);
+        if(!buf) {
+            out.ret = CACHERCISE_ERR_ALLOCATION;
+            goto finish;
+        }
+        hret = margo_bulk_create(mid, 1, &buf, &size, HG_BULK_READWRITE, &local);
+        if(hret != HG_SUCCESS) {
+            out.ret = CACHERCISE_ERR_FROM_MERCURY;
+            goto finish;
+        }
+    }
+
+    if(in.kind == CACHERCISE_WRITE) {
+        if(size > 0) {
+            hret = margo_bulk_transfer(mid, HG_BULK_PULL, info->addr,
+                    in.bulk, 0, local, 0, size);
+            if(hret != HG_SUCCESS) {
+                out.ret = CACHERCISE_ERR_FROM_MERCURY;
+                goto finish;
+            }
+        }
+        result = cache->fn->blob_put(cache->ctx, in.key, buf, size);
+        out.ret = result < 0 ? CACHERCISE_ERR_OTHER : CACHERCISE_SUCCESS;
+    } else {
+        result = cache->fn->blob_get(cache->ctx, in.key, buf, size);
+        if(result < 0) {
+            out.ret = result == CACHERCISE_BACKEND_NOT_FOUND ?
+                CACHERCISE_ERR_NOT_FOUND : CACHERCISE_ERR_OTHER;
+            goto finish;
+        }
+        /* the caller learns the whole length even if it made less room */
+        out.size = result;
+        if((hg_size_t)result < size) size = result;
+        if(size > 0) {
+            hret = margo_bulk_transfer(mid, HG_BULK_PUSH, info->addr,
+                    in.bulk, 0, local, 0, size);
+            if(hret != HG_SUCCESS) {
+                out.ret = CACHERCISE_ERR_FROM_MERCURY;
+                goto finish;
+            }
+        }
+        out.ret = CACHERCISE_SUCCESS;
+    }
+
+    margo_debug(mid, "Called blob RPC");
+
+finish:
+    hret = margo_respond(h, &out);
+    hret = margo_free_input(h, &in);
+    if(local != HG_BULK_NULL)
+        margo_bulk_free(local);
+    free(buf);
+    margo_destroy(h);
+}
+static DEFINE_MARGO_RPC_HANDLER(cachercise_blob_ult)
+
+static void cachercise_kv_ult(hg_handle_t h)
+{
+    hg_return_t hret;
+    kv_in_t in;
+    kv_out_t out;
+    hg_bulk_t local = HG_BULK_NULL;
+    char* buf = NULL;
+    int64_t result;
+    kv_record_hdr hdr;
+    size_t i, off, reply_off;
+
+    /* find the margo instance */
+    margo_instance_id mid = margo_hg_handle_get_instance(h);
+
+    /* find the provider */
+    const struct hg_info* info = margo_get_info(h);
+    cachercise_provider_t provider = (cachercise_provider_t)margo_registered_data(mid, info->id);
+
+    /* deserialize the input */
+    hret = margo_get_input(h, &in);
+    if(hret != HG_SUCCESS) {
+        margo_error(mid, "Could not deserialize output (mercury error %d)", hret);
+        out.ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+
+    /* find the cache */
+    cachercise_cache* cache = find_cache(provider, &in.cache_id);
+    if(!cache) {
+        margo_error(mid, "Could not find requested cache");
+        out.ret = CACHERCISE_ERR_INVALID_CACHE;
+        goto finish;
+    }
+
+    if(!cache->fn->kv_put || !cache->fn->kv_get || !cache->fn->kv_erase) {
+        out.ret = CACHERCISE_ERR_OP_UNSUPPORTED;
+        goto finish;
+    }
+
+    /* the whole batch is staged at once, records and replies together */
+    if((in.kind != CACHERCISE_WRITE && in.kind != CACHERCISE_READ
+     && in.kind != CACHERCISE_ERASE)
+     || in.size > CACHERCISE_BULK_CHUNK_SIZE
+     || in.reply > CACHERCISE_BULK_CHUNK_SIZE - in.size
+     || (in.kind == CACHERCISE_READ && in.count > in.reply / sizeof(int64_t))) {
+        out.ret = CACHERCISE_ERR_INVALID_ARGS;
+        goto finish;
+    }
+    hg_size_t size = in.size + in.reply;
+    if(size > 0) {
+        buf = malloc(size);
+        if(!buf) {
+            out.ret = CACHERCISE_ERR_ALLOCATION;
+            goto finish;
+        }
+        hret = margo_bulk_create(mid, 1, (void**)&buf, &size, HG_BULK_READWRITE, &local);
+        if(hret != HG_SUCCESS) {
+            out.ret = CACHERCISE_ERR_FROM_MERCURY;
+            goto finish;
+        }
+    }
+    if(in.size > 0) {
+        hret = margo_bulk_transfer(mid, HG_BULK_PULL, info->addr,
+                in.bulk, 0, local, 0, in.size);
+        if(hret != HG_SUCCESS) {
+            out.ret = CACHERCISE_ERR_FROM_MERCURY;
+            goto finish;
+        }
+    }
+
+    int64_t* lengths = (int64_t*)(buf + in.size);
+    reply_off = in.size + in.count * sizeof(int64_t);
+    out.ret = CACHERCISE_SUCCESS;
+    for(i = 0, off = 0; i < in.count; i++) {
+        if(off > in.size || in.size - off < sizeof(hdr)) {
+            out.ret = CACHERCISE_ERR_INVALID_ARGS;
+            goto finish;
+        }
+        memcpy(&hdr, buf + off, sizeof(hdr));
+        const char* key = buf + off + sizeof(hdr);
+        size_t record = sizeof(hdr) + hdr.key_size
+                      + (in.kind == CACHERCISE_WRITE ? hdr.value_size : 0);
+        if(in.size - off < record) {
+            out.ret = CACHERCISE_ERR_INVALID_ARGS;
+            goto finish;
+        }
+        if(in.kind == CACHERCISE_WRITE) {
+            result = cache->fn->kv_put(cache->ctx, key, hdr.key_size,
+                    key + hdr.key_size, hdr.value_size);
+            if(result < 0) out.ret = CACHERCISE_ERR_OTHER;
+        } else if(in.kind == CACHERCISE_READ) {
+            if(size - reply_off < KV_PAD(hdr.value_size)) {
+                out.ret = CACHERCISE_ERR_INVALID_ARGS;
+                goto finish;
+            }
+            result = cache->fn->kv_get(cache->ctx, key, hdr.key_size,
+                    buf + reply_off, hdr.value_size);
+            if(result < 0 && result != CACHERCISE_BACKEND_NOT_FOUND)
+                out.ret = CACHERCISE_ERR_OTHER;
+            lengths[i] = result < 0 ? -1 : result;
+            reply_off += KV_PAD(hdr.value_size);
+        } else {
+            result = cache->fn->kv_erase(cache->ctx, key, hdr.key_size);
+            if(result == CACHERCISE_BACKEND_NOT_FOUND) {
+                if(out.ret == CACHERCISE_SUCCESS) out.ret = CACHERCISE_ERR_NOT_FOUND;
+            } else if(result < 0) {
+                out.ret = CACHERCISE_ERR_OTHER;
+            }
+        }
+        off += KV_PAD(record);
+    }
+
+    /* only as much of the reply as was filled goes back */
+    if(in.kind == CACHERCISE_READ && in.count > 0) {
+        hret = margo_bulk_transfer(mid, HG_BULK_PUSH, info->addr,
+                in.bulk, in.size, local, in.size, reply_off - in.size);
+        if(hret != HG_SUCCESS) {
+            out.ret = CACHERCISE_ERR_FROM_MERCURY;
+            goto finish;
+        }
+    }
+
+    margo_debug(mid, "Called kv RPC");
+
+finish:
+    hret = margo_respond(h, &out);
+    hret = margo_free_input(h, &in);
+    if(local != HG_BULK_NULL)
+        margo_bulk_free(local);
+    free(buf);
+    margo_destroy(h);
+}
+static DEFINE_MARGO_RPC_HANDLER(cachercise_kv_ult)
+
+static void cachercise_scan_ult(hg_handle_t h)
+{
+    hg_return_t hret;
+    scan_in_t in;
+    scan_out_t out;
+    hg_bulk_t local = HG_BULK_NULL;
+    char* buf = NULL;
+    scan_extent_hdr hdr;
+    out.bytes = 0;
+
+    /* find the margo instance */
+    margo_instance_id mid = margo_hg_handle_get_instance(h);
+
+    /* find the provider */
+    const struct hg_info* info = margo_get_info(h);
+    cachercise_provider_t provider = (cachercise_provider_t)margo_registered_data(mid, info->id);
+
+    /* deserialize the input */
+    hret = margo_get_input(h, &in);
+    if(hret != HG_SUCCESS) {
+        margo_error(mid, "Could not deserialize output (mercury error %d)", hret);
+        out.ret = CACHERCISE_ERR_FROM_MERCURY;
+        goto finish;
+    }
+    out.cursor = in.start;
+
+    /* find the cache */
+    cachercise_cache* cache = find_cache(provider, &in.cache_id);
+    if(!cache) {
+        margo_error(mid, "Could not find requested cache");
+        out.ret = CACHERCISE_ERR_INVALID_CACHE;
+        goto finish;
+    }
+
+    if(!cache->fn->io
+    || ((in.flags & CACHERCISE_SCAN_POPULATED) && !cache->fn->populated)) {
+        out.ret = CACHERCISE_ERR_OP_UNSUPPORTED;
+        goto finish;
+    }
+
+    /* at most one staging chunk per call, room for an extent at least */
+    size_t esize = cache_element_size(cache);
+    hg_size_t size = in.size < CACHERCISE_BULK_CHUNK_SIZE ? in.size : CACHERCISE_BULK_CHUNK_SIZE;
+    size &= ~(hg_size_t)7;
+    if(in.start < 0 || in.end < in.start
+    || (in.end > in.start && size < sizeof(hdr) + KV_PAD(esize))) {
+        out.ret = CACHERCISE_ERR_INVALID_ARGS;
+        goto finish;
+    }
+    if(in.end > in.start) {
+        buf = malloc(size);
+        if(!buf) {
+            out.ret = CACHERCISE_ERR_ALLOCATION;
+            goto finish;
+        }
+        hret = margo_bulk_create(mid, 1, (void**)&buf, &size, HG_BULK_READ_ONLY, &local);
+        if(hret != HG_SUCCESS) {
+            out.ret = CACHERCISE_ERR_FROM_MERCURY;
+            goto finish;
+        }
+    }
+
+    /* extents until the range or the buffer runs out; the whole range is
+     * one extent, populated offsets as many as there are runs of them */
+    size_t pos = 0;
+    int64_t cursor = in.start;
+    while(cursor < in.end && size - pos >= sizeof(hdr) + KV_PAD(esize)) {
+        uint64_t room = (size - pos - sizeof(hdr)) / esize;
+        int64_t start = cursor, count;
+        if(in.flags & CACHERCISE_SCAN_POPULATED) {
+            count = cache->fn->populated(cache->ctx, cursor, in.end, room, &start);
+            if(count < 0) {
+                out.ret = CACHERCISE_ERR_OTHER;
+                goto finish;
+            }
+            if(count == 0) {
+                cursor = in.end;
+                break;
+            }
+        } else {
+            count = (uint64_t)(in.end - cursor) < room ? in.end - cursor : (int64_t)room;
+        }
+        int64_t result = cache->fn->io(cache->ctx, count * esize, start,
+                (int64_t*)(buf + pos + sizeof(hdr)), CACHERCISE_READ);
+        if(result != count) {
+            out.ret = CACHERCISE_ERR_OTHER;
+            goto finish;
+        }
+        hdr.offset = start;
+        hdr.count  = count;
+        hdr.size   = count * esize;
+        memcpy(buf + pos, &hdr, sizeof(hdr));
+        pos += sizeof(hdr) + KV_PAD(hdr.size);
+        cursor = start + count;
+    }
+
+    if(pos > 0) {
+        hret = margo_bulk_transfer(mid, HG_BULK_PUSH, info->addr,
+                in.bulk, 0, local, 0, pos);
+        if(hret != HG_SUCCESS) {
+            out.ret = CACHERCISE_ERR_FROM_MERCURY;
+            goto finish;
+        }
+    }
+    out.bytes  = pos;
+    out.cursor = cursor;
+    out.ret    = CACHERCISE_SUCCESS;
+
+    margo_debug(mid, "Called scan RPC");
+
+finish:
+    hret = margo_respond(h, &out);
+    hret = margo_free_input(h, &in);
+    if(local != HG_BULK_NULL)
+        margo_bulk_free(local);
+    free(buf);
+    margo_destroy(h);
+}
+static DEFINE_MARGO_RPC_HANDLER(cachercise_scan_ult)
+
 static inline cachercise_cache* find_cache(
         cachercise_provider_t provider,
         const cachercise_cache_id_t* id)
@@ -644,6 +1408,11 @@ static inline cachercise_cache* find_cache(
     return cache;
 }
 
+static inline size_t cache_element_size(cachercise_cache* cache)
+{
+    return cache->fn->element_size ? cache->fn->element_size(cache->ctx) : sizeof(int64_t);
+}
+
 static inline cachercise_return_t add_cache(
         cachercise_provider_t provider,
         cachercise_cache* cache)
@@ -707,7 +1476,8 @@ static inline cachercise_return_t add_backend_impl(
 {
     provider->num_backend_types += 1;
     provider->backend_types = realloc(provider->backend_types,
-                                      provider->num_backend_types);
+                                      provider->num_backend_types
+                                      * sizeof(*provider->backend_types));
     provider->backend_types[provider->num_backend_types-1] = backend;
     return CACHERCISE_SUCCESS;
 }
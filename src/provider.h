@@ -13,6 +13,9 @@
 #include "uthash.h"
 #include "hoard-c.h"
 
+/* largest piece of a bulk io staged in provider memory at once */
+#define CACHERCISE_BULK_CHUNK_SIZE (4*1024*1024)
+
 typedef struct cachercise_cache {
     cachercise_backend_impl* fn;  // pointer to function mapping for this backend
     void*               ctx; // context required by the backend
@@ -39,11 +42,18 @@ typedef struct cachercise_provider {
     hg_id_t close_cache_id;
     hg_id_t destroy_cache_id;
     hg_id_t list_caches_id;
+    hg_id_t get_cache_config_id;
     /* RPC identifiers for clients */
     hg_id_t hello_id;
     hg_id_t sum_id;
     /* ... add other RPC identifiers here ... */
     hg_id_t io_id;
+    hg_id_t io_batch_id;
+    hg_id_t io_bulk_id;
+    hg_id_t atomic_id;
+    hg_id_t blob_id;
+    hg_id_t kv_id;
+    hg_id_t scan_id;
 
 } cachercise_provider;
 
@@ -0,0 +1,431 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <string.h>
+#include <json-c/json.h>
+#include "cachercise/cachercise-backend.h"
+#include "../provider.h"
+#include "slab-backend.h"
+
+/* A store of variable-length values (blobs) by 64-bit key, rather than of
+ * int64 slots by offset.  Values live in size-class slabs, the way memcached
+ * keeps them: 1 MiB slabs are carved into equal slots, one slot size per
+ * class, the classes growing by a quarter from 64 bytes up to a whole slab.
+ * A value takes one slot of the smallest class it fits, so millions of
+ * values cost no malloc each and leave no holes only some sizes fit; the
+ * price is the unused tail of each slot.  A freed slot goes on its class's
+ * free list for the next value of that class; slabs are never given back.
+ *
+ * Keys are found through an open-addressing (linear probing) hash table of
+ * 16-byte entries: the key, the value's length and a 32-bit reference to
+ * its slot, the slab's number and the slot's within it.
+ *
+ * Keys are spread by hash over "shards", each with its own lock, table and
+ * slabs, so that writers of different keys rarely meet.  Values are copied
+ * in and out under the shard's lock. */
+
+#define SLAB_SIZE         (1UL << 20)
+#define SLAB_MIN_SLOT     64
+#define SLAB_SLOT_BITS    14  /* SLAB_SIZE / SLAB_MIN_SLOT slots at most */
+#define SLAB_MAX_SLABS    ((1UL << (32 - SLAB_SLOT_BITS)) - 1)
+#define SLAB_MAX_CLASSES  64
+#define SLAB_NONE         0xffffffffU  /* no slot; also an empty entry */
+#define SLAB_DELETED      0xfffffffeU  /* an entry whose key was erased */
+#define SLAB_DEFAULT_SHARDS 16
+/* each shard starts with a table of its own */
+#define SLAB_MAX_SHARDS     4096
+#define SLAB_INITIAL_ENTRIES 1024
+
+typedef struct slab_entry {
+    uint64_t key;
+    uint32_t length;
+    uint32_t ref;
+} slab_entry;
+
+typedef struct slab_class {
+    uint32_t free;     /* first free slot, SLAB_NONE if none */
+    uint32_t current;  /* slab being carved, SLAB_NONE if none */
+    size_t   carved;   /* slots handed out of it so far */
+} slab_class;
+
+typedef struct slab_shard {
+    ABT_mutex   mutex;
+    slab_entry* table;
+    size_t      capacity;  /* entries, a power of two */
+    size_t      used;      /* live entries */
+    size_t      deleted;   /* tombstones */
+    char**      slabs;
+    uint8_t*    slab_class;
+    size_t      num_slabs, max_slabs;
+    slab_class  classes[SLAB_MAX_CLASSES];
+} slab_shard;
+
+typedef struct slab_context {
+    struct json_object* config;
+    size_t      num_classes;
+    size_t      class_size[SLAB_MAX_CLASSES];
+    size_t      num_shards;
+    slab_shard* shards;
+} slab_context;
+
+static void slab_free_context(slab_context* ctx);
+
+static cachercise_return_t slab_init_context(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    struct json_object* config = NULL;
+
+    // read JSON config from provided string argument
+    if (config_str) {
+        struct json_tokener*    tokener = json_tokener_new();
+        enum json_tokener_error jerr;
+        config = json_tokener_parse_ex(
+                tokener, config_str,
+                strlen(config_str));
+        if (!config) {
+            jerr = json_tokener_get_error(tokener);
+            margo_error(provider->mid, "JSON parse error: %s",
+                      json_tokener_error_desc(jerr));
+            json_tokener_free(tokener);
+            return CACHERCISE_ERR_INVALID_CONFIG;
+        }
+        json_tokener_free(tokener);
+    } else {
+        // create default JSON config
+        config = json_object_new_object();
+    }
+
+    int64_t shards = SLAB_DEFAULT_SHARDS;
+    struct json_object* val;
+    int shards_ok = 1;
+    if ((val = json_object_object_get(config, "shards"))) {
+        shards = json_object_get_int64(val);
+        shards_ok = json_object_is_type(val, json_type_int);
+    } else
+        json_object_object_add(config, "shards", json_object_new_int64(shards));
+    if (!shards_ok || shards < 1 || shards > SLAB_MAX_SHARDS) {
+        margo_error(provider->mid, "\"shards\" must be an integer in [1, %d]",
+                SLAB_MAX_SHARDS);
+        json_object_put(config);
+        return CACHERCISE_ERR_INVALID_CONFIG;
+    }
+
+    slab_context* ctx = (slab_context*)calloc(1, sizeof(*ctx));
+    if (!ctx) {
+        json_object_put(config);
+        return CACHERCISE_ERR_ALLOCATION;
+    }
+    ctx->config = config;
+
+    /* slot sizes grow by a quarter, in multiples of 8, up to a whole slab */
+    size_t size = SLAB_MIN_SLOT;
+    while (size < SLAB_SIZE) {
+        ctx->class_size[ctx->num_classes++] = size;
+        size = (size + size / 4 + 7) & ~(size_t)7;
+    }
+    ctx->class_size[ctx->num_classes++] = SLAB_SIZE;
+
+    ctx->shards = (slab_shard*)calloc(shards, sizeof(*ctx->shards));
+    if (!ctx->shards) {
+        slab_free_context(ctx);
+        return CACHERCISE_ERR_ALLOCATION;
+    }
+    size_t i, c;
+    for (i = 0; i < (size_t)shards; i++) {
+        slab_shard* s = &ctx->shards[i];
+        s->table = (slab_entry*)malloc(SLAB_INITIAL_ENTRIES * sizeof(*s->table));
+        if (!s->table) {
+            slab_free_context(ctx);
+            return CACHERCISE_ERR_ALLOCATION;
+        }
+        memset(s->table, 0xff, SLAB_INITIAL_ENTRIES * sizeof(*s->table));
+        s->capacity = SLAB_INITIAL_ENTRIES;
+        for (c = 0; c < ctx->num_classes; c++) {
+            s->classes[c].free    = SLAB_NONE;
+            s->classes[c].current = SLAB_NONE;
+        }
+        ABT_mutex_create(&s->mutex);
+        ctx->num_shards = i + 1;
+    }
+
+    *context = (void*)ctx;
+    return CACHERCISE_SUCCESS;
+}
+
+static void slab_free_context(slab_context* ctx)
+{
+    size_t i, j;
+    for (i = 0; i < ctx->num_shards; i++) {
+        slab_shard* s = &ctx->shards[i];
+        for (j = 0; j < s->num_slabs; j++)
+            free(s->slabs[j]);
+        free(s->slabs);
+        free(s->slab_class);
+        free(s->table);
+        ABT_mutex_free(&s->mutex);
+    }
+    free(ctx->shards);
+    json_object_put(ctx->config);
+    free(ctx);
+}
+
+static cachercise_return_t slab_create_cache(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    return slab_init_context(provider, config_str, context);
+}
+
+static cachercise_return_t slab_open_cache(
+        cachercise_provider_t provider,
+        const char* config_str,
+        void** context)
+{
+    return slab_init_context(provider, config_str, context);
+}
+
+static cachercise_return_t slab_close_cache(void* ctx)
+{
+    slab_free_context((slab_context*)ctx);
+    return CACHERCISE_SUCCESS;
+}
+
+static cachercise_return_t slab_destroy_cache(void* ctx)
+{
+    return slab_close_cache(ctx);
+}
+
+static void slab_say_hello(void* ctx)
+{
+    (void)ctx;
+    printf("Hello World from Slab cache\n");
+}
+
+static char* slab_get_config(void* ctx)
+{
+    slab_context* context = (slab_context*)ctx;
+    return strdup(json_object_to_json_string_ext(context->config,
+                JSON_C_TO_STRING_PLAIN));
+}
+
+static int32_t slab_compute_sum(void* ctx, int32_t x, int32_t y)
+{
+    (void)ctx;
+    return x+y;
+}
+
+/* splitmix64's finalizer: keys are often small consecutive integers */
+static inline uint64_t slab_hash(uint64_t key)
+{
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+}
+
+static inline size_t slab_class_of(slab_context* ctx, size_t size)
+{
+    size_t lo = 0, hi = ctx->num_classes - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (ctx->class_size[mid] < size) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static inline char* slab_slot(slab_context* ctx, slab_shard* s, uint32_t ref)
+{
+    uint32_t slab = ref >> SLAB_SLOT_BITS;
+    return s->slabs[slab]
+        + (ref & ((1U << SLAB_SLOT_BITS) - 1)) * ctx->class_size[s->slab_class[slab]];
+}
+
+/* takes a slot of class c: from the free list, else the rest of the
+ * current slab, else a new slab.  SLAB_NONE if out of memory. */
+static uint32_t slab_alloc(slab_context* ctx, slab_shard* s, size_t c)
+{
+    slab_class* cl = &s->classes[c];
+    uint32_t ref;
+    if (cl->free != SLAB_NONE) {
+        ref = cl->free;
+        memcpy(&cl->free, slab_slot(ctx, s, ref), sizeof(cl->free));
+        return ref;
+    }
+    if (cl->current == SLAB_NONE || cl->carved == SLAB_SIZE / ctx->class_size[c]) {
+        if (s->num_slabs == SLAB_MAX_SLABS) return SLAB_NONE;
+        if (s->num_slabs == s->max_slabs) {
+            size_t max = s->max_slabs ? 2 * s->max_slabs : 16;
+            char** slabs = (char**)realloc(s->slabs, max * sizeof(*slabs));
+            if (!slabs) return SLAB_NONE;
+            s->slabs = slabs;
+            uint8_t* classes = (uint8_t*)realloc(s->slab_class, max);
+            if (!classes) return SLAB_NONE;
+            s->slab_class = classes;
+            s->max_slabs  = max;
+        }
+        char* slab = (char*)malloc(SLAB_SIZE);
+        if (!slab) return SLAB_NONE;
+        s->slabs[s->num_slabs]      = slab;
+        s->slab_class[s->num_slabs] = c;
+        cl->current = s->num_slabs++;
+        cl->carved  = 0;
+    }
+    return (cl->current << SLAB_SLOT_BITS) | cl->carved++;
+}
+
+static inline void slab_release(slab_context* ctx, slab_shard* s, uint32_t ref)
+{
+    slab_class* cl = &s->classes[s->slab_class[ref >> SLAB_SLOT_BITS]];
+    memcpy(slab_slot(ctx, s, ref), &cl->free, sizeof(cl->free));
+    cl->free = ref;
+}
+
+static slab_entry* slab_find(slab_shard* s, uint64_t key, uint64_t hash)
+{
+    size_t mask = s->capacity - 1;
+    size_t i = hash & mask;
+    while (s->table[i].ref != SLAB_NONE) {
+        if (s->table[i].ref != SLAB_DELETED && s->table[i].key == key)
+            return &s->table[i];
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+/* a free entry for a key known to be absent, first rebuilding the table
+ * (dropping tombstones, and growing it if need be) once it is 3/4 full */
+static slab_entry* slab_insert(slab_shard* s, uint64_t key, uint64_t hash)
+{
+    size_t mask, i;
+    if ((s->used + s->deleted + 1) * 4 > s->capacity * 3) {
+        size_t capacity = s->capacity;
+        while ((s->used + 1) * 2 > capacity) capacity *= 2;
+        slab_entry* table = (slab_entry*)malloc(capacity * sizeof(*table));
+        if (!table) return NULL;
+        memset(table, 0xff, capacity * sizeof(*table));
+        for (i = 0; i < s->capacity; i++) {
+            if (s->table[i].ref >= SLAB_DELETED) continue;
+            size_t j = slab_hash(s->table[i].key) & (capacity - 1);
+            while (table[j].ref != SLAB_NONE) j = (j + 1) & (capacity - 1);
+            table[j] = s->table[i];
+        }
+        free(s->table);
+        s->table    = table;
+        s->capacity = capacity;
+        s->deleted  = 0;
+    }
+    mask = s->capacity - 1;
+    i = hash & mask;
+    while (s->table[i].ref < SLAB_DELETED) i = (i + 1) & mask;
+    if (s->table[i].ref == SLAB_DELETED) s->deleted--;
+    s->used++;
+    s->table[i].key = key;
+    return &s->table[i];
+}
+
+static inline slab_shard* slab_shard_of(slab_context* ctx, uint64_t hash)
+{
+    return &ctx->shards[(hash >> 32) % ctx->num_shards];
+}
+
+static int64_t slab_blob_put(void* ctx, uint64_t key, const void* data, size_t size)
+{
+    slab_context* context = (slab_context*)ctx;
+    uint64_t hash = slab_hash(key);
+    slab_shard* s = slab_shard_of(context, hash);
+    int64_t ret = size;
+
+    if (size > SLAB_SIZE) return -1;
+    size_t c = slab_class_of(context, size);
+
+    ABT_mutex_lock(s->mutex);
+    slab_entry* e = slab_find(s, key, hash);
+    if (e && s->slab_class[e->ref >> SLAB_SLOT_BITS] == c) {
+        /* same class: overwrite in place */
+        memcpy(slab_slot(context, s, e->ref), data, size);
+        e->length = size;
+        goto finish;
+    }
+    uint32_t ref = slab_alloc(context, s, c);
+    if (ref == SLAB_NONE) {
+        ret = -1;
+        goto finish;
+    }
+    if (e) {
+        slab_release(context, s, e->ref);
+    } else if (!(e = slab_insert(s, key, hash))) {
+        slab_release(context, s, ref);
+        ret = -1;
+        goto finish;
+    }
+    memcpy(slab_slot(context, s, ref), data, size);
+    e->ref    = ref;
+    e->length = size;
+
+finish:
+    ABT_mutex_unlock(s->mutex);
+    return ret;
+}
+
+static int64_t slab_blob_get(void* ctx, uint64_t key, void* buf, size_t size)
+{
+    slab_context* context = (slab_context*)ctx;
+    uint64_t hash = slab_hash(key);
+    slab_shard* s = slab_shard_of(context, hash);
+    int64_t ret = CACHERCISE_BACKEND_NOT_FOUND;
+
+    ABT_mutex_lock(s->mutex);
+    slab_entry* e = slab_find(s, key, hash);
+    if (e) {
+        memcpy(buf, slab_slot(context, s, e->ref), e->length < size ? e->length : size);
+        ret = e->length;
+    }
+    ABT_mutex_unlock(s->mutex);
+    return ret;
+}
+
+static int64_t slab_blob_erase(void* ctx, uint64_t key)
+{
+    slab_context* context = (slab_context*)ctx;
+    uint64_t hash = slab_hash(key);
+    slab_shard* s = slab_shard_of(context, hash);
+    int64_t ret = CACHERCISE_BACKEND_NOT_FOUND;
+
+    ABT_mutex_lock(s->mutex);
+    slab_entry* e = slab_find(s, key, hash);
+    if (e) {
+        slab_release(context, s, e->ref);
+        e->ref = SLAB_DELETED;
+        s->used--;
+        s->deleted++;
+        ret = 0;
+    }
+    ABT_mutex_unlock(s->mutex);
+    return ret;
+}
+
+static cachercise_backend_impl slab_backend = {
+    .name             = "slab",
+
+    .create_cache  = slab_create_cache,
+    .open_cache    = slab_open_cache,
+    .close_cache   = slab_close_cache,
+    .destroy_cache = slab_destroy_cache,
+    .get_config    = slab_get_config,
+
+    .hello            = slab_say_hello,
+    .sum              = slab_compute_sum,
+    .blob_put         = slab_blob_put,
+    .blob_get         = slab_blob_get,
+    .blob_erase       = slab_blob_erase
+};
+
+cachercise_return_t cachercise_provider_register_slab_backend(cachercise_provider_t provider)
+{
+    return cachercise_provider_register_backend(provider, &slab_backend);
+}
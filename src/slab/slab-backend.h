@@ -0,0 +1,13 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef _SLAB_BACKEND_H
+#define _SLAB_BACKEND_H
+
+#include "cachercise/cachercise-server.h"
+
+cachercise_return_t cachercise_provider_register_slab_backend(cachercise_provider_t provider);
+
+#endif
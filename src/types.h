@@ -11,6 +11,7 @@
 #include <mercury_macros.h>
 #include <mercury_proc.h>
 #include <mercury_proc_string.h>
+#include <mercury_proc_bulk.h>
 #include "cachercise/cachercise-common.h"
 
 static inline hg_return_t hg_proc_cachercise_cache_id_t(hg_proc_t proc, cachercise_cache_id_t *id);
@@ -85,6 +86,14 @@ static inline hg_return_t hg_proc_list_caches_out_t(hg_proc_t proc, void *data)
     return ret;
 }
 
+MERCURY_GEN_PROC(get_cache_config_in_t,
+        ((hg_string_t)(token))\
+        ((cachercise_cache_id_t)(id)))
+
+MERCURY_GEN_PROC(get_cache_config_out_t,
+        ((int32_t)(ret))\
+        ((hg_string_t)(config)))
+
 /* Client RPC types */
 
 MERCURY_GEN_PROC(hello_in_t,
@@ -99,18 +108,344 @@ MERCURY_GEN_PROC(sum_out_t,
         ((int32_t)(result))\
         ((int32_t)(ret)))
 
-MERCURY_GEN_PROC(io_in_t,
+/* io payloads travel inline, up to the client's bulk threshold.  A single
+ * word (the benchmark's common case) is kept in 'scratch' so that decoding
+ * it does not allocate; anything longer gets a buffer of its own. */
+typedef struct io_in_t {
+    cachercise_cache_id_t cache_id;
+    uint64_t count;  /* bytes */
+    int64_t  offset;
+    int64_t  kind;
+    int64_t  scratch;
+    int64_t* data;   /* count bytes, only sent for writes */
+} io_in_t;
+
+static inline hg_return_t hg_proc_io_in_t(hg_proc_t proc, void *data)
+{
+    io_in_t* in = (io_in_t*)data;
+    hg_return_t ret;
+
+    ret = hg_proc_cachercise_cache_id_t(proc, &(in->cache_id));
+    if(ret != HG_SUCCESS) return ret;
+    ret = hg_proc_uint64_t(proc, &(in->count));
+    if(ret != HG_SUCCESS) return ret;
+    ret = hg_proc_int64_t(proc, &(in->offset));
+    if(ret != HG_SUCCESS) return ret;
+    ret = hg_proc_int64_t(proc, &(in->kind));
+    if(ret != HG_SUCCESS) return ret;
+    if(in->kind != CACHERCISE_WRITE) return HG_SUCCESS;
+
+    switch(hg_proc_get_op(proc)) {
+    case HG_DECODE:
+        in->data = in->count <= sizeof(in->scratch) ?
+            &(in->scratch) : (int64_t*)malloc(in->count);
+        if(!in->data)
+            return HG_NOMEM;
+        /* fall through */
+    case HG_ENCODE:
+        ret = hg_proc_memcpy(proc, in->data, in->count);
+        break;
+    case HG_FREE:
+        if(in->data != &(in->scratch))
+            free(in->data);
+        break;
+    }
+    return ret;
+}
+
+typedef struct io_out_t {
+    uint64_t bytes;  /* bytes read or written */
+    int64_t  result;
+    int64_t  ret;
+    uint64_t size;   /* bytes of payload in data: only reads send one back */
+    int64_t  scratch;
+    int64_t* data;
+} io_out_t;
+
+static inline hg_return_t hg_proc_io_out_t(hg_proc_t proc, void *data)
+{
+    io_out_t* out = (io_out_t*)data;
+    hg_return_t ret;
+
+    ret = hg_proc_uint64_t(proc, &(out->bytes));
+    if(ret != HG_SUCCESS) return ret;
+    ret = hg_proc_int64_t(proc, &(out->result));
+    if(ret != HG_SUCCESS) return ret;
+    ret = hg_proc_int64_t(proc, &(out->ret));
+    if(ret != HG_SUCCESS) return ret;
+    ret = hg_proc_uint64_t(proc, &(out->size));
+    if(ret != HG_SUCCESS) return ret;
+
+    switch(hg_proc_get_op(proc)) {
+    case HG_DECODE:
+        out->data = out->size <= sizeof(out->scratch) ?
+            &(out->scratch) : (int64_t*)malloc(out->size);
+        if(!out->data)
+            return HG_NOMEM;
+        /* fall through */
+    case HG_ENCODE:
+        if(out->size)
+            ret = hg_proc_memcpy(proc, out->data, out->size);
+        break;
+    case HG_FREE:
+        if(out->data != &(out->scratch))
+            free(out->data);
+        break;
+    }
+    return ret;
+}
+
+MERCURY_GEN_PROC(io_bulk_in_t,
         ((cachercise_cache_id_t)(cache_id))\
         ((uint64_t)(count))\
         ((int64_t)(offset))\
-        ((int64_t)(scratch))\
-        ((int64_t)(kind)) )
+        ((int64_t)(kind))\
+        ((hg_bulk_t)(bulk)) )
 
-MERCURY_GEN_PROC(io_out_t,
+MERCURY_GEN_PROC(io_bulk_out_t,
         ((uint64_t)(bytes))\
-        ((int64_t)(scratch))\
-        ((int64_t)(result))\
         ((int64_t)(ret)) )
+
+/* a blob's bytes always go through bulk: size is the length to write or
+ * the room there is to read into (bulk is HG_BULK_NULL when it is 0) */
+MERCURY_GEN_PROC(blob_in_t,
+        ((cachercise_cache_id_t)(cache_id))\
+        ((uint64_t)(key))\
+        ((uint64_t)(size))\
+        ((int64_t)(kind))\
+        ((hg_bulk_t)(bulk)) )
+
+/* size: the value's whole length, for reads */
+MERCURY_GEN_PROC(blob_out_t,
+        ((uint64_t)(size))\
+        ((int64_t)(ret)) )
+
+/* a scan fills the client's buffer (size bytes) with extents from start
+ * on: each a scan_extent_hdr then its values, padded to 8 bytes.  cursor
+ * is where the next chunk starts, end once the range is done. */
+typedef struct scan_extent_hdr {
+    int64_t  offset;  /* elements */
+    uint64_t count;   /* elements */
+    uint64_t size;    /* bytes of values that follow */
+} scan_extent_hdr;
+
+MERCURY_GEN_PROC(scan_in_t,
+        ((cachercise_cache_id_t)(cache_id))\
+        ((int64_t)(start))\
+        ((int64_t)(end))\
+        ((int64_t)(flags))\
+        ((uint64_t)(size))\
+        ((hg_bulk_t)(bulk)) )
+
+MERCURY_GEN_PROC(scan_out_t,
+        ((int64_t)(cursor))\
+        ((uint64_t)(bytes))\
+        ((int64_t)(ret)) )
+
+/* a kv batch is one bulk buffer: size bytes of records, each a
+ * kv_record_hdr then the key then, for puts, the value, padded to 8 bytes;
+ * value_size is for gets the room the caller has.  Gets are answered in
+ * the reply bytes that follow: an int64 per record, the value's whole
+ * length or -1, then each value in a slot of its record's room, padded to
+ * 8 bytes. */
+typedef struct kv_record_hdr {
+    uint32_t key_size;
+    uint32_t value_size;
+} kv_record_hdr;
+
+#define KV_PAD(n) (((n) + 7) & ~(size_t)7)
+
+MERCURY_GEN_PROC(kv_in_t,
+        ((cachercise_cache_id_t)(cache_id))\
+        ((int64_t)(kind))\
+        ((uint64_t)(count))\
+        ((uint64_t)(size))\
+        ((uint64_t)(reply))\
+        ((hg_bulk_t)(bulk)) )
+
+MERCURY_GEN_PROC(kv_out_t,
+        ((int64_t)(ret)) )
+
+typedef struct io_batch_in_t {
+    cachercise_cache_id_t cache_id;
+    int64_t   kind;
+    hg_size_t count;
+    int64_t*  offsets;
+    int64_t*  values; /* only sent for writes */
+} io_batch_in_t;
+
+static inline hg_return_t hg_proc_io_batch_in_t(hg_proc_t proc, void *data)
+{
+    io_batch_in_t* in = (io_batch_in_t*)data;
+    hg_return_t ret;
+
+    ret = hg_proc_cachercise_cache_id_t(proc, &(in->cache_id));
+    if(ret != HG_SUCCESS) return ret;
+
+    ret = hg_proc_int64_t(proc, &(in->kind));
+    if(ret != HG_SUCCESS) return ret;
+
+    ret = hg_proc_hg_size_t(proc, &(in->count));
+    if(ret != HG_SUCCESS) return ret;
+
+    switch(hg_proc_get_op(proc)) {
+    case HG_DECODE:
+        in->offsets = (int64_t*)calloc(in->count, sizeof(*(in->offsets)));
+        in->values  = (int64_t*)calloc(in->count, sizeof(*(in->values)));
+        if(in->count && (!in->offsets || !in->values)) {
+            free(in->offsets);
+            free(in->values);
+            in->offsets = in->values = NULL;
+            return HG_NOMEM;
+        }
+        /* fall through */
+    case HG_ENCODE:
+        ret = hg_proc_memcpy(proc, in->offsets, sizeof(*(in->offsets))*in->count);
+        if(ret != HG_SUCCESS) return ret;
+        if(in->kind == CACHERCISE_WRITE)
+            ret = hg_proc_memcpy(proc, in->values, sizeof(*(in->values))*in->count);
+        break;
+    case HG_FREE:
+        free(in->offsets);
+        free(in->values);
+        break;
+    }
+    return ret;
+}
+
+typedef struct io_batch_out_t {
+    int32_t   ret;
+    hg_size_t count;
+    int64_t*  values; /* only sent back for reads */
+} io_batch_out_t;
+
+static inline hg_return_t hg_proc_io_batch_out_t(hg_proc_t proc, void *data)
+{
+    io_batch_out_t* out = (io_batch_out_t*)data;
+    hg_return_t ret;
+
+    ret = hg_proc_hg_int32_t(proc, &(out->ret));
+    if(ret != HG_SUCCESS) return ret;
+
+    ret = hg_proc_hg_size_t(proc, &(out->count));
+    if(ret != HG_SUCCESS) return ret;
+
+    switch(hg_proc_get_op(proc)) {
+    case HG_DECODE:
+        out->values = (int64_t*)calloc(out->count, sizeof(*(out->values)));
+        if(out->count && !out->values)
+            return HG_NOMEM;
+        /* fall through */
+    case HG_ENCODE:
+        if(out->values)
+            ret = hg_proc_memcpy(proc, out->values, sizeof(*(out->values))*out->count);
+        break;
+    case HG_FREE:
+        free(out->values);
+        break;
+    }
+    return ret;
+}
+
+/* atomic ops: a single operation (the common case) decodes into the
+ * scratch words rather than allocating */
+typedef struct atomic_in_t {
+    cachercise_cache_id_t cache_id;
+    int64_t   op;
+    hg_size_t count;
+    int64_t*  offsets;
+    int64_t*  operands;
+    int64_t*  compares; /* only sent for CAS */
+    int64_t   scratch[3];
+} atomic_in_t;
+
+static inline hg_return_t hg_proc_atomic_in_t(hg_proc_t proc, void *data)
+{
+    atomic_in_t* in = (atomic_in_t*)data;
+    hg_return_t ret;
+
+    ret = hg_proc_cachercise_cache_id_t(proc, &(in->cache_id));
+    if(ret != HG_SUCCESS) return ret;
+    ret = hg_proc_int64_t(proc, &(in->op));
+    if(ret != HG_SUCCESS) return ret;
+    ret = hg_proc_hg_size_t(proc, &(in->count));
+    if(ret != HG_SUCCESS) return ret;
+
+    int cas = in->op == CACHERCISE_ATOMIC_CAS;
+    switch(hg_proc_get_op(proc)) {
+    case HG_DECODE:
+        if(in->count == 1) {
+            in->offsets  = &(in->scratch[0]);
+            in->operands = &(in->scratch[1]);
+            in->compares = cas ? &(in->scratch[2]) : NULL;
+        } else {
+            in->offsets  = (int64_t*)calloc(in->count, sizeof(int64_t));
+            in->operands = (int64_t*)calloc(in->count, sizeof(int64_t));
+            in->compares = cas ? (int64_t*)calloc(in->count, sizeof(int64_t)) : NULL;
+            if(in->count && (!in->offsets || !in->operands || (cas && !in->compares))) {
+                free(in->offsets);
+                free(in->operands);
+                free(in->compares);
+                in->offsets = in->operands = in->compares = NULL;
+                return HG_NOMEM;
+            }
+        }
+        /* fall through */
+    case HG_ENCODE:
+        ret = hg_proc_memcpy(proc, in->offsets, sizeof(int64_t)*in->count);
+        if(ret != HG_SUCCESS) return ret;
+        ret = hg_proc_memcpy(proc, in->operands, sizeof(int64_t)*in->count);
+        if(ret != HG_SUCCESS) return ret;
+        if(cas)
+            ret = hg_proc_memcpy(proc, in->compares, sizeof(int64_t)*in->count);
+        break;
+    case HG_FREE:
+        if(in->count != 1) {
+            free(in->offsets);
+            free(in->operands);
+            free(in->compares);
+        }
+        break;
+    }
+    return ret;
+}
+
+typedef struct atomic_out_t {
+    int32_t   ret;
+    hg_size_t count;
+    int64_t*  olds;
+    int64_t   scratch;
+} atomic_out_t;
+
+static inline hg_return_t hg_proc_atomic_out_t(hg_proc_t proc, void *data)
+{
+    atomic_out_t* out = (atomic_out_t*)data;
+    hg_return_t ret;
+
+    ret = hg_proc_hg_int32_t(proc, &(out->ret));
+    if(ret != HG_SUCCESS) return ret;
+    ret = hg_proc_hg_size_t(proc, &(out->count));
+    if(ret != HG_SUCCESS) return ret;
+
+    switch(hg_proc_get_op(proc)) {
+    case HG_DECODE:
+        out->olds = out->count <= 1 ?
+            &(out->scratch) : (int64_t*)calloc(out->count, sizeof(int64_t));
+        if(!out->olds)
+            return HG_NOMEM;
+        /* fall through */
+    case HG_ENCODE:
+        if(out->count)
+            ret = hg_proc_memcpy(proc, out->olds, sizeof(int64_t)*out->count);
+        break;
+    case HG_FREE:
+        if(out->olds != &(out->scratch))
+            free(out->olds);
+        break;
+    }
+    return ret;
+}
+
 /* Extra hand-coded serialization functions */
 
 static inline hg_return_t hg_proc_cachercise_cache_id_t(
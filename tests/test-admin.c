@@ -4,6 +4,8 @@
  * See COPYRIGHT in top-level directory.
  */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <margo.h>
 #include <cachercise/cachercise-server.h>
 #include <cachercise/cachercise-admin.h>
@@ -100,6 +102,17 @@ static MunitResult test_cache(const MunitParameter params[], void* data)
     munit_assert_ulong(count, ==, 1);
     munit_assert_memory_equal(sizeof(id), ids, &id);
 
+    // test that the cache reports its configuration, defaults included
+    char* config = NULL;
+    ret = cachercise_get_cache_config(admin, context->addr,
+            provider_id, valid_token, id, &config);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    munit_assert_not_null(strstr(config, "\"foo\":\"bar\""));
+    munit_assert_not_null(strstr(config, "\"sync\":\"mutex\""));
+    munit_assert_not_null(strstr(config, "\"type\":\"int64\""));
+    munit_assert_not_null(strstr(config, "\"storage\":\"dense\""));
+    free(config);
+
     // test that we can destroy the cache we just created
     ret = cachercise_destroy_cache(admin, context->addr,
             provider_id, valid_token, id);
@@ -141,6 +154,63 @@ static MunitResult test_invalid(const MunitParameter params[], void* data)
             provider_id, valid_token, "dummy", "{ashqw{", &id);
     munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
 
+    // test that a non-positive stripe count is rejected
+    ret = cachercise_create_cache(admin, context->addr,
+            provider_id, valid_token, "dummy", "{ \"stripes\" : 0 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+
+    // test that pages too big to allocate are rejected up front
+    ret = cachercise_create_cache(admin, context->addr,
+            provider_id, valid_token, "dummy", "{ \"page_size\" : 1099511627776 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+
+    // test that snapshots need an abt-io instance, which this provider lacks
+    ret = cachercise_create_cache(admin, context->addr,
+            provider_id, valid_token, "dummy", "{ \"snapshot\" : \"/tmp/nowhere.snap\" }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+
+    // test that a durable cache needs a log file
+    ret = cachercise_create_cache(admin, context->addr,
+            provider_id, valid_token, "dummy", "{ \"durable\" : true }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+
+    // test that a memory limit needs somewhere to spill to
+    ret = cachercise_create_cache(admin, context->addr,
+            provider_id, valid_token, "dummy", "{ \"memory_limit\" : 4096 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+
+    // test that the configuration of an unknown cache cannot be read
+    char* config = NULL;
+    ret = cachercise_get_cache_config(admin, context->addr,
+            provider_id, valid_token, id, &config);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CACHE);
+
+    // test that an unknown synchronization strategy is rejected
+    ret = cachercise_create_cache(admin, context->addr,
+            provider_id, valid_token, "dummy", "{ \"sync\" : \"spinning\" }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+
+    // test that an unknown element type is rejected
+    ret = cachercise_create_cache(admin, context->addr,
+            provider_id, valid_token, "dummy", "{ \"type\" : \"record24\" }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+
+    // test that an unknown page storage is rejected
+    ret = cachercise_create_cache(admin, context->addr,
+            provider_id, valid_token, "dummy", "{ \"storage\" : \"tree\" }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+
+    // test that shards must name existing pools
+    ret = cachercise_create_cache(admin, context->addr,
+            provider_id, valid_token, "dummy", "{ \"shard_pools\" : [ \"no_such_pool\" ] }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+
+    // test that "stripes" has to agree with the number of shard pools
+    ret = cachercise_create_cache(admin, context->addr,
+            provider_id, valid_token, "dummy", "{ \"shard_pools\" : [ \"__primary__\" ], "
+            "\"stripes\" : 4 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+
     // test that calling with an unknown backend leads to an error
     ret = cachercise_create_cache(admin, context->addr,
             provider_id, valid_token, "blah", backend_config, &id);
@@ -4,11 +4,15 @@
  * See COPYRIGHT in top-level directory.
  */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <margo.h>
 #include <cachercise/cachercise-server.h>
 #include <cachercise/cachercise-admin.h>
 #include <cachercise/cachercise-client.h>
 #include <cachercise/cachercise-cache.h>
+#include <cachercise/cachercise-distributed.h>
 #include "munit/munit.h"
 
 struct test_context {
@@ -20,7 +24,7 @@ struct test_context {
 
 static const char* token = "ABCDEFGH";
 static const uint16_t provider_id = 42;
-static const char* backend_config = "{ \"foo\" : \"bar\" }";
+static const char* backend_config = "{ \"foo\" : \"bar\", \"stripes\" : 4, \"stripe_size\" : 2, \"page_size\" : 4 }";
 
 static void* test_context_setup(const MunitParameter params[], void* user_data)
 {
@@ -186,6 +190,1505 @@ static MunitResult test_sum(const MunitParameter params[], void* data)
     return MUNIT_OK;
 }
 
+static MunitResult test_io(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_return_t ret;
+    int64_t i;
+    // test that we can create a client object
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // test that we can create a cache handle
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, context->id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // write enough values to land in every stripe
+    for (i = 0; i < 32; i++) {
+        int64_t value = i + 100;
+        ret = cachercise_write(rh, &value, sizeof(value), i);
+        munit_assert_int(ret, ==, sizeof(value));
+    }
+    // test that every value reads back from the right place
+    for (i = 0; i < 32; i++) {
+        int64_t value = -1;
+        ret = cachercise_read(rh, &value, sizeof(value), i);
+        munit_assert_int(ret, ==, sizeof(value));
+        munit_assert_int64(value, ==, i + 100);
+    }
+    // test that the provider refuses unknown kinds and negative offsets
+    {
+        int64_t value = 7;
+        ret = cachercise_io(rh, &value, sizeof(value), 0, CACHERCISE_ERASE);
+        munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_ARGS);
+        ret = cachercise_read(rh, &value, sizeof(value), -1);
+        munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_ARGS);
+        ret = cachercise_write(rh, &value, sizeof(value), -1);
+        munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_ARGS);
+    }
+    // test that we can destroy the cache handle
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // test that we can free the client object
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_io_bulk(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_return_t ret;
+    int64_t i;
+    int64_t values[1024];
+    int64_t check[1024];
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, context->id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // a request this large goes through RDMA rather than inline
+    for (i = 0; i < 1024; i++)
+        values[i] = i * 3;
+    ret = cachercise_write(rh, values, sizeof(values), 5);
+    munit_assert_int(ret, ==, sizeof(values));
+    memset(check, 0, sizeof(check));
+    ret = cachercise_read(rh, check, sizeof(check), 5);
+    munit_assert_int(ret, ==, sizeof(check));
+    munit_assert_memory_equal(sizeof(values), values, check);
+    // with the threshold at zero even a single value takes the bulk path
+    ret = cachercise_client_set_bulk_threshold(client, 0);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    check[0] = -1;
+    ret = cachercise_read(rh, check, sizeof(int64_t), 10);
+    munit_assert_int(ret, ==, sizeof(int64_t));
+    munit_assert_int64(check[0], ==, values[5]);
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_io_async(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_return_t ret;
+    cachercise_request_t reqs[16];
+    int64_t values[16];
+    int64_t big[512];
+    int64_t i;
+    int flag;
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, context->id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // keep many writes in flight at once
+    for (i = 0; i < 16; i++) {
+        values[i] = i + 200;
+        ret = cachercise_io_async(rh, &values[i], sizeof(int64_t), i,
+                CACHERCISE_WRITE, &reqs[i]);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    }
+    ret = cachercise_test(reqs[0], &flag);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (i = 0; i < 16; i++) {
+        ret = cachercise_wait(reqs[i]);
+        munit_assert_int(ret, ==, sizeof(int64_t));
+    }
+    // a large (bulk) write can be in flight as well
+    for (i = 0; i < 512; i++)
+        big[i] = -i;
+    ret = cachercise_io_async(rh, big, sizeof(big), 16, CACHERCISE_WRITE, &reqs[0]);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_wait(reqs[0]);
+    munit_assert_int(ret, ==, sizeof(big));
+    // read everything back the same way
+    for (i = 0; i < 16; i++) {
+        values[i] = -1;
+        ret = cachercise_io_async(rh, &values[i], sizeof(int64_t), i,
+                CACHERCISE_READ, &reqs[i]);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    }
+    for (i = 0; i < 16; i++) {
+        ret = cachercise_wait(reqs[i]);
+        munit_assert_int(ret, ==, sizeof(int64_t));
+        munit_assert_int64(values[i], ==, i + 200);
+    }
+    memset(big, 0, sizeof(big));
+    ret = cachercise_read(rh, big, sizeof(big), 16);
+    munit_assert_int(ret, ==, sizeof(big));
+    munit_assert_int64(big[511], ==, -511);
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_write_combining(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_client_t client, plain;
+    cachercise_cache_handle_t rh, prh;
+    cachercise_return_t ret;
+    int64_t i, value;
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_set_write_combining(client, 1024, 10);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, context->id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // a second client without combining sees only what was flushed
+    ret = cachercise_client_init(context->mid, &plain);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(plain,
+            context->addr, provider_id, context->id, &prh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // adjacent, overlapping and scattered writes, newest winning
+    for (i = 0; i < 40; i++) {
+        value = i + 300;
+        ret = cachercise_write(rh, &value, sizeof(value), i);
+        munit_assert_int(ret, ==, sizeof(value));
+    }
+    for (i = 10; i < 20; i++) {
+        value = -i;
+        ret = cachercise_write(rh, &value, sizeof(value), i);
+        munit_assert_int(ret, ==, sizeof(value));
+    }
+    for (i = 0; i < 8; i++) {
+        value = i + 1000;
+        ret = cachercise_write(rh, &value, sizeof(value), 100 + 3*i);
+        munit_assert_int(ret, ==, sizeof(value));
+    }
+    ret = cachercise_flush(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (i = 0; i < 40; i++) {
+        ret = cachercise_read(prh, &value, sizeof(value), i);
+        munit_assert_int(ret, ==, sizeof(value));
+        munit_assert_int64(value, ==, (i >= 10 && i < 20) ? -i : i + 300);
+    }
+    for (i = 0; i < 8; i++) {
+        ret = cachercise_read(prh, &value, sizeof(value), 100 + 3*i);
+        munit_assert_int(ret, ==, sizeof(value));
+        munit_assert_int64(value, ==, i + 1000);
+    }
+    // a read through the combining handle sees its own buffered writes
+    value = 77;
+    ret = cachercise_write(rh, &value, sizeof(value), 200);
+    munit_assert_int(ret, ==, sizeof(value));
+    value = 0;
+    ret = cachercise_read(rh, &value, sizeof(value), 200);
+    munit_assert_int(ret, ==, sizeof(value));
+    munit_assert_int64(value, ==, 77);
+    // left alone, buffered writes go out in the background
+    value = 88;
+    ret = cachercise_write(rh, &value, sizeof(value), 201);
+    munit_assert_int(ret, ==, sizeof(value));
+    margo_thread_sleep(context->mid, 100);
+    value = 0;
+    ret = cachercise_read(prh, &value, sizeof(value), 201);
+    munit_assert_int(ret, ==, sizeof(value));
+    munit_assert_int64(value, ==, 88);
+    // a write of part of an element is refused, not buffered as nothing
+    ret = cachercise_write(rh, &value, 4, 202);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_ARGS);
+    // many buffer-full flushes in a row still land oldest first
+    for (i = 0; i < 1000; i++) {
+        value = i;
+        ret = cachercise_write(rh, &value, sizeof(value), 300 + (i % 300));
+        munit_assert_int(ret, ==, sizeof(value));
+    }
+    ret = cachercise_flush(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (i = 0; i < 300; i++) {
+        ret = cachercise_read(prh, &value, sizeof(value), 300 + i);
+        munit_assert_int(ret, ==, sizeof(value));
+        munit_assert_int64(value, ==, i < 100 ? 900 + i : 600 + i);
+    }
+    // a flush that fails says so, for a contiguous run as for a batch
+    {
+        cachercise_cache_id_t sid;
+        cachercise_cache_handle_t sh;
+        int64_t run[32];
+        for (i = 0; i < 32; i++)
+            run[i] = i;
+        ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+                token, "slab", "{}", &sid);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        ret = cachercise_cache_handle_create(client,
+                context->addr, provider_id, sid, &sh);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        ret = cachercise_write(sh, run, sizeof(run), 0);
+        munit_assert_int(ret, ==, sizeof(run));
+        ret = cachercise_flush(sh);
+        munit_assert_int(ret, ==, CACHERCISE_ERR_OP_UNSUPPORTED);
+        ret = cachercise_write(sh, run, sizeof(int64_t), 100);
+        munit_assert_int(ret, ==, sizeof(int64_t));
+        ret = cachercise_flush(sh);
+        munit_assert_int(ret, ==, CACHERCISE_ERR_OP_UNSUPPORTED);
+        ret = cachercise_cache_handle_release(sh);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        ret = cachercise_destroy_cache(context->admin, context->addr,
+                provider_id, token, sid);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    }
+    ret = cachercise_cache_handle_release(prh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_finalize(plain);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_io_batch(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_return_t ret;
+    int64_t offsets[16], values[16];
+    int64_t i;
+    // test that we can create a client object
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // test that we can create a cache handle
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, context->id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // write a scattered batch (out of order, spread over stripes)
+    for (i = 0; i < 16; i++) {
+        offsets[i] = (i * 7) % 16 + 100;
+        values[i]  = offsets[i] * 2;
+    }
+    ret = cachercise_io_batch(rh, offsets, values, 16, CACHERCISE_WRITE);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // test that a batch read returns what was written
+    for (i = 0; i < 16; i++) {
+        offsets[i] = 115 - i;
+        values[i]  = -1;
+    }
+    ret = cachercise_io_batch(rh, offsets, values, 16, CACHERCISE_READ);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (i = 0; i < 16; i++)
+        munit_assert_int64(values[i], ==, offsets[i] * 2);
+    // test that a bad kind or offset fails the whole batch
+    ret = cachercise_io_batch(rh, offsets, values, 16, CACHERCISE_ERASE);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_ARGS);
+    offsets[3] = -1;
+    values[0]  = 12345;
+    ret = cachercise_io_batch(rh, offsets, values, 16, CACHERCISE_WRITE);
+    munit_assert_int(ret, !=, CACHERCISE_SUCCESS);
+    offsets[3] = 115 - 3;
+    ret = cachercise_io_batch(rh, offsets, values, 1, CACHERCISE_READ);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    munit_assert_int64(values[0], ==, offsets[0] * 2);
+    // test that we can destroy the cache handle
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // test that we can free the client object
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_atomic_io(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    int64_t i;
+    // sizes must be integers in range, and the directory has to fit
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "atomic", "{ \"capacity\" : \"64\" }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "atomic", "{ \"page_size\" : 1099511627776 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "atomic", "{ \"capacity\" : 9223372036854775807 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "atomic", "{ \"capacity\" : 1152921504606846976, "
+            "\"page_size\" : 1 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_ALLOCATION);
+    // create a cache backed by the lock-free "atomic" backend
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "atomic", "{ \"capacity\" : 64, \"page_size\" : 8 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // test that we can create a client object
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // test that we can create a cache handle
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // test that values written across several pages read back
+    for (i = 0; i < 32; i++) {
+        int64_t value = i * 3;
+        ret = cachercise_write(rh, &value, sizeof(value), i);
+        munit_assert_int(ret, ==, sizeof(value));
+    }
+    for (i = 0; i < 32; i++) {
+        int64_t value = -1;
+        ret = cachercise_read(rh, &value, sizeof(value), i);
+        munit_assert_int(ret, ==, sizeof(value));
+        munit_assert_int64(value, ==, i * 3);
+    }
+    // test that we can destroy the cache handle
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // test that we can free the client object
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // destroy the extra cache
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_atomic_ops(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    const char* backends[2] = { "dummy", "atomic" };
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    int64_t i, b, old, offsets[8], operands[8], olds[8];
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (b = 0; b < 2; b++) {
+        ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+                token, backends[b], "{ \"capacity\" : 64, \"page_size\" : 8 }", &id);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        ret = cachercise_cache_handle_create(client,
+                context->addr, provider_id, id, &rh);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        // a counter, starting from a never-written slot
+        for (i = 0; i < 5; i++) {
+            ret = cachercise_atomic(rh, CACHERCISE_ATOMIC_ADD, 20, 3, 0, &old);
+            munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+            munit_assert_int64(old, ==, i * 3);
+        }
+        // compare-and-swap only succeeds with the right expected value
+        ret = cachercise_atomic(rh, CACHERCISE_ATOMIC_CAS, 20, 100, 14, &old);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        munit_assert_int64(old, ==, 15);
+        ret = cachercise_atomic(rh, CACHERCISE_ATOMIC_CAS, 20, 100, 15, &old);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        munit_assert_int64(old, ==, 15);
+        ret = cachercise_atomic(rh, CACHERCISE_ATOMIC_MIN, 20, 40, 0, &old);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        munit_assert_int64(old, ==, 100);
+        ret = cachercise_atomic(rh, CACHERCISE_ATOMIC_MAX, 20, 7, 0, &old);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        munit_assert_int64(old, ==, 40);
+        ret = cachercise_atomic(rh, CACHERCISE_ATOMIC_SWAP, 20, -1, 0, &old);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        munit_assert_int64(old, ==, 40);
+        ret = cachercise_read(rh, &old, sizeof(old), 20);
+        munit_assert_int(ret, ==, sizeof(old));
+        munit_assert_int64(old, ==, -1);
+        // a batch hitting the same slot applies in order
+        for (i = 0; i < 8; i++) {
+            offsets[i] = i % 2 ? 30 : 31;
+            operands[i] = i + 1;
+        }
+        ret = cachercise_atomic_batch(rh, CACHERCISE_ATOMIC_ADD, offsets, operands,
+                NULL, olds, 8);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        munit_assert_int64(olds[6], ==, 1 + 3 + 5);
+        munit_assert_int64(olds[7], ==, 2 + 4 + 6);
+        // CAS needs expected values
+        ret = cachercise_atomic_batch(rh, CACHERCISE_ATOMIC_CAS, offsets, operands,
+                NULL, olds, 8);
+        munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_ARGS);
+        ret = cachercise_cache_handle_release(rh);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        ret = cachercise_destroy_cache(context->admin, context->addr,
+                provider_id, token, id);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    }
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_sync_strategies(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    const char* strategies[6] = {
+        "mutex", "rwlock", "brlock", "spinlock", "combining", "lockfree" };
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    cachercise_request_t reqs[64];
+    int64_t values[64], runs[21][3], back[63];
+    int64_t i, s, value;
+    char config[128];
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (s = 0; s < 6; s++) {
+        snprintf(config, sizeof(config), "{ \"stripes\" : 2, \"page_size\" : 16, "
+                "\"sync\" : \"%s\" }", strategies[s]);
+        ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+                token, "dummy", config, &id);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        ret = cachercise_cache_handle_create(client,
+                context->addr, provider_id, id, &rh);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        // writes in flight together, twice so that lock-free writes find
+        // their pages already there
+        for (i = 0; i < 128; i++) {
+            values[i % 64] = i * 7 + s;
+            ret = cachercise_io_async(rh, &values[i % 64], sizeof(int64_t), i % 64,
+                    CACHERCISE_WRITE, &reqs[i % 64]);
+            munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+            if (i % 64 == 63) {
+                int64_t j;
+                for (j = 0; j < 64; j++) {
+                    ret = cachercise_wait(reqs[j]);
+                    munit_assert_int(ret, ==, sizeof(int64_t));
+                }
+            }
+        }
+        for (i = 0; i < 64; i++) {
+            value = -1;
+            ret = cachercise_read(rh, &value, sizeof(value), i);
+            munit_assert_int(ret, ==, sizeof(value));
+            munit_assert_int64(value, ==, (i + 64) * 7 + s);
+        }
+        // multi-element writes, some across pages, again twice: a write
+        // of several elements must not be mistaken for one to retry
+        for (i = 0; i < 42; i++) {
+            int64_t r = i % 21;
+            runs[r][0] = runs[r][1] = runs[r][2] = i * 5 + s;
+            ret = cachercise_io_async(rh, runs[r], sizeof(runs[r]), r * 3,
+                    CACHERCISE_WRITE, &reqs[r]);
+            munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+            if (r == 20) {
+                int64_t j;
+                for (j = 0; j < 21; j++) {
+                    ret = cachercise_wait(reqs[j]);
+                    munit_assert_int(ret, ==, sizeof(runs[j]));
+                }
+            }
+        }
+        ret = cachercise_read(rh, back, sizeof(back), 0);
+        munit_assert_int(ret, ==, sizeof(back));
+        for (i = 0; i < 63; i++)
+            munit_assert_int64(back[i], ==, (i / 3 + 21) * 5 + s);
+        ret = cachercise_cache_handle_release(rh);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        ret = cachercise_destroy_cache(context->admin, context->addr,
+                provider_id, token, id);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    }
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_typed_caches(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    struct record { int64_t words[4]; } records[40], back[41];
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    double values[20], got[22];
+    int64_t i, k, old;
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    // doubles, across pages and stripes
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "dummy", "{ \"type\" : \"double\", \"stripes\" : 2, "
+            "\"stripe_size\" : 3, \"page_size\" : 4 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (i = 0; i < 20; i++)
+        values[i] = i * 0.25;
+    ret = cachercise_write(rh, values, sizeof(values), 5);
+    munit_assert_int(ret, ==, sizeof(values));
+    ret = cachercise_read(rh, got, sizeof(got), 4);
+    munit_assert_int(ret, ==, sizeof(got));
+    munit_assert_double(got[0], ==, 0.0);
+    munit_assert_double(got[21], ==, 0.0);
+    for (i = 0; i < 20; i++)
+        munit_assert_double(got[i + 1], ==, i * 0.25);
+    // atomic ops are for integers
+    ret = cachercise_atomic(rh, CACHERCISE_ATOMIC_ADD, 5, 1, 0, &old);
+    munit_assert_int(ret, !=, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    // 32-byte records, inline and then through bulk transfers
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "dummy", "{ \"type\" : \"record32\", \"page_size\" : 8 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (i = 0; i < 40; i++)
+        for (k = 0; k < 4; k++)
+            records[i].words[k] = i * 4 + k;
+    ret = cachercise_write(rh, records, 3 * sizeof(struct record), 1);
+    munit_assert_int(ret, ==, 3 * sizeof(struct record));
+    ret = cachercise_client_set_bulk_threshold(client, 0);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_write(rh, records + 3, 37 * sizeof(struct record), 4);
+    munit_assert_int(ret, ==, 37 * sizeof(struct record));
+    memset(back, 0xff, sizeof(back));
+    ret = cachercise_read(rh, back, sizeof(back), 0);
+    munit_assert_int(ret, ==, sizeof(back));
+    for (k = 0; k < 4; k++)
+        munit_assert_int64(back[0].words[k], ==, 0);
+    munit_assert_memory_equal(sizeof(records), back + 1, records);
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_sparse_io(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    const int64_t far = (int64_t)1 << 40;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    int64_t values[10], got[12], i;
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "dummy", "{ \"storage\" : \"sparse\", \"stripes\" : 2, "
+            "\"stripe_size\" : 3, \"page_size\" : 4 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    // near the start and 2^40 elements in, across pages and stripes
+    for (i = 0; i < 10; i++)
+        values[i] = i + 1;
+    ret = cachercise_write(rh, values, sizeof(values), 3);
+    munit_assert_int(ret, ==, sizeof(values));
+    for (i = 0; i < 10; i++)
+        values[i] = -(i + 1);
+    ret = cachercise_write(rh, values, sizeof(values), far - 5);
+    munit_assert_int(ret, ==, sizeof(values));
+
+    ret = cachercise_read(rh, got, sizeof(got), 2);
+    munit_assert_int(ret, ==, sizeof(got));
+    munit_assert_int64(got[0], ==, 0);
+    munit_assert_int64(got[11], ==, 0);
+    for (i = 0; i < 10; i++)
+        munit_assert_int64(got[i + 1], ==, i + 1);
+    ret = cachercise_read(rh, got, sizeof(got), far - 6);
+    munit_assert_int(ret, ==, sizeof(got));
+    munit_assert_int64(got[0], ==, 0);
+    munit_assert_int64(got[11], ==, 0);
+    for (i = 0; i < 10; i++)
+        munit_assert_int64(got[i + 1], ==, -(i + 1));
+    // untouched offsets in between read back as zero
+    ret = cachercise_read(rh, got, sizeof(got), far / 2);
+    munit_assert_int(ret, ==, sizeof(got));
+    for (i = 0; i < 12; i++)
+        munit_assert_int64(got[i], ==, 0);
+
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+/* what test_scan wrote at offset: i+1 from 3 on, -(i+1) from far-5 on */
+static int64_t scan_expected(int64_t offset, int64_t far)
+{
+    if (offset >= 3 && offset < 13)
+        return offset - 2;
+    if (offset >= far - 5 && offset < far + 5)
+        return -(offset - far + 6);
+    return 0;
+}
+
+static MunitResult test_scan(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    const int64_t far = (int64_t)1 << 40;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    cachercise_scan_t scan;
+    int64_t values[10], i, offset, next, cursor, seen;
+    const void* extent;
+    size_t size;
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "dummy", "{ \"storage\" : \"sparse\", \"stripes\" : 2, "
+            "\"stripe_size\" : 3, \"page_size\" : 4 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    for (i = 0; i < 10; i++)
+        values[i] = i + 1;
+    ret = cachercise_write(rh, values, sizeof(values), 3);
+    munit_assert_int(ret, ==, sizeof(values));
+    for (i = 0; i < 10; i++)
+        values[i] = -(i + 1);
+    ret = cachercise_write(rh, values, sizeof(values), far - 5);
+    munit_assert_int(ret, ==, sizeof(values));
+
+    // the whole range, in 64-byte chunks of one extent each
+    ret = cachercise_scan_open(rh, 0, 40, 0, 64, &scan);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    next = 0;
+    for (;;) {
+        ret = cachercise_scan_next(scan, &offset, &extent, &size);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        if (size == 0) break;
+        munit_assert_int64(offset, ==, next);
+        for (i = 0; i < (int64_t)(size / sizeof(int64_t)); i++)
+            munit_assert_int64(((const int64_t*)extent)[i], ==,
+                    scan_expected(offset + i, far));
+        next = offset + size / sizeof(int64_t);
+    }
+    munit_assert_int64(next, ==, 40);
+    ret = cachercise_scan_cursor(scan, &cursor);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    munit_assert_int64(cursor, ==, 40);
+    ret = cachercise_scan_close(scan);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    // only what was written, across 2^40 offsets, a few pages at a time
+    ret = cachercise_scan_open(rh, 0, 2 * far, CACHERCISE_SCAN_POPULATED, 64, &scan);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    next = 0;
+    seen = 0;
+    for (;;) {
+        ret = cachercise_scan_next(scan, &offset, &extent, &size);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        if (size == 0) break;
+        munit_assert_int64(offset, >=, next);
+        for (i = 0; i < (int64_t)(size / sizeof(int64_t)); i++) {
+            munit_assert_int64(((const int64_t*)extent)[i], ==,
+                    scan_expected(offset + i, far));
+            if (scan_expected(offset + i, far) != 0) seen++;
+        }
+        next = offset + size / sizeof(int64_t);
+        // pages are tracked, not elements, but nothing far from a write
+        munit_assert_int64(next - offset, <=, 8);
+    }
+    munit_assert_int64(seen, ==, 20);
+    ret = cachercise_scan_close(scan);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    // stopping after the first extent and resuming from the cursor
+    ret = cachercise_scan_open(rh, 0, 2 * far, CACHERCISE_SCAN_POPULATED, 64, &scan);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_scan_next(scan, &offset, &extent, &size);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    munit_assert_size(size, >, 0);
+    ret = cachercise_scan_cursor(scan, &cursor);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    munit_assert_int64(cursor, ==, offset + (int64_t)(size / sizeof(int64_t)));
+    ret = cachercise_scan_close(scan);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_scan_open(rh, cursor, 2 * far, CACHERCISE_SCAN_POPULATED, 0, &scan);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (;;) {
+        ret = cachercise_scan_next(scan, &offset, &extent, &size);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        if (size == 0) break;
+        munit_assert_int64(offset, >=, cursor);
+        cursor = offset + size / sizeof(int64_t);
+    }
+    munit_assert_int64(cursor, >=, far + 5);
+    ret = cachercise_scan_close(scan);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    // bad ranges and chunks with no room for an extent
+    ret = cachercise_scan_open(rh, 10, 5, 0, 0, &scan);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_ARGS);
+    ret = cachercise_scan_open(rh, 0, 10, 0, 16, &scan);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_scan_next(scan, &offset, &extent, &size);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_ARGS);
+    ret = cachercise_scan_close(scan);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_slab_blobs(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    static const size_t sizes[] = { 0, 10, 100, 5000, 1 << 20 };
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh, dh;
+    cachercise_cache_id_t id, did;
+    cachercise_return_t ret;
+    char *value, *back;
+    int64_t x = 1;
+    size_t i, len;
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // shard counts have to be integers, and not absurd ones
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "slab", "{ \"shards\" : \"4\" }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "slab", "{ \"shards\" : 2.5 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "slab", "{ \"shards\" : 4294967296 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "slab", "{ \"shards\" : 4 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    value = malloc(1 << 20);
+    back  = malloc(1 << 20);
+    for (i = 0; i < (1 << 20); i++)
+        value[i] = (char)(i * 7 + 3);
+
+    // one key per size class, read back whole
+    for (i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+        ret = cachercise_blob_put(rh, 100 + i, value + i, sizes[i]);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    }
+    for (i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+        len = 12345;
+        ret = cachercise_blob_get(rh, 100 + i, back, 1 << 20, &len);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        munit_assert_size(len, ==, sizes[i]);
+        munit_assert_memory_equal(sizes[i], back, value + i);
+    }
+
+    // overwrite with a value of another class
+    ret = cachercise_blob_put(rh, 102, value + 50, 3000);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_blob_get(rh, 102, back, 1 << 20, &len);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    munit_assert_size(len, ==, 3000);
+    munit_assert_memory_equal(3000, back, value + 50);
+
+    // too little room still reports the whole length
+    memset(back, 0, 16);
+    ret = cachercise_blob_get(rh, 103, back, 16, &len);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    munit_assert_size(len, ==, 5000);
+    munit_assert_memory_equal(16, back, value + 3);
+    ret = cachercise_blob_get(rh, 103, NULL, 0, &len);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    munit_assert_size(len, ==, 5000);
+
+    // erase, then the key is gone
+    ret = cachercise_blob_erase(rh, 103);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_blob_get(rh, 103, back, 1 << 20, &len);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_NOT_FOUND);
+    ret = cachercise_blob_erase(rh, 103);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_NOT_FOUND);
+    ret = cachercise_blob_get(rh, 999, back, 1 << 20, &len);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_NOT_FOUND);
+
+    // slab caches have no element array, dummy caches have no blobs
+    ret = cachercise_write(rh, &x, sizeof(x), 0);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_OP_UNSUPPORTED);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "dummy", backend_config, &did);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, did, &dh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_blob_put(dh, 1, value, 10);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_OP_UNSUPPORTED);
+    ret = cachercise_cache_handle_release(dh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id, token, did);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    free(value);
+    free(back);
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_kv(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    const char* names[] = { "alpha", "beta", "gamma/delta", "", "missing" };
+    const char* vals[]  = { "one", "", "three three three", "four" };
+    const void* keys[5];
+    const void* values[4];
+    size_t key_sizes[5], value_sizes[5], capacities[5], len;
+    char bufs[5][32], back[32];
+    void* outs[5];
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    int64_t x = 1;
+    size_t i;
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // shard counts have to be integers, and not absurd ones
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "kv", "{ \"shards\" : \"4\" }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "kv", "{ \"shards\" : 2.5 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "kv", "{ \"shards\" : 4294967296 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "kv", "{ \"shards\" : 2 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    // one at a time, overwriting with a longer value
+    ret = cachercise_kv_put(rh, "alpha", 5, "1", 1);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_kv_put(rh, "alpha", 5, "one", 3);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_kv_get(rh, "alpha", 5, back, sizeof(back), &len);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    munit_assert_size(len, ==, 3);
+    munit_assert_memory_equal(3, back, "one");
+    ret = cachercise_kv_get(rh, "alph", 4, back, sizeof(back), &len);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_NOT_FOUND);
+
+    // a batch of puts, then a batch of gets with one key absent
+    for (i = 0; i < 5; i++) {
+        keys[i]      = names[i];
+        key_sizes[i] = strlen(names[i]);
+        outs[i]      = bufs[i];
+        capacities[i] = sizeof(bufs[i]);
+    }
+    for (i = 0; i < 4; i++) {
+        values[i]      = vals[i];
+        value_sizes[i] = strlen(vals[i]);
+    }
+    ret = cachercise_kv_put_multi(rh, 4, keys, key_sizes, values, value_sizes);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    capacities[2] = 5; // too little room still reports the whole length
+    ret = cachercise_kv_get_multi(rh, 5, keys, key_sizes, outs, capacities, value_sizes);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (i = 0; i < 4; i++) {
+        munit_assert_size(value_sizes[i], ==, strlen(vals[i]));
+        munit_assert_memory_equal(i == 2 ? 5 : value_sizes[i], bufs[i], vals[i]);
+    }
+    munit_assert_size(value_sizes[4], ==, CACHERCISE_KV_ABSENT);
+
+    // erase
+    ret = cachercise_kv_erase(rh, "beta", 4);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_kv_erase(rh, "beta", 4);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_NOT_FOUND);
+    ret = cachercise_kv_get(rh, "beta", 4, back, sizeof(back), &len);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_NOT_FOUND);
+    ret = cachercise_kv_get(rh, "", 0, back, sizeof(back), &len);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    munit_assert_size(len, ==, 4);
+
+    // no element array, no integer keys
+    ret = cachercise_write(rh, &x, sizeof(x), 0);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_OP_UNSUPPORTED);
+    ret = cachercise_blob_put(rh, 1, &x, sizeof(x));
+    munit_assert_int(ret, ==, CACHERCISE_ERR_OP_UNSUPPORTED);
+
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_sharded_io(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    int64_t i, values[40], offsets[40];
+    // shards all share the primary pool here, which is enough to exercise
+    // the routing
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "dummy", "{ \"shard_pools\" : [ \"__primary__\", \"__primary__\", "
+            "\"__primary__\" ], \"stripe_size\" : 2, \"page_size\" : 4 }", &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // one write spanning every shard, then single values over part of it
+    for (i = 0; i < 40; i++)
+        values[i] = i + 500;
+    ret = cachercise_write(rh, values, sizeof(values), 0);
+    munit_assert_int(ret, ==, sizeof(values));
+    for (i = 0; i < 10; i++) {
+        int64_t value = -i;
+        ret = cachercise_write(rh, &value, sizeof(value), 3*i);
+        munit_assert_int(ret, ==, sizeof(value));
+    }
+    // a batch goes through the shards too
+    for (i = 0; i < 40; i++) {
+        offsets[i] = 100 + 7*i;
+        values[i] = i;
+    }
+    ret = cachercise_io_batch(rh, offsets, values, 40, CACHERCISE_WRITE);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    memset(values, 0, sizeof(values));
+    ret = cachercise_read(rh, values, sizeof(values), 0);
+    munit_assert_int(ret, ==, sizeof(values));
+    for (i = 0; i < 40; i++)
+        munit_assert_int64(values[i], ==, (i % 3 == 0 && i < 30) ? -i/3 : i + 500);
+    ret = cachercise_io_batch(rh, offsets, values, 40, CACHERCISE_READ);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (i = 0; i < 40; i++)
+        munit_assert_int64(values[i], ==, i);
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_distributed(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_client_t client;
+    cachercise_cache_handle_t members[2];
+    cachercise_dist_handle_t dh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    int64_t i, value, values[64], offsets[64];
+    // spread over the test cache and a second one
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "dummy", backend_config, &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, context->id, &members[0]);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, id, &members[1]);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_dist_handle_create(members, 2, 4, &dh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // the distributed handle holds its own references
+    ret = cachercise_cache_handle_release(members[1]);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // a range spanning many blocks, split over both members
+    for (i = 0; i < 64; i++)
+        values[i] = i + 700;
+    ret = cachercise_dist_io(dh, values, sizeof(values), 3, CACHERCISE_WRITE);
+    munit_assert_int(ret, ==, sizeof(values));
+    // offset 5 is in block 1, i.e. the second member at local offset 1
+    value = -1;
+    ret = cachercise_read(members[0], &value, sizeof(value), 1);
+    munit_assert_int(ret, ==, sizeof(value));
+    munit_assert_int64(value, !=, 702);
+    ret = cachercise_dist_io(dh, &value, sizeof(value), 5, CACHERCISE_READ);
+    munit_assert_int(ret, ==, sizeof(value));
+    munit_assert_int64(value, ==, 702);
+    // a scattered batch comes back in the caller's order
+    for (i = 0; i < 64; i++) {
+        offsets[i] = 63 + 3 - i;
+        values[i] = -1;
+    }
+    ret = cachercise_dist_io_batch(dh, offsets, values, 64, CACHERCISE_READ);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (i = 0; i < 64; i++)
+        munit_assert_int64(values[i], ==, offsets[i] - 3 + 700);
+    for (i = 0; i < 64; i++)
+        values[i] = -offsets[i];
+    ret = cachercise_dist_io_batch(dh, offsets, values, 64, CACHERCISE_WRITE);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    memset(values, 0, sizeof(values));
+    ret = cachercise_dist_io(dh, values, sizeof(values), 3, CACHERCISE_READ);
+    munit_assert_int(ret, ==, sizeof(values));
+    for (i = 0; i < 64; i++)
+        munit_assert_int64(values[i], ==, -(i + 3));
+    // negative offsets are refused, an empty batch is a no-op
+    ret = cachercise_dist_io(dh, &value, sizeof(value), -1, CACHERCISE_READ);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_ARGS);
+    offsets[7] = -4;
+    ret = cachercise_dist_io_batch(dh, offsets, values, 64, CACHERCISE_READ);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_ARGS);
+    ret = cachercise_dist_io_batch(dh, offsets, values, 0, CACHERCISE_READ);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_dist_handle_release(dh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // a member that fails its share fails the whole io
+    {
+        cachercise_cache_id_t sid;
+        cachercise_cache_handle_t mixed[2];
+        ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+                token, "slab", "{}", &sid);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        mixed[0] = members[0];
+        ret = cachercise_cache_handle_create(client,
+                context->addr, provider_id, sid, &mixed[1]);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        ret = cachercise_dist_handle_create(mixed, 2, 4, &dh);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        ret = cachercise_dist_io(dh, values, sizeof(values), 0, CACHERCISE_WRITE);
+        munit_assert_int(ret, ==, CACHERCISE_ERR_OP_UNSUPPORTED);
+        ret = cachercise_dist_handle_release(dh);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        ret = cachercise_cache_handle_release(mixed[1]);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        ret = cachercise_destroy_cache(context->admin, context->addr,
+                provider_id, token, sid);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    }
+    // 4-byte elements: blocks are cut by elements, not by 8 bytes
+    {
+        cachercise_cache_id_t fids[2];
+        cachercise_cache_handle_t fmembers[2];
+        float floats[20], f;
+        int64_t local;
+        for (i = 0; i < 2; i++) {
+            ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+                    token, "dummy", "{ \"type\" : \"float32\" }", &fids[i]);
+            munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+            ret = cachercise_cache_handle_create(client,
+                    context->addr, provider_id, fids[i], &fmembers[i]);
+            munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        }
+        ret = cachercise_dist_handle_create_typed(fmembers, 2, 4, sizeof(float), &dh);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        for (i = 0; i < 20; i++)
+            floats[i] = i + 0.5f;
+        ret = cachercise_dist_io(dh, floats, sizeof(floats), 3, CACHERCISE_WRITE);
+        munit_assert_int(ret, ==, sizeof(floats));
+        ret = cachercise_dist_io(dh, floats, 6, 3, CACHERCISE_WRITE);
+        munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_ARGS);
+        for (i = 0; i < 20; i++) {
+            cachercise_cache_handle_t member;
+            ret = cachercise_dist_locate(dh, 3 + i, &member, &local);
+            munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+            f = -1;
+            ret = cachercise_read(member, &f, sizeof(f), local);
+            munit_assert_int(ret, ==, sizeof(f));
+            munit_assert_float(f, ==, i + 0.5f);
+        }
+        ret = cachercise_dist_handle_release(dh);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        for (i = 0; i < 2; i++) {
+            ret = cachercise_cache_handle_release(fmembers[i]);
+            munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+            ret = cachercise_destroy_cache(context->admin, context->addr,
+                    provider_id, token, fids[i]);
+            munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+        }
+    }
+    ret = cachercise_cache_handle_release(members[0]);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_snapshot(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_provider_t provider;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    int64_t i, values[100];
+    char config[256];
+    // snapshots go through abt-io, so use a provider that has an instance
+    abt_io_instance_id abtio = abt_io_init(1);
+    munit_assert_not_null(abtio);
+    struct cachercise_provider_args args = CACHERCISE_PROVIDER_ARGS_INIT;
+    args.token = token;
+    args.abtio = abtio;
+    ret = cachercise_provider_register(context->mid, provider_id + 1, &args, &provider);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    snprintf(config, sizeof(config), "{ \"stripes\" : 3, \"page_size\" : 8, "
+            "\"snapshot\" : \"/tmp/cachercise-test-%d.snap\" }", (int)getpid());
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id + 1,
+            token, "dummy", config, &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id + 1, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (i = 0; i < 100; i++)
+        values[i] = i * 11;
+    ret = cachercise_write(rh, values, sizeof(values), 1000);
+    munit_assert_int(ret, ==, sizeof(values));
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // closing writes the snapshot, opening brings the data back
+    ret = cachercise_close_cache(context->admin, context->addr, provider_id + 1, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_open_cache(context->admin, context->addr, provider_id + 1,
+            token, "dummy", config, &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id + 1, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    memset(values, 0, sizeof(values));
+    ret = cachercise_read(rh, values, sizeof(values), 1000);
+    munit_assert_int(ret, ==, sizeof(values));
+    for (i = 0; i < 100; i++)
+        munit_assert_int64(values[i], ==, i * 11);
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // destroying the cache removes its snapshot
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id + 1, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    cachercise_provider_destroy(provider);
+    abt_io_finalize(abtio);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_durable(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_provider_t provider;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_request_t reqs[8];
+    cachercise_return_t ret;
+    int64_t i, values[8][16];
+    char config[256];
+    // the log is written through abt-io
+    abt_io_instance_id abtio = abt_io_init(1);
+    munit_assert_not_null(abtio);
+    struct cachercise_provider_args args = CACHERCISE_PROVIDER_ARGS_INIT;
+    args.token = token;
+    args.abtio = abtio;
+    ret = cachercise_provider_register(context->mid, provider_id + 1, &args, &provider);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    snprintf(config, sizeof(config), "{ \"stripes\" : 2, \"durable\" : true, "
+            "\"wal\" : \"/tmp/cachercise-test-%d.wal\" }", (int)getpid());
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id + 1,
+            token, "dummy", config, &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id + 1, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // concurrent writes share group commits
+    for (i = 0; i < 8; i++) {
+        int64_t j;
+        for (j = 0; j < 16; j++)
+            values[i][j] = i * 100 + j;
+        ret = cachercise_io_async(rh, values[i], sizeof(values[i]), i * 16,
+                CACHERCISE_WRITE, &reqs[i]);
+        munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    }
+    for (i = 0; i < 8; i++) {
+        ret = cachercise_wait(reqs[i]);
+        munit_assert_int(ret, ==, sizeof(values[i]));
+    }
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // there is no snapshot, so reopening replays the log
+    ret = cachercise_close_cache(context->admin, context->addr, provider_id + 1, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_open_cache(context->admin, context->addr, provider_id + 1,
+            token, "dummy", config, &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id + 1, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    memset(values, 0, sizeof(values));
+    ret = cachercise_read(rh, values, sizeof(values), 0);
+    munit_assert_int(ret, ==, sizeof(values));
+    for (i = 0; i < 8 * 16; i++)
+        munit_assert_int64(values[i / 16][i % 16], ==, (i / 16) * 100 + i % 16);
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id + 1, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    cachercise_provider_destroy(provider);
+    abt_io_finalize(abtio);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_spill(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_provider_t provider;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    int64_t i, round, values[256];
+    char config[256];
+    // pages are spilled through abt-io
+    abt_io_instance_id abtio = abt_io_init(1);
+    munit_assert_not_null(abtio);
+    struct cachercise_provider_args args = CACHERCISE_PROVIDER_ARGS_INIT;
+    args.token = token;
+    args.abtio = abtio;
+    ret = cachercise_provider_register(context->mid, provider_id + 1, &args, &provider);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // 16 pages of 64 bytes may stay in memory, out of 512 written
+    snprintf(config, sizeof(config), "{ \"stripes\" : 2, \"page_size\" : 8, "
+            "\"memory_limit\" : 1024, "
+            "\"spill\" : \"/tmp/cachercise-test-%d.spill\" }", (int)getpid());
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id + 1,
+            token, "dummy", config, &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id + 1, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (round = 0; round < 16; round++) {
+        for (i = 0; i < 256; i++)
+            values[i] = round * 256 + i;
+        ret = cachercise_write(rh, values, sizeof(values), round * 256);
+        munit_assert_int(ret, ==, sizeof(values));
+    }
+    // give the evictor time to push most of it out
+    margo_thread_sleep(context->mid, 300);
+    // evicted pages come back transparently, in any order
+    for (round = 15; round >= 0; round--) {
+        memset(values, 0, sizeof(values));
+        ret = cachercise_read(rh, values, sizeof(values), round * 256);
+        munit_assert_int(ret, ==, sizeof(values));
+        for (i = 0; i < 256; i++)
+            munit_assert_int64(values[i], ==, round * 256 + i);
+    }
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id + 1, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    cachercise_provider_destroy(provider);
+    abt_io_finalize(abtio);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_mmap_io(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    struct test_context* context = (struct test_context*)data;
+    cachercise_client_t client;
+    cachercise_cache_handle_t rh;
+    cachercise_cache_id_t id;
+    cachercise_return_t ret;
+    int64_t i, values[100];
+    char config[256], path[64];
+    snprintf(path, sizeof(path), "/tmp/cachercise-test-%d.map", (int)getpid());
+    // capacities whose mapping would not fit, or that are not integers
+    snprintf(config, sizeof(config), "{ \"capacity\" : 2305843009213693951, "
+            "\"path\" : \"%s\" }", path);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "mmap", config, &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    snprintf(config, sizeof(config), "{ \"capacity\" : \"4096\", "
+            "\"path\" : \"%s\" }", path);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "mmap", config, &id);
+    munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    // a header claiming more than the file holds
+    {
+        char header[4096] = "CACHMAP1";
+        uint64_t huge = (uint64_t)1 << 40;
+        memcpy(header + 8, &huge, sizeof(huge));
+        FILE* f = fopen(path, "w");
+        munit_assert_not_null(f);
+        munit_assert_size(fwrite(header, 1, sizeof(header), f), ==, sizeof(header));
+        fclose(f);
+        snprintf(config, sizeof(config), "{ \"capacity\" : 4096, "
+                "\"path\" : \"%s\" }", path);
+        ret = cachercise_open_cache(context->admin, context->addr, provider_id,
+                token, "mmap", config, &id);
+        munit_assert_int(ret, ==, CACHERCISE_ERR_INVALID_CONFIG);
+    }
+    snprintf(config, sizeof(config), "{ \"capacity\" : 4096, "
+            "\"path\" : \"%s\" }", path);
+    ret = cachercise_create_cache(context->admin, context->addr, provider_id,
+            token, "mmap", config, &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_init(context->mid, &client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    for (i = 0; i < 100; i++)
+        values[i] = i * 13;
+    ret = cachercise_write(rh, values, sizeof(values), 1000);
+    munit_assert_int(ret, ==, sizeof(values));
+    // past the end of the file
+    ret = cachercise_write(rh, values, sizeof(values), 4000);
+    munit_assert_int(ret, <, 0);
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    // reopening maps the same file, so the data is there right away
+    ret = cachercise_close_cache(context->admin, context->addr, provider_id, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_open_cache(context->admin, context->addr, provider_id,
+            token, "mmap", config, &id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_cache_handle_create(client,
+            context->addr, provider_id, id, &rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    memset(values, 0, sizeof(values));
+    ret = cachercise_read(rh, values, sizeof(values), 1000);
+    munit_assert_int(ret, ==, sizeof(values));
+    for (i = 0; i < 100; i++)
+        munit_assert_int64(values[i], ==, i * 13);
+    ret = cachercise_cache_handle_release(rh);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_client_finalize(client);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+    ret = cachercise_destroy_cache(context->admin, context->addr,
+            provider_id, token, id);
+    munit_assert_int(ret, ==, CACHERCISE_SUCCESS);
+
+    return MUNIT_OK;
+}
+
 static MunitResult test_invalid(const MunitParameter params[], void* data)
 {
     (void)params;
@@ -231,6 +1734,25 @@ static MunitTest test_suite_tests[] = {
     { (char*) "/cache", test_cache, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
     { (char*) "/hello",    test_hello,    test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
     { (char*) "/sum",      test_sum,      test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/io",       test_io,       test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/io-bulk",  test_io_bulk,  test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/io-async", test_io_async, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/write-combining", test_write_combining, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/io-batch", test_io_batch, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/atomic-io", test_atomic_io, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/atomic-ops", test_atomic_ops, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/sync-strategies", test_sync_strategies, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/typed-caches", test_typed_caches, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/sparse-io", test_sparse_io, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/scan", test_scan, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/slab-blobs", test_slab_blobs, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/kv", test_kv, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/sharded-io", test_sharded_io, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/distributed", test_distributed, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/snapshot", test_snapshot, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/durable", test_durable, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/spill", test_spill, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/mmap-io", test_mmap_io, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
     { (char*) "/invalid",  test_invalid,  test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
     { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
 };
@@ -0,0 +1,291 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <atomic>
+#include <abt.h>
+#include "munit/munit.h"
+#include "hoard.hpp"
+
+/* These tests drive the Hoard directly, from ULTs spread over several
+ * xstreams, the way provider ULTs use it: puts serialized by a mutex,
+ * gets from anywhere without one. */
+
+#define NUM_XSTREAMS 4
+
+struct test_context {
+    ABT_xstream xstreams[NUM_XSTREAMS];
+    ABT_pool    pools[NUM_XSTREAMS];
+};
+
+static void* test_context_setup(const MunitParameter params[], void* user_data)
+{
+    (void) params;
+    (void) user_data;
+    int ret = ABT_init(0, NULL);
+    munit_assert_int(ret, ==, ABT_SUCCESS);
+    struct test_context* context = (struct test_context*)calloc(1, sizeof(*context));
+    munit_assert_not_null(context);
+    for (int i = 0; i < NUM_XSTREAMS; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &context->xstreams[i]);
+        munit_assert_int(ret, ==, ABT_SUCCESS);
+        ret = ABT_xstream_get_main_pools(context->xstreams[i], 1, &context->pools[i]);
+        munit_assert_int(ret, ==, ABT_SUCCESS);
+    }
+    return context;
+}
+
+static void test_context_tear_down(void* fixture)
+{
+    struct test_context* context = (struct test_context*)fixture;
+    for (int i = 0; i < NUM_XSTREAMS; i++) {
+        ABT_xstream_join(context->xstreams[i]);
+        ABT_xstream_free(&context->xstreams[i]);
+    }
+    free(context);
+    ABT_finalize();
+}
+
+/* runs fn(args[i]) on xstream i for every i below n, and waits for all */
+static void run_ults(struct test_context* context, int n,
+        void (*fn)(void*), void** args)
+{
+    ABT_thread threads[NUM_XSTREAMS];
+    int ret;
+    munit_assert_int(n, <=, NUM_XSTREAMS);
+    for (int i = 0; i < n; i++) {
+        ret = ABT_thread_create(context->pools[i], fn, args[i],
+                ABT_THREAD_ATTR_NULL, &threads[i]);
+        munit_assert_int(ret, ==, ABT_SUCCESS);
+    }
+    for (int i = 0; i < n; i++) {
+        ABT_thread_join(threads[i]);
+        ABT_thread_free(&threads[i]);
+    }
+}
+
+struct tracked {
+    int* freed;
+};
+
+static void free_tracked(void* p)
+{
+    struct tracked* t = static_cast<struct tracked*>(p);
+    (*t->freed)++;
+    delete t;
+}
+
+/* offsets below written have been put, with value offset + 1 */
+struct grow_args {
+    Hoard<int64_t>*       hoard;
+    std::atomic<size_t>*  written;
+    std::atomic<bool>*    done;
+    size_t                size;
+    unsigned              seed;
+    int                   failures;
+};
+
+static void grow_writer(void* arg)
+{
+    struct grow_args* a = (struct grow_args*)arg;
+    int64_t values[7];
+    /* short puts, so the directory doubles again and again under the
+     * readers' feet */
+    for (size_t offset = 0; offset < a->size; offset += 7) {
+        for (size_t i = 0; i < 7; i++)
+            values[i] = offset + i + 1;
+        a->hoard->put(values, 7, offset);
+        a->written->store(offset + 7, std::memory_order_release);
+    }
+    a->done->store(true, std::memory_order_release);
+}
+
+static void grow_reader(void* arg)
+{
+    struct grow_args* a = (struct grow_args*)arg;
+    int64_t values[16];
+    while (!a->done->load(std::memory_order_acquire)) {
+        size_t written = a->written->load(std::memory_order_acquire);
+        if (written < 16) continue;
+        size_t offset = rand_r(&a->seed) % (written - 15);
+        a->hoard->get(values, 16, offset);
+        for (size_t i = 0; i < 16; i++)
+            if (values[i] != (int64_t)(offset + i + 1))
+                a->failures++;
+    }
+}
+
+static MunitResult test_epoch_reclaim(const MunitParameter params[], void* data)
+{
+    (void)params;
+    struct test_context* context = (struct test_context*)data;
+
+    // nothing retired is freed while a guard taken before it is held
+    {
+        int held = 0, others = 0, retired = 0;
+        EpochDomain* domain = new EpochDomain;
+        {
+            EpochDomain::Guard guard(*domain);
+            domain->retire(new tracked{&held}, free_tracked);
+            for (int i = 0; i < 10; i++, retired++)
+                domain->retire(new tracked{&others}, free_tracked);
+            munit_assert_int(held, ==, 0);
+        }
+        // once it is gone, a couple of epochs are enough
+        for (int i = 0; i < 3 && held == 0; i++, retired++)
+            domain->retire(new tracked{&others}, free_tracked);
+        munit_assert_int(held, ==, 1);
+        delete domain;
+        munit_assert_int(others, ==, retired);
+    }
+
+    // old directories stay readable while gets still look at them
+    {
+        Hoard<int64_t> hoard(4);
+        std::atomic<size_t> written(0);
+        std::atomic<bool> done(false);
+        struct grow_args args[NUM_XSTREAMS];
+        void* ptrs[NUM_XSTREAMS];
+        for (int i = 0; i < NUM_XSTREAMS; i++) {
+            args[i] = grow_args{&hoard, &written, &done, 1 << 18, (unsigned)i, 0};
+            ptrs[i] = &args[i];
+        }
+        // the writer gets the last xstream to itself, the readers the others
+        ABT_thread writer;
+        int ret = ABT_thread_create(context->pools[NUM_XSTREAMS - 1], grow_writer, &args[0],
+                ABT_THREAD_ATTR_NULL, &writer);
+        munit_assert_int(ret, ==, ABT_SUCCESS);
+        run_ults(context, NUM_XSTREAMS - 1, grow_reader, ptrs + 1);
+        ABT_thread_join(writer);
+        ABT_thread_free(&writer);
+        for (int i = 1; i < NUM_XSTREAMS; i++)
+            munit_assert_int(args[i].failures, ==, 0);
+    }
+
+    return MUNIT_OK;
+}
+
+/* windows of WINDOW elements, straddling page boundaries, each written
+ * as a whole with one value */
+#define WINDOW      13
+#define NUM_WINDOWS 64
+
+struct torn_args {
+    Hoard<int64_t>*   hoard;
+    ABT_mutex         mutex;
+    std::atomic<int>* writing;
+    unsigned          seed;
+    int               failures;
+};
+
+static void torn_writer(void* arg)
+{
+    struct torn_args* a = (struct torn_args*)arg;
+    int64_t values[WINDOW];
+    for (int n = 0; n < 20000; n++) {
+        size_t w = rand_r(&a->seed) % NUM_WINDOWS;
+        int64_t value = (int64_t)rand_r(&a->seed) + 1;
+        for (size_t i = 0; i < WINDOW; i++)
+            values[i] = value;
+        ABT_mutex_lock(a->mutex);
+        a->hoard->put(values, WINDOW, w * WINDOW);
+        ABT_mutex_unlock(a->mutex);
+    }
+    a->writing->fetch_sub(1, std::memory_order_release);
+}
+
+static void torn_reader(void* arg)
+{
+    struct torn_args* a = (struct torn_args*)arg;
+    int64_t values[WINDOW];
+    while (a->writing->load(std::memory_order_acquire) > 0) {
+        size_t w = rand_r(&a->seed) % NUM_WINDOWS;
+        a->hoard->get(values, WINDOW, w * WINDOW);
+        for (size_t i = 1; i < WINDOW; i++)
+            if (values[i] != values[0]) {
+                a->failures++;
+                break;
+            }
+    }
+}
+
+static MunitResult test_torn_reads(const MunitParameter params[], void* data)
+{
+    (void)params;
+    struct test_context* context = (struct test_context*)data;
+    // pages of 4 elements, so every window covers 4 or 5 of them
+    Hoard<int64_t> hoard(4);
+    ABT_mutex mutex;
+    int ret = ABT_mutex_create(&mutex);
+    munit_assert_int(ret, ==, ABT_SUCCESS);
+    std::atomic<int> writing(NUM_XSTREAMS / 2);
+    struct torn_args args[NUM_XSTREAMS];
+    ABT_thread threads[NUM_XSTREAMS];
+    // one ULT per xstream: writers on the first half, readers on the rest
+    for (int i = 0; i < NUM_XSTREAMS; i++) {
+        args[i] = torn_args{&hoard, mutex, &writing, (unsigned)i, 0};
+        ret = ABT_thread_create(context->pools[i],
+                i < NUM_XSTREAMS / 2 ? torn_writer : torn_reader, &args[i],
+                ABT_THREAD_ATTR_NULL, &threads[i]);
+        munit_assert_int(ret, ==, ABT_SUCCESS);
+    }
+    for (int i = 0; i < NUM_XSTREAMS; i++) {
+        ABT_thread_join(threads[i]);
+        ABT_thread_free(&threads[i]);
+    }
+    ABT_mutex_free(&mutex);
+    for (int i = NUM_XSTREAMS / 2; i < NUM_XSTREAMS; i++)
+        munit_assert_int(args[i].failures, ==, 0);
+    return MUNIT_OK;
+}
+
+static MunitResult test_try_put(const MunitParameter params[], void* data)
+{
+    (void)params;
+    (void)data;
+    Hoard<int64_t> hoard(4);
+    int64_t values[10], back[10];
+    for (int i = 0; i < 10; i++)
+        values[i] = i + 1;
+
+    // pages not there yet: nothing written, the caller has to lock
+    munit_assert_int(hoard.try_put(values, 1, 0), ==, Hoard<int64_t>::RETRY);
+    munit_assert_int(hoard.try_put(values, 10, 0), ==, Hoard<int64_t>::RETRY);
+    munit_assert_int(hoard.get(back, 10, 0), ==, 10);
+    for (int i = 0; i < 10; i++)
+        munit_assert_int64(back[i], ==, 0);
+
+    // once they are, single and multi-element writes go through unlocked
+    munit_assert_int(hoard.put(values, 10, 0), ==, 10);
+    for (int i = 0; i < 10; i++)
+        values[i] = -(i + 1);
+    munit_assert_int(hoard.try_put(values, 1, 0), ==, 1);
+    munit_assert_int(hoard.try_put(values + 1, 2, 1), ==, 2);
+    munit_assert_int(hoard.try_put(values + 3, 7, 3), ==, 7);
+    munit_assert_int(hoard.get(back, 10, 0), ==, 10);
+    for (int i = 0; i < 10; i++)
+        munit_assert_int64(back[i], ==, -(i + 1));
+
+    // a range reaching past the last page still needs the lock
+    munit_assert_int(hoard.try_put(values, 10, 8), ==, Hoard<int64_t>::RETRY);
+    munit_assert_int(hoard.get(back, 2, 8), ==, 2);
+    munit_assert_int64(back[0], ==, -9);
+    munit_assert_int64(back[1], ==, -10);
+    return MUNIT_OK;
+}
+
+static MunitTest test_suite_tests[] = {
+    { (char*) "/epoch-reclaim", test_epoch_reclaim, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/torn-reads", test_torn_reads, test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE, NULL },
+    { (char*) "/try-put", test_try_put, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL },
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
+
+static const MunitSuite test_suite = {
+    (char*) "/cachercise/hoard", test_suite_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
+    return munit_suite_main(&test_suite, (void*) "cachercise", argc, argv);
+}